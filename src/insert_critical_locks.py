@@ -1,14 +1,12 @@
 #!/usr/bin/python
 import os
+import re
 import sys
 
-if len(sys.argv) != 3:
-    print('usage: python insert_critical_locks.py start end')
+if len(sys.argv) != 1:
+    print('usage: python insert_critical_locks.py < input > output')
     sys.exit(1)
 
-start = int(sys.argv[1])
-stop = int(sys.argv[2])
-
 expected_header = ['#include "hclib.h"',
                    '#ifdef __cplusplus',
                    '#include "hclib_cpp.h"',
@@ -20,19 +18,52 @@ expected_header = ['#include "hclib.h"',
                    '#endif',
                    'extern void hclib_pragma_marker(const char *pragma_name, const char *pragma_arguments, const char *lbl);']
 
+# Critical sections spin briefly on their lock and then yield to the HClib
+# runtime, so that a waiting worker keeps executing other tasks instead of
+# blocking in the kernel. A worker that already holds a critical lock never
+# yields, since a task it picks up could wait on that lock while the holder is
+# suspended underneath it. ____critical_held counts the locks held by the
+# current worker.
+lock_functions = '''__attribute__((weak)) __thread int ____critical_held = 0;
+static inline void ____critical_acquire(int *lock) {
+    int spins = 0;
+    while (__atomic_load_n(lock, __ATOMIC_RELAXED) != 0 ||
+            __atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE) != 0) {
+        if (++spins == 64) {
+            if (____critical_held == 0) {
+                hclib_yield(NULL);
+            }
+            spins = 0;
+        }
+    }
+    ____critical_held++;
+}
+static inline void ____critical_release(int *lock) {
+    ____critical_held--;
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+'''
 
 for expected in expected_header:
     line = sys.stdin.readline()
     assert line.strip() == expected
     sys.stdout.write(line)
 
-index = start
-while index < stop:
-    sys.stdout.write('pthread_mutex_t critical_' + str(index) +
-            '_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;\n')
-    index += 1
+body = sys.stdin.read()
 
-line = sys.stdin.readline()
-while len(line) > 0:
-    sys.stdout.write(line)
-    line = sys.stdin.readline()
+# One lock per critical section name. The locks are weak so that critical
+# sections with the same name in different translation units share a lock.
+used = []
+for lock in re.findall(r'____critical_acquire\(&(\w+)\)', body):
+    if lock not in used:
+        used.append(lock)
+
+if len(used) > 0 and body.find('void ____critical_acquire(') == -1:
+    sys.stdout.write(lock_functions)
+
+for lock in used:
+    decl = '__attribute__((weak)) int ' + lock + ' = 0;\n'
+    if body.find(decl) == -1:
+        sys.stdout.write(decl)
+
+sys.stdout.write(body)
@@ -22,9 +22,17 @@ VERBOSE=0
 USER_INCLUDES=
 USER_DEFINES=
 TARGET_LANG=HCLIB
+FEATURES=
 
-while getopts "i:o:kvhI:D:l:" opt; do
+while getopts "i:o:kvhI:D:l:f:" opt; do
     case $opt in 
+        f)
+            if [[ -z "$FEATURES" ]]; then
+                FEATURES=$OPTARG
+            else
+                FEATURES="$FEATURES,$OPTARG"
+            fi
+            ;;
         l)
             TARGET_LANG=$OPTARG
             ;;
@@ -47,7 +55,7 @@ while getopts "i:o:kvhI:D:l:" opt; do
             USER_DEFINES="$USER_DEFINES -D$OPTARG"
             ;;
         h)
-            echo 'usage: omp_to_hclib.sh <-i input-file> <-o output-file> [-k] [-v] [-h] [-I include-path]'
+            echo 'usage: omp_to_hclib.sh <-i input-file> <-o output-file> [-k] [-v] [-h] [-I include-path] [-f feature]'
             exit 1
             ;;
         \?)
@@ -77,6 +85,7 @@ if [[ $VERBOSE == 1 ]]; then
     echo KEEP = $KEEP
     echo USER_DEFINES = $USER_DEFINES
     echo VERBOSE = $VERBOSE
+    echo FEATURES = $FEATURES
 fi
 
 DIRNAME=$(dirname $INPUT_PATH)
@@ -130,7 +139,10 @@ COUNT=1
 CHANGED=1
 PREV=$WITH_BOTH
 CHECK_FOR_PTHREAD=true
-CRITICAL_SECTION_ID=0
+FEATURE_FLAGS=
+if [[ -n "$FEATURES" ]]; then
+    FEATURE_FLAGS="-f $FEATURES"
+fi
 USES_SHMEM_FILE=$DIRNAME/$FILE_PREFIX.$NAME.uses_shmem.info
 until [[ $CHANGED -eq 0 ]]; do
     OMP_INFO=$DIRNAME/$FILE_PREFIX.$NAME.omp.$COUNT.info
@@ -139,22 +151,17 @@ until [[ $CHANGED -eq 0 ]]; do
     TMP_OUTPUT=$DIRNAME/$FILE_PREFIX.$NAME.hclib.$COUNT.$EXTENSION
     WITHOUT_PRAGMAS=$DIRNAME/$FILE_PREFIX.$NAME.no_pragmas.$COUNT.$EXTENSION
     HANDLED_PRAGMAS_INFO=$DIRNAME/$FILE_PREFIX.handled_pragmas.$COUNT.info
-    CRITICAL_SECTION_ID_FILE=$DIRNAME/$FILE_PREFIX.critical_id.$COUNT.info
     WITH_LOCKS=$DIRNAME/$FILE_PREFIX.$NAME.with_locks.$COUNT.$EXTENSION
 
     # Translate OMP pragmas detected into HClib constructs.
     [[ $VERBOSE == 1 ]] && echo 'DEBUG >>> Converting OMP parallelism to HClib'
-    $OMP_TO_HCLIB -o $TMP_OUTPUT -c $CRITICAL_SECTION_ID \
-        -r $CRITICAL_SECTION_ID_FILE -n $CHECK_FOR_PTHREAD -s $USES_SHMEM_FILE \
-        -l $TARGET_LANG $PREV -- $INCLUDE $USER_INCLUDES $DEFINES -D__device__= -D__global__= \
+    $OMP_TO_HCLIB -o $TMP_OUTPUT -n $CHECK_FOR_PTHREAD -s $USES_SHMEM_FILE \
+        -l $TARGET_LANG $FEATURE_FLAGS $PREV -- $INCLUDE $USER_INCLUDES $DEFINES -D__device__= -D__global__= \
         -I$HCLIB_ROOT/include -I$HCLIB_ROOT/../modules/system/inc
 
-    PREV_CRITICAL_SECTION_ID=$CRITICAL_SECTION_ID
-    CRITICAL_SECTION_ID=$(cat $CRITICAL_SECTION_ID_FILE)
-
-    # Insert critical/atomic section locks
+    # Insert critical section locks
     [[ $VERBOSE == 1 ]] && echo 'DEBUG >>> Inserting critical section locks'
-    cat $TMP_OUTPUT | python $INSERT_CRITICAL_LOCKS $PREV_CRITICAL_SECTION_ID $CRITICAL_SECTION_ID > $WITH_LOCKS
+    cat $TMP_OUTPUT | python $INSERT_CRITICAL_LOCKS > $WITH_LOCKS
 
     # Check to see if there were any changes to the code during this iteration. If not, exit.
     set +e
@@ -23,16 +23,37 @@ using namespace clang::tooling;
 static llvm::cl::OptionCategory ToolingSampleCategory("omp-to-hclib options");
 static llvm::cl::opt<std::string> outputFile("o");
 static llvm::cl::opt<std::string> checkForPthread("n");
-static llvm::cl::opt<std::string> startingCriticalSectionId("c");
-static llvm::cl::opt<std::string> outputCriticalSectionIdFile("r");
 static llvm::cl::opt<std::string> outputUsesShmemFile("s");
 static llvm::cl::opt<std::string> targetLang("l");
+static llvm::cl::opt<std::string> featureList("f");
 
 static OMPToHClib *transform = NULL;
 FunctionDecl *curr_func_decl = NULL;
 std::vector<ValueDecl *> globals;
 std::vector<std::string> discoveredGlobals;
 TargetLang target;
+std::vector<std::string> enabledFeatures;
+
+/*
+ * Code generation features that are off by default and can be turned on with
+ * -f.
+ */
+static const char *knownFeatures[] = {
+    "range_closures", // forasync closures execute a tile of iterations per call
+    "task_ctx_pool", // task contexts come from per-worker freelists
+    "taskwait_counters", // taskwait blocks on a per-task count of live children
+    "task_cutoff", // tasks below a cutoff call task-free clones of functions
+    "readonly_captures", // loop bodies read unwritten shared vars from locals
+    "fuse_loops", // adjacent parallel for loops share one parallel region
+    "static_depends", // depend clauses on whole tiles are wired with promises
+    "persistent_teams", // time step loops around parallel fors run in one team
+    "temporal_blocking", // stencil time loops run blocks of steps per tile
+    "wavefront", // diagonal sweeps of blocks run as a graph of block tasks
+    "cache_tiles", // collapsed loops are tiled to fit the L2 along rows
+    "tile_nests", // perfect nests of two parallel loops are collapsed
+    "seq_fallback", // parallel loops with few iterations run in place
+    NULL
+};
 
 class TransformASTConsumer : public ASTConsumer {
 public:
@@ -52,13 +73,66 @@ public:
       }
   }
 
+  void scanFunctionDecl(FunctionDecl *fdecl) {
+      if (fdecl->isThisDeclarationADefinition() &&
+              R.getSourceMgr().isInMainFile(fdecl->getLocation())) {
+          transform->addDefinedFunction(fdecl->getNameAsString());
+          transform->scanFunctionBody(fdecl->getBody());
+      }
+  }
+
   // Override the method that gets called for each parsed top-level
   // declaration.
   bool HandleTopLevelDecl(DeclGroupRef DR) override {
+    /*
+     * Defer all processing until the whole translation unit has been parsed,
+     * so that the call graph analysis done while transforming a function can
+     * see the definitions of functions that appear after it.
+     */
+    topLevelDecls.push_back(DR);
+    return true;
+  }
+
+  void HandleTranslationUnit(ASTContext &Ctx) override {
     assert(transform != NULL);
     transform->setRewriter(R);
     transform->setContext(Context);
 
+    /*
+     * Find out up front whether any taskwait remains to be lowered in this
+     * translation unit, as that decides whether tasks are converted yet, and
+     * whether any task is final.
+     */
+    for (std::vector<DeclGroupRef>::iterator i = topLevelDecls.begin(),
+            e = topLevelDecls.end(); i != e; i++) {
+        for (DeclGroupRef::iterator b = i->begin(), e = i->end(); b != e; ++b) {
+            Decl *toplevel = *b;
+
+            if (FunctionDecl *fdecl = clang::dyn_cast<FunctionDecl>(toplevel)) {
+                scanFunctionDecl(fdecl);
+            } else if (FunctionTemplateDecl *tdecl =
+                    clang::dyn_cast<FunctionTemplateDecl>(toplevel)) {
+                scanFunctionDecl(tdecl->getTemplatedDecl());
+            } else if (LinkageSpecDecl *ldecl =
+                    clang::dyn_cast<LinkageSpecDecl>(toplevel)) {
+                for (DeclContext::decl_iterator di = ldecl->decls_begin(),
+                        de = ldecl->decls_end(); di != de; di++) {
+                    if (FunctionDecl *fdecl = clang::dyn_cast<FunctionDecl>(
+                                *di)) {
+                        scanFunctionDecl(fdecl);
+                    }
+                }
+            }
+        }
+    }
+
+    for (std::vector<DeclGroupRef>::iterator i = topLevelDecls.begin(),
+            e = topLevelDecls.end(); i != e; i++) {
+        handleTopLevelDeclGroup(*i);
+    }
+  }
+
+  void handleTopLevelDeclGroup(DeclGroupRef DR) {
     for (DeclGroupRef::iterator b = DR.begin(), e = DR.end(); b != e; ++b) {
         Decl *toplevel = *b;
 
@@ -111,13 +185,12 @@ public:
             }
         }
     }
-
-    return true;
   }
 
 private:
   Rewriter &R;
   ASTContext &Context;
+  std::vector<DeclGroupRef> topLevelDecls;
 };
 
 // For each source file provided to the tool, a new FrontendAction is created.
@@ -174,8 +247,6 @@ int main(int argc, const char **argv) {
 
   check_opt(outputFile, "Output file");
   check_opt(checkForPthread, "Check for pthread calls");
-  check_opt(startingCriticalSectionId, "Starting critical section ID");
-  check_opt(outputCriticalSectionIdFile, "Output critical section ID file");
   check_opt(outputUsesShmemFile, "Output uses SHMEM file");
   check_opt(targetLang, "Target language");
 
@@ -191,14 +262,42 @@ int main(int argc, const char **argv) {
       exit(1);
   }
 
+  /*
+   * Optional code generation features are passed as a comma-separated list,
+   * e.g. -f range_closures.
+   */
+  std::string features(featureList.c_str());
+  size_t start = 0;
+  while (start < features.size()) {
+      size_t end = features.find(',', start);
+      if (end == std::string::npos) {
+          end = features.size();
+      }
+      if (end > start) {
+          std::string feature = features.substr(start, end - start);
+          bool known = false;
+          for (int i = 0; knownFeatures[i] != NULL; i++) {
+              if (feature == knownFeatures[i]) {
+                  known = true;
+              }
+          }
+          if (!known) {
+              std::cerr << "Unknown feature \"" << feature << "\"" <<
+                  std::endl;
+              exit(1);
+          }
+          enabledFeatures.push_back(feature);
+      }
+      start = end + 1;
+  }
+
   assert(op.getSourcePathList().size() == 1);
 
   std::unique_ptr<FrontendActionFactory> factory_ptr = newFrontendActionFactory<
       NumDebugFrontendAction<TransformASTConsumer>>();
   FrontendActionFactory *factory = factory_ptr.get();
 
-  transform = new OMPToHClib(checkForPthread.c_str(),
-          startingCriticalSectionId.c_str());
+  transform = new OMPToHClib(checkForPthread.c_str());
 
   ClangTool *Tool = new ClangTool(op.getCompilations(), op.getSourcePathList());
   int err = Tool->run(factory);
@@ -213,12 +312,6 @@ int main(int argc, const char **argv) {
       // return err;
   }
 
-  std::ofstream out;
-  out.open(outputCriticalSectionIdFile);
-  assert(out.is_open());
-  out << transform->getCriticalSectionId() << std::flush;
-  out.close();
-
   // Check if we already know this application uses OpenSHMEM
   std::ifstream in;
   in.open(outputUsesShmemFile);
@@ -235,6 +328,7 @@ int main(int argc, const char **argv) {
 
   already_using_shmem = already_using_shmem || transform->hasShmemCalls();
 
+  std::ofstream out;
   out.open(outputUsesShmemFile);
   assert(out.is_open());
   if (already_using_shmem) {
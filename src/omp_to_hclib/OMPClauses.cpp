@@ -9,7 +9,11 @@ extern std::vector<clang::ValueDecl *> globals;
 OMPClauses::OMPClauses() {
 }
 
-OMPClauses::OMPClauses(std::string clauses) {
+/*
+ * Split the clauses of a pragma at the spaces that separate them, keeping any
+ * parenthesized arguments with the clause they belong to.
+ */
+std::vector<std::string> OMPClauses::splitClauses(std::string clauses) {
     std::vector<std::string> split_clauses;
     std::stringstream acc;
     int paren_depth = 0;
@@ -43,6 +47,11 @@ OMPClauses::OMPClauses(std::string clauses) {
     if (index != start) {
         split_clauses.push_back(clauses.substr(start));
     }
+    return split_clauses;
+}
+
+OMPClauses::OMPClauses(std::string clauses) {
+    std::vector<std::string> split_clauses = splitClauses(clauses);
 
     for (std::vector<std::string>::iterator i = split_clauses.begin(),
             e = split_clauses.end(); i != e; i++) {
@@ -117,7 +126,6 @@ std::vector<std::string> *OMPClauses::getFlattenedArgsList(std::string clause) {
 }
 
 int OMPClauses::getNumCollapsedLoops() {
-    assert(hasClause("for"));
     if (hasClause("collapse")) {
         std::string collapseArg = getSingleArg("collapse");
         return atoi(collapseArg.c_str());
@@ -126,6 +134,25 @@ int OMPClauses::getNumCollapsedLoops() {
     }
 }
 
+std::string OMPClauses::getScheduleKind() {
+    if (!hasClause("schedule")) {
+        return "";
+    }
+    assert(getArgs("schedule")->size() == 1);
+    return getArgs("schedule")->at(0)->getArgs()->at(0);
+}
+
+std::string OMPClauses::getScheduleChunk() {
+    if (!hasClause("schedule")) {
+        return "";
+    }
+    std::vector<std::string> *args = getArgs("schedule")->at(0)->getArgs();
+    if (args->size() < 2) {
+        return "";
+    }
+    return args->at(1);
+}
+
 bool OMPClauses::computeSingleVarInfo(clang::ValueDecl *decl,
         bool isGlobal, std::vector<OMPVarInfo> *vars) {
     std::string varname = decl->getNameAsString();
@@ -246,7 +273,11 @@ std::vector<OMPReductionVar> *OMPClauses::getReductions() {
             std::vector<std::string> *rawArgs = single_arg->getArgs();
 
             std::string op = rawArgs->at(0);
-            assert(op == "+");
+            if (!OMPReductionVar::isSupportedOp(op)) {
+                std::cerr << "Unsupported reduction op \"" << op << "\"" <<
+                    std::endl;
+                exit(1);
+            }
             for (int v = 1; v < rawArgs->size(); v++) {
                 reductions->push_back(OMPReductionVar(op, rawArgs->at(v)));
             }
@@ -25,6 +25,8 @@ class OMPClauses {
         std::vector<std::string> *getFlattenedArgsList(std::string clause);
 
         int getNumCollapsedLoops();
+        std::string getScheduleKind();
+        std::string getScheduleChunk();
         std::vector<OMPReductionVar> *getReductions();
         std::vector<OMPVarInfo> *getVarInfo(
                 std::vector<clang::ValueDecl *> *locals);
@@ -33,6 +35,8 @@ class OMPClauses {
 
         void addClauseArg(std::string clause, std::string arg);
 
+        static std::vector<std::string> splitClauses(std::string clauses);
+
         std::map<std::string, std::vector<SingleClauseArgs *> *>::iterator begin();
         std::map<std::string, std::vector<SingleClauseArgs *> *>::iterator end();
 };
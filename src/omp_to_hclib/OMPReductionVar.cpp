@@ -10,9 +10,131 @@ std::string OMPReductionVar::getOp() { return op; }
 
 std::string OMPReductionVar::getVar() { return var; }
 
-std::string OMPReductionVar::getInitialValue() {
-    if (op == "+") {
+bool OMPReductionVar::isSupportedOp(std::string op) {
+    return op == "+" || op == "-" || op == "*" || op == "&" || op == "|" ||
+        op == "^" || op == "&&" || op == "||" || op == "min" || op == "max";
+}
+
+/*
+ * The largest and smallest values representable by a builtin arithmetic type,
+ * used as the identities of min and max. These are spelled with the macros
+ * predefined by both GCC and Clang so that the generated code does not depend
+ * on float.h or limits.h having been included by the application.
+ */
+static std::string getTypeMax(const clang::BuiltinType *builtin,
+        std::string typeStr) {
+    switch (builtin->getKind()) {
+        case (clang::BuiltinType::Float):
+            return "__FLT_MAX__";
+        case (clang::BuiltinType::Double):
+            return "__DBL_MAX__";
+        case (clang::BuiltinType::LongDouble):
+            return "__LDBL_MAX__";
+        case (clang::BuiltinType::Char_S):
+        case (clang::BuiltinType::SChar):
+            return "__SCHAR_MAX__";
+        case (clang::BuiltinType::Short):
+            return "__SHRT_MAX__";
+        case (clang::BuiltinType::Int):
+            return "__INT_MAX__";
+        case (clang::BuiltinType::Long):
+            return "__LONG_MAX__";
+        case (clang::BuiltinType::LongLong):
+            return "__LONG_LONG_MAX__";
+        case (clang::BuiltinType::Bool):
+        case (clang::BuiltinType::Char_U):
+        case (clang::BuiltinType::UChar):
+        case (clang::BuiltinType::UShort):
+        case (clang::BuiltinType::UInt):
+        case (clang::BuiltinType::ULong):
+        case (clang::BuiltinType::ULongLong):
+            return "((" + typeStr + ")~(" + typeStr + ")0)";
+        default:
+            std::cerr << "Unsupported type \"" << typeStr << "\" for min/max " <<
+                "reduction" << std::endl;
+            exit(1);
+    }
+}
+
+static std::string getTypeMin(const clang::BuiltinType *builtin,
+        std::string typeStr) {
+    if (builtin->isFloatingPoint()) {
+        return "(-" + getTypeMax(builtin, typeStr) + ")";
+    } else if (builtin->isSignedInteger()) {
+        return "(-" + getTypeMax(builtin, typeStr) + " - 1)";
+    } else {
+        return "((" + typeStr + ")0)";
+    }
+}
+
+std::string OMPReductionVar::getInitialValue(clang::QualType type) {
+    const clang::QualType canonical = type.getCanonicalType();
+    const std::string typeStr = type.getUnqualifiedType().getAsString();
+
+    if (!isSupportedOp(op)) {
+        std::cerr << "Unsupported reduction op \"" << op << "\"" << std::endl;
+        exit(1);
+    }
+
+    if (!canonical->isArithmeticType()) {
+        std::cerr << "Reduction variable \"" << var << "\" has non-arithmetic " <<
+            "type \"" << typeStr << "\"" << std::endl;
+        exit(1);
+    }
+
+    if (op == "+" || op == "-" || op == "|" || op == "^" || op == "||") {
         return std::string("0");
+    } else if (op == "*" || op == "&&") {
+        return std::string("1");
+    } else if (op == "&") {
+        if (!canonical->isIntegerType()) {
+            std::cerr << "Bitwise reduction on non-integer variable \"" <<
+                var << "\"" << std::endl;
+            exit(1);
+        }
+        return "(~(" + typeStr + ")0)";
+    } else {
+        const clang::BuiltinType *builtin =
+            canonical->getAs<clang::BuiltinType>();
+        if (builtin == NULL) {
+            std::cerr << "Unsupported type \"" << typeStr << "\" for " << op <<
+                " reduction on \"" << var << "\"" << std::endl;
+            exit(1);
+        }
+
+        if (op == "min") {
+            return getTypeMax(builtin, typeStr);
+        } else {
+            return getTypeMin(builtin, typeStr);
+        }
+    }
+}
+
+/*
+ * Returns a statement folding the partial result val into the accumulator acc.
+ * Note that partial results of a '-' reduction are summed, as specified by
+ * OpenMP.
+ */
+std::string OMPReductionVar::getCombineStr(std::string acc, std::string val,
+        clang::QualType type) {
+    const std::string typeStr = type.getUnqualifiedType().getAsString();
+
+    if (op == "+" || op == "-") {
+        return acc + " += " + val + ";";
+    } else if (op == "*" || op == "&" || op == "|" || op == "^") {
+        if (op != "*" && !type.getCanonicalType()->isIntegerType()) {
+            std::cerr << "Bitwise reduction on non-integer variable \"" <<
+                var << "\"" << std::endl;
+            exit(1);
+        }
+        return acc + " " + op + "= " + val + ";";
+    } else if (op == "&&" || op == "||") {
+        return acc + " = (" + typeStr + ")(" + acc + " " + op + " " + val +
+            ");";
+    } else if (op == "min") {
+        return "if (" + val + " < " + acc + ") " + acc + " = " + val + ";";
+    } else if (op == "max") {
+        return "if (" + val + " > " + acc + ") " + acc + " = " + val + ";";
     } else {
         std::cerr << "Unsupported reduction op \"" << op << "\"" << std::endl;
         exit(1);
@@ -15,7 +15,11 @@ class OMPReductionVar {
         std::string getOp();
         std::string getVar();
 
-        std::string getInitialValue();
+        std::string getInitialValue(clang::QualType type);
+        std::string getCombineStr(std::string acc, std::string val,
+                clang::QualType type);
+
+        static bool isSupportedOp(std::string op);
 };
 
 #endif
@@ -14,6 +14,7 @@
 #include "llvm/ADT/ArrayRef.h"
 
 #include <algorithm>
+#include <cctype>
 #include <sstream>
 #include <iostream>
 
@@ -40,8 +41,52 @@ extern TargetLang target;
 
 extern clang::FunctionDecl *curr_func_decl;
 extern std::vector<clang::ValueDecl *> globals;
+extern std::vector<std::string> enabledFeatures;
 
 #define ASYNC_SUFFIX "_hclib_async"
+#define PENDING_CHILDREN_PREFIX "____pending_children_"
+#define FINAL_DEPTH_VAR "____omp_final_depth"
+#define TASK_DEPTH_VAR "____task_depth"
+#define TASK_CUTOFF_DEPTH "OMP_TO_HCLIB_TASK_CUTOFF_DEPTH"
+#define SEQ_CLONE_SUFFIX "____seq"
+#define TEAM_VAR "____team"
+#define THREAD_NUM_VAR "____thread_num"
+#define TILE_GRAPH_VAR "____tile_graph"
+// Iterations per forasync launch when the iteration space may not fit an int
+#define WIDE_CHUNK_ITERS "(1 << 30)"
+/*
+ * Estimated cost of launching a parallel loop, in the units of
+ * getIterationCost, below which the loop runs sequentially instead.
+ */
+#define SEQ_FALLBACK_COST 20000
+#define SEQ_TRIPS_ENV_PREFIX "OMP_TO_HCLIB_SEQ_TRIPS_"
+// Bytes of data touched by a tile of collapsed loops, about the size of an L2
+#define CACHE_TILE_BYTES "(256 * 1024)"
+// Time steps per tile, and bytes of both buffers per tile, of temporal blocking
+#define TEMPORAL_BLOCK_STEPS "8"
+#define TEMPORAL_BLOCK_BYTES "(256 * 1024)"
+// Label suffix of the block tasks of a wavefront, and the future they wait on
+#define WAVEFRONT_SUFFIX "_wavefront"
+#define WAVEFRONT_FIRST_VAR "____wf_first"
+
+static clang::ValueDecl *getReductionDecl(OMPReductionVar red,
+        std::vector<OMPVarInfo> *vars) {
+    for (std::vector<OMPVarInfo>::iterator i = vars->begin(), e = vars->end();
+            i != e; i++) {
+        OMPVarInfo info = *i;
+        if (info.getDecl()->getNameAsString() == red.getVar()) {
+            return info.getDecl();
+        }
+    }
+    std::cerr << "Unable to find declaration of reduction variable \"" <<
+        red.getVar() << "\"" << std::endl;
+    exit(1);
+}
+
+static bool isFeatureEnabled(std::string feature) {
+    return std::find(enabledFeatures.begin(), enabledFeatures.end(),
+            feature) != enabledFeatures.end();
+}
 
 static bool isGlobal(std::string varname) {
     for (std::vector<clang::ValueDecl *>::iterator ii = globals.begin(),
@@ -125,6 +170,187 @@ std::string OMPToHClib::stmtToStringWithSharedVars(const clang::Stmt *stmt,
     return stmtToString(stmt);
 }
 
+/*
+ * Collect the declarations that stmt may modify. A reference only counts as a
+ * read when its value is loaded straight away, so any other use (assignment,
+ * increment, taking the address, binding to a reference, ...) is treated as a
+ * write.
+ */
+static void collectWrittenDecls(const clang::Stmt *stmt,
+        const clang::Stmt *parent,
+        std::set<const clang::ValueDecl *> *written) {
+    if (const clang::DeclRefExpr *ref =
+            clang::dyn_cast<clang::DeclRefExpr>(stmt)) {
+        const clang::ImplicitCastExpr *cast = (parent == NULL ? NULL :
+                clang::dyn_cast<clang::ImplicitCastExpr>(parent));
+        if (cast == NULL || cast->getCastKind() != clang::CK_LValueToRValue) {
+            written->insert(ref->getDecl());
+        }
+    }
+
+    // Parentheses do not change how their operand is used
+    const clang::Stmt *childParent = (clang::isa<clang::ParenExpr>(stmt) ?
+            parent : stmt);
+    for (clang::Stmt::const_child_iterator i = stmt->child_begin(),
+            e = stmt->child_end(); i != e; i++) {
+        if (*i != NULL) {
+            collectWrittenDecls(*i, childParent, written);
+        }
+    }
+}
+
+static void collectLocalDecls(const clang::Stmt *stmt,
+        std::set<const clang::ValueDecl *> *locals) {
+    if (const clang::DeclStmt *declStmt =
+            clang::dyn_cast<clang::DeclStmt>(stmt)) {
+        for (clang::DeclStmt::const_decl_iterator i = declStmt->decl_begin(),
+                e = declStmt->decl_end(); i != e; i++) {
+            if (const clang::ValueDecl *decl =
+                    clang::dyn_cast<clang::ValueDecl>(*i)) {
+                locals->insert(decl);
+            }
+        }
+    }
+
+    for (clang::Stmt::const_child_iterator i = stmt->child_begin(),
+            e = stmt->child_end(); i != e; i++) {
+        if (*i != NULL) {
+            collectLocalDecls(*i, locals);
+        }
+    }
+}
+
+/*
+ * Whether an lvalue of type accessed may refer to an object of the given type,
+ * following the C aliasing rules.
+ */
+static bool mayAliasTypes(clang::QualType accessed, clang::QualType type,
+        clang::ASTContext *Context) {
+    return !accessed->isScalarType() || accessed->isCharType() ||
+        !type->isScalarType() || type->isCharType() ||
+        Context->hasSameUnqualifiedType(accessed, type) ||
+        (accessed->isIntegerType() && type->isIntegerType());
+}
+
+/*
+ * Conservatively check whether stmt may modify an object of the given type
+ * that was not declared inside of it. Stores are matched against the type of
+ * the lvalue they modify, following the C aliasing rules. Any call may modify
+ * anything, unless it is to a builtin (e.g. sqrt) that is not passed a
+ * pointer.
+ */
+static bool mayModifyObjectOfType(const clang::Stmt *stmt,
+        clang::QualType type, std::set<const clang::ValueDecl *> *locals,
+        clang::ASTContext *Context) {
+    const clang::Expr *modified = NULL;
+    if (const clang::BinaryOperator *bin =
+            clang::dyn_cast<clang::BinaryOperator>(stmt)) {
+        if (bin->isAssignmentOp()) {
+            modified = bin->getLHS();
+        }
+    } else if (const clang::UnaryOperator *unary =
+            clang::dyn_cast<clang::UnaryOperator>(stmt)) {
+        if (unary->isIncrementDecrementOp()) {
+            modified = unary->getSubExpr();
+        }
+    } else if (const clang::CallExpr *call =
+            clang::dyn_cast<clang::CallExpr>(stmt)) {
+        const clang::FunctionDecl *callee = call->getDirectCallee();
+        if (callee == NULL || callee->getBuiltinID() == 0 ||
+                clang::isa<clang::CXXOperatorCallExpr>(call) ||
+                clang::isa<clang::CXXMemberCallExpr>(call)) {
+            return true;
+        }
+        for (unsigned a = 0; a < call->getNumArgs(); a++) {
+            if (call->getArg(a)->getType()->isPointerType()) {
+                return true;
+            }
+        }
+    } else if (clang::isa<clang::CXXConstructExpr>(stmt) ||
+            clang::isa<clang::AsmStmt>(stmt)) {
+        return true;
+    }
+
+    if (modified != NULL) {
+        modified = modified->IgnoreParenImpCasts();
+        const clang::DeclRefExpr *ref =
+            clang::dyn_cast<clang::DeclRefExpr>(modified);
+        if ((ref == NULL || locals->find(ref->getDecl()) == locals->end()) &&
+                mayAliasTypes(modified->getType(), type, Context)) {
+            return true;
+        }
+    }
+
+    for (clang::Stmt::const_child_iterator i = stmt->child_begin(),
+            e = stmt->child_end(); i != e; i++) {
+        if (*i != NULL && mayModifyObjectOfType(*i, type, locals, Context)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Of the given shared variables, find the scalars and pointers that body only
+ * ever reads. These can be unpacked from the context once into const locals
+ * rather than being accessed through their captured address on every use,
+ * which hides from the compiler that they are loop invariant.
+ */
+std::vector<OMPVarInfo> *OMPToHClib::getReadOnlySharedVars(
+        const clang::Stmt *body, std::vector<OMPVarInfo> *shared) {
+    std::set<const clang::ValueDecl *> written;
+    collectWrittenDecls(body, NULL, &written);
+
+    std::vector<OMPVarInfo> *readOnly = new std::vector<OMPVarInfo>();
+    for (std::vector<OMPVarInfo>::iterator i = shared->begin(),
+            e = shared->end(); i != e; i++) {
+        OMPVarInfo info = *i;
+        clang::QualType type = info.getDecl()->getType();
+        if (info.checkIsGlobal() || written.find(info.getDecl()) !=
+                written.end() || !type->isScalarType() ||
+                type.isVolatileQualified()) {
+            continue;
+        }
+        if (const clang::PointerType *pointer =
+                type->getAs<clang::PointerType>()) {
+            // The declaration below cannot spell these out around a name
+            if (pointer->getPointeeType()->isArrayType() ||
+                    pointer->getPointeeType()->isFunctionType()) {
+                continue;
+            }
+        }
+        readOnly->push_back(info);
+    }
+    return readOnly;
+}
+
+/*
+ * Unpack a read-only shared variable from the context into a const local. A
+ * pointer is also marked __restrict if nothing in body can modify the objects
+ * it points to, in which case the promise trivially holds.
+ */
+std::string OMPToHClib::getReadOnlyUnpackStr(clang::ValueDecl *decl,
+        const clang::Stmt *body) {
+    clang::QualType type = decl->getType();
+    std::string qualifiers = " ";
+
+    if (const clang::PointerType *pointer =
+            type->getAs<clang::PointerType>()) {
+        clang::QualType pointee = pointer->getPointeeType();
+        if (pointee->isScalarType()) {
+            std::set<const clang::ValueDecl *> locals;
+            collectLocalDecls(body, &locals);
+            if (!mayModifyObjectOfType(body, pointee, &locals, Context)) {
+                qualifiers = " __restrict ";
+            }
+        }
+    }
+
+    return type.withConst().getAsString(Context->getPrintingPolicy()) +
+        qualifiers + decl->getNameAsString() + " = *(ctx->" +
+        decl->getNameAsString() + "_ptr);";
+}
+
 std::string OMPToHClib::stringForAST(const clang::Stmt *stmt) {
     std::string s;
     llvm::raw_string_ostream stream(s);
@@ -300,10 +526,30 @@ std::string OMPToHClib::getCaptureStr(clang::ValueDecl *decl) {
 }
 
 std::string OMPToHClib::getStructDef(std::string structName,
-        std::vector<clang::ValueDecl *> *captured, OMPClauses *clauses) {
+        std::vector<clang::ValueDecl *> *captured, OMPClauses *clauses,
+        int nRangeDims, bool taskDepth, bool team, bool tileDeps,
+        std::vector<const clang::ValueDecl *> *wideCondVars, bool linearized) {
     std::vector<OMPVarInfo> *vars = clauses->getVarInfo(captured);
+    std::vector<OMPReductionVar> *reductions = clauses->getReductions();
 
     std::stringstream ss;
+
+    if (!reductions->empty()) {
+        /*
+         * Each worker folds its iterations into its own copy of the reduction
+         * variables. The trailing padding keeps any two workers' accumulators
+         * on separate cache lines, regardless of the alignment of the array.
+         */
+        ss << "typedef struct _" << structName << "_reduction {" << std::endl;
+        for (std::vector<OMPReductionVar>::iterator i = reductions->begin(),
+                e = reductions->end(); i != e; i++) {
+            ss << "    " << getDeclarationStr(getReductionDecl(*i, vars)) <<
+                std::endl;
+        }
+        ss << "    char ____pad[64];" << std::endl;
+        ss << " } " << structName << "_reduction;" << std::endl << std::endl;
+    }
+
     ss << "typedef struct _" << structName << " {" << std::endl;
 
     for (std::vector<OMPVarInfo>::iterator i = vars->begin(), e = vars->end();
@@ -325,7 +571,6 @@ std::string OMPToHClib::getStructDef(std::string structName,
                 ss << "    " << getDeclarationStr(decl) << std::endl;
                 break;
             case (CAPTURE_TYPE::LASTPRIVATE):
-                ss << "    " << getDeclarationStr(decl) << std::endl;
                 ss << "    " << getDeclarationTypeStr(
                         Context->getPointerType(decl->getType()),
                         decl->getNameAsString() + "_ptr", "", "") << ";" <<
@@ -337,8 +582,68 @@ std::string OMPToHClib::getStructDef(std::string structName,
         }
     }
 
-    if (clauses->getReductions()->size() > 0) {
-        ss << "    pthread_mutex_t reduction_mutex;" << std::endl;
+    if (!reductions->empty()) {
+        ss << "    " << structName << "_reduction *per_worker_reductions;" <<
+            std::endl;
+    }
+
+    if (nRangeDims > 0) {
+        /*
+         * The original iteration space, split into tiles by range closures and
+         * used to find the last iteration for lastprivate variables
+         */
+        ss << "    hclib_loop_domain_t ____range[" << nRangeDims << "];" <<
+            std::endl;
+    }
+
+    if (wideCondVars != NULL) {
+        /*
+         * Each forasync launch covers a chunk of a wide iteration space, which
+         * starts at ____base with ____left iterations remaining in total
+         */
+        for (unsigned l = 0; l < wideCondVars->size(); l++) {
+            clang::QualType type = wideCondVars->at(l)->getType();
+            std::stringstream suffix;
+            suffix << l;
+            ss << "    " << getDeclarationTypeStr(type, "____base" +
+                    suffix.str(), "", "") << ";" << std::endl;
+            ss << "    " << getDeclarationTypeStr(type, "____step" +
+                    suffix.str(), "", "") << ";" << std::endl;
+            ss << "    " << getDeclarationTypeStr(type, "____left" +
+                    suffix.str(), "", "") << ";" << std::endl;
+        }
+    }
+
+    if (linearized) {
+        /*
+         * A collapsed nest whose inner bounds depend on the outer induction
+         * variable, flattened into tiles of ____tile iterations. Outer
+         * iteration o covers linear indices [____offsets[o], ____offsets[o + 1])
+         * and its inner loop starts at ____inner_low[o]. Linear indices are
+         * longs, as the nest may run more iterations than fit in an int.
+         */
+        ss << "    int ____outer_low;" << std::endl;
+        ss << "    int ____outer_step;" << std::endl;
+        ss << "    int ____outer_n;" << std::endl;
+        ss << "    long ____tile;" << std::endl;
+        ss << "    long *____offsets;" << std::endl;
+        ss << "    int *____inner_low;" << std::endl;
+        ss << "    int *____inner_step;" << std::endl;
+    }
+
+    if (taskDepth) {
+        // Number of task ancestors, compared against task cutoffs
+        ss << "    int ____depth;" << std::endl;
+    }
+
+    if (team) {
+        // Shared by every thread of a bare parallel region
+        ss << "    ____omp_team_t ____team;" << std::endl;
+    }
+
+    if (tileDeps) {
+        // Predecessors of a task whose dependencies were resolved statically
+        ss << "    ____omp_task_deps_t *____deps;" << std::endl;
     }
 
     ss << " } " << structName << ";" << std::endl << std::endl;
@@ -504,6 +809,332 @@ std::string OMPToHClib::getStrideFromIncr(const clang::Stmt *inc,
     }
 }
 
+/*
+ * Whether an induction variable can take values that do not fit the int
+ * iterators of forasync.
+ */
+static bool isWideInductionVar(const clang::ValueDecl *condVar,
+        clang::ASTContext *Context) {
+    clang::QualType type = condVar->getType();
+    if (!type->isIntegerType()) {
+        return false;
+    }
+    const uint64_t size = Context->getTypeSize(type);
+    return size > 32 || (size == 32 && type->isUnsignedIntegerType());
+}
+
+static bool referencesAnyDecl(const clang::Stmt *stmt,
+        std::vector<const clang::ValueDecl *> *decls) {
+    if (const clang::DeclRefExpr *ref =
+            clang::dyn_cast<clang::DeclRefExpr>(stmt)) {
+        if (std::find(decls->begin(), decls->end(), ref->getDecl()) !=
+                decls->end()) {
+            return true;
+        }
+    }
+    for (clang::Stmt::const_child_iterator i = stmt->child_begin(),
+            e = stmt->child_end(); i != e; i++) {
+        if (*i != NULL && referencesAnyDecl(*i, decls)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Map the schedule clause of a parallel loop, or the grainsize or num_tasks
+ * clause of a taskloop, onto the tile size of one dimension of its forasync
+ * domain. Tiles are expressed in the units of the loop index, so chunk sizes
+ * are scaled by the stride. For collapsed loops the schedule is applied to the
+ * outermost dimension and the runtime picks the tiling of the inner
+ * dimensions.
+ */
+std::string OMPToHClib::getTileStr(OMPClauses *clauses, int dim,
+        std::string lowStr, std::string highStr, std::string strideStr) {
+    const std::string kind = clauses->getScheduleKind();
+    const std::string chunk = clauses->getScheduleChunk();
+    const bool grainControl = (clauses->hasClause("grainsize") ||
+            clauses->hasClause("num_tasks"));
+
+    if (dim != 0 || strideStr.find("-") == 0 || (!grainControl &&
+                kind != "static" && kind != "dynamic" && kind != "guided")) {
+        return "-1";
+    }
+
+    std::string scale = "";
+    std::string niters = "(" + highStr + ") - (" + lowStr + ")";
+    if (strideStr != "1") {
+        scale = " * (" + strideStr + ")";
+        niters = "((" + highStr + ") - (" + lowStr + ") + (" + strideStr +
+            ") - 1) / (" + strideStr + ")";
+    }
+
+    if (clauses->hasClause("grainsize")) {
+        return "(" + clauses->getSingleArg("grainsize") + ")" + scale;
+    } else if (clauses->hasClause("num_tasks")) {
+        /*
+         * Split the iterations evenly into that many tasks, rounding up. An
+         * empty range still gets a tile of one iteration.
+         */
+        std::string perTask = "((" + niters + ") > 0 ? 1 + ((" + niters +
+            ") - 1) / (" + clauses->getSingleArg("num_tasks") + ") : 1)";
+        if (scale.size() > 0) {
+            return "(" + perTask + ")" + scale;
+        }
+        return perTask;
+    } else if (chunk.size() > 0) {
+        return "(" + chunk + ")" + scale;
+    } else if (kind == "static") {
+        // One contiguous block of iterations per worker, rounding up
+        std::string perWorker = "((" + niters + ") > 0 ? 1 + ((" + niters +
+            ") - 1) / hclib_get_num_workers() : 1)";
+        if (scale.size() > 0) {
+            return "(" + perWorker + ")" + scale;
+        }
+        return perWorker;
+    } else if (kind == "dynamic") {
+        // The OpenMP default chunk size for dynamic is a single iteration
+        return "1" + scale;
+    } else {
+        return "-1";
+    }
+}
+
+std::string OMPToHClib::getForasyncModeStr(OMPClauses *clauses) {
+    const std::string kind = clauses->getScheduleKind();
+    if (clauses->hasClause("grainsize") || clauses->hasClause("num_tasks")) {
+        // One task per tile, so that the tuned grain is not split further
+        return "FORASYNC_MODE_FLAT";
+    } else if (kind == "static") {
+        /*
+         * Static schedules hand out a fixed set of chunks up front, which is
+         * what the flat forasync mode does.
+         */
+        return "FORASYNC_MODE_FLAT";
+    } else if (kind == "dynamic" || kind == "guided") {
+        /*
+         * Recursive splitting exposes the chunks to work stealing, so large
+         * pieces are taken first and idle workers pick up the remainder.
+         */
+        return "FORASYNC_MODE_RECURSIVE";
+    } else {
+        // auto, runtime, or no schedule at all
+        return "HCLIB_FORASYNC_MODE";
+    }
+}
+
+/*
+ * The variables of a taskloop are firstprivate by default, unless they are
+ * shared in the enclosing region. A nogroup taskloop can outlive the frame
+ * that encountered it, so those variables are copied into its context rather
+ * than referenced from that frame. Returns false if one of them cannot be
+ * copied, in which case the taskloop has to be waited for.
+ */
+bool OMPToHClib::privatizeNogroupCaptures(PragmaNode *node,
+        OMPClauses *clauses) {
+    if (clauses->hasClause("default")) {
+        return true;
+    }
+
+    std::vector<std::string> explicitlyShared;
+    if (clauses->hasClause("shared")) {
+        explicitlyShared = *clauses->getFlattenedArgsList("shared");
+    }
+
+    bool copied = true;
+    std::vector<OMPVarInfo> *vars = clauses->getVarInfo(node->getCaptures());
+    for (std::vector<OMPVarInfo>::iterator i = vars->begin(),
+            e = vars->end(); i != e; i++) {
+        clang::ValueDecl *decl = i->getDecl();
+        std::string varname = decl->getNameAsString();
+        if (i->getType() != CAPTURE_TYPE::SHARED || i->checkIsGlobal() ||
+                std::find(explicitlyShared.begin(), explicitlyShared.end(),
+                    varname) != explicitlyShared.end() ||
+                getParentCaptureType(node->getParentAccountForFusing(),
+                    varname) == CAPTURE_TYPE::SHARED) {
+            continue;
+        }
+
+        clang::QualType type = decl->getType();
+        if (type->isReferenceType() || type->isVariablyModifiedType()) {
+            copied = false;
+        } else {
+            clauses->addClauseArg("firstprivate", varname);
+        }
+    }
+    return copied;
+}
+
+/*
+ * For range closures, save the iteration space in the context and rewrite the
+ * domain passed to forasync so that it iterates over tile indices instead, one
+ * closure call per tile. The tile size selected by the schedule clause is kept
+ * if there is one. Otherwise the outermost dimension is split into a few tiles
+ * per worker and inner dimensions are left whole, which gives the longest
+ * inner loops.
+ */
+std::string OMPToHClib::getRangeSetupStr(int nLoops) {
+    std::stringstream ss;
+    for (int l = 0; l < nLoops; l++) {
+        std::stringstream dom;
+        dom << "domain[" << l << "]";
+        std::stringstream range;
+        range << "new_ctx->____range[" << l << "]";
+
+        ss << range.str() << " = " << dom.str() << ";\n";
+        ss << "if (" << range.str() << ".tile <= 0) {\n";
+        if (l == 0) {
+            ss << "    " << range.str() << ".tile = (1 + ((" << dom.str() <<
+                ".high - " << dom.str() << ".low + " << dom.str() <<
+                ".stride - 1) / " << dom.str() << ".stride - 1) / (4 * " <<
+                "hclib_get_num_workers())) * " << dom.str() << ".stride;\n";
+        } else {
+            ss << "    " << range.str() << ".tile = " << dom.str() <<
+                ".high - " << dom.str() << ".low;\n";
+        }
+        ss << "    if (" << range.str() << ".tile <= 0) " << range.str() <<
+            ".tile = " << dom.str() << ".stride;\n";
+        ss << "}\n";
+        ss << dom.str() << ".high = (" << dom.str() << ".high - " <<
+            dom.str() << ".low + " << range.str() << ".tile - 1) / " <<
+            range.str() << ".tile;\n";
+        ss << dom.str() << ".low = 0;\n";
+        ss << dom.str() << ".stride = 1;\n";
+        ss << dom.str() << ".tile = 1;\n";
+    }
+    return ss.str();
+}
+
+/*
+ * hclib loop domains and forasync iterators are ints, so an iteration space
+ * whose induction variables are wider is normalized to iteration counts and
+ * launched in chunks of at most WIDE_CHUNK_ITERS iterations per dimension, one
+ * chunk at a time. The closure maps its int iterators back to induction
+ * variables through the base and step of the current chunk in the context.
+ * This opens one loop per dimension, to be closed after the launch.
+ */
+std::string OMPToHClib::getWideChunkSetupStr(OMPClauses *clauses,
+        std::vector<const clang::ValueDecl *> *condVars,
+        std::vector<std::string> *lows, std::vector<std::string> *highs,
+        std::vector<std::string> *strides) {
+    std::stringstream ss;
+    for (unsigned l = 0; l < condVars->size(); l++) {
+        clang::QualType type = condVars->at(l)->getType();
+        std::stringstream suffix;
+        suffix << l;
+        std::string low = "____low" + suffix.str();
+        std::string high = "____high" + suffix.str();
+        std::string step = "____step" + suffix.str();
+        std::string niters = "____niters" + suffix.str();
+
+        ss << "const " << getDeclarationTypeStr(type, low, "", "") << " = " <<
+            lows->at(l) << ";\n";
+        ss << "const " << getDeclarationTypeStr(type, high, "", "") << " = " <<
+            highs->at(l) << ";\n";
+        ss << "const " << getDeclarationTypeStr(type, step, "", "") << " = " <<
+            strides->at(l) << ";\n";
+        ss << "const " << getDeclarationTypeStr(type, niters, "", "") <<
+            " = (" << high << " > " << low << " ? (" << high << " - " << low <<
+            " + " << step << " - 1) / " << step << " : 0);\n";
+        ss << getDeclarationTypeStr(type, "____chunk" + suffix.str(), "", "") <<
+            ";\n";
+        ss << "new_ctx->" << step << " = " << step << ";\n";
+    }
+
+    for (unsigned l = 0; l < condVars->size(); l++) {
+        std::stringstream suffix;
+        suffix << l;
+        std::string chunk = "____chunk" + suffix.str();
+        std::string left = "new_ctx->____left" + suffix.str();
+        std::stringstream dom;
+        dom << "domain[" << l << "]";
+
+        ss << "for (" << chunk << " = 0; " << chunk << " < ____niters" <<
+            suffix.str() << "; " << chunk << " += " << WIDE_CHUNK_ITERS <<
+            ") {\n";
+        ss << "new_ctx->____base" << suffix.str() << " = ____low" <<
+            suffix.str() << " + " << chunk << " * ____step" << suffix.str() <<
+            ";\n";
+        ss << left << " = ____niters" << suffix.str() << " - " << chunk <<
+            ";\n";
+        ss << dom.str() << ".low = 0;\n";
+        ss << dom.str() << ".high = (" << left << " < " << WIDE_CHUNK_ITERS <<
+            " ? " << left << " : " << WIDE_CHUNK_ITERS << ");\n";
+        ss << dom.str() << ".stride = 1;\n";
+        ss << dom.str() << ".tile = " << getTileStr(clauses, l, "0",
+                dom.str() + ".high", "1") << ";\n";
+    }
+    return ss.str();
+}
+
+/*
+ * Linearize a collapsed pair of loops whose inner bounds depend on the outer
+ * induction variable, e.g. a triangular nest. The inner bounds are evaluated
+ * once per outer iteration here and the running total of inner iterations is
+ * kept, so that the nest can be split into tiles of equal numbers of
+ * iterations regardless of its shape. forasync then iterates over tile
+ * indices.
+ */
+std::string OMPToHClib::getLinearizedSetupStr(OMPClauses *clauses,
+        std::vector<const clang::ValueDecl *> *condVars,
+        std::vector<std::string> *lows, std::vector<std::string> *highs,
+        std::vector<std::string> *strides) {
+    assert(condVars->size() == 2);
+    const clang::ValueDecl *outer = condVars->at(0);
+
+    std::stringstream ss;
+    ss << "hclib_loop_domain_t domain[1];\n";
+    ss << "new_ctx->____outer_low = " << lows->at(0) << ";\n";
+    ss << "new_ctx->____outer_step = " << strides->at(0) << ";\n";
+    ss << "new_ctx->____outer_n = ((" << highs->at(0) << ") > " <<
+        "new_ctx->____outer_low ? ((" << highs->at(0) << ") - " <<
+        "new_ctx->____outer_low + new_ctx->____outer_step - 1) / " <<
+        "new_ctx->____outer_step : 0);\n";
+    ss << "new_ctx->____offsets = (long *)malloc((new_ctx->____outer_n + 1) * " <<
+        "sizeof(long));\n";
+    ss << "new_ctx->____inner_low = (int *)malloc((new_ctx->____outer_n + 1) * " <<
+        "sizeof(int));\n";
+    ss << "new_ctx->____inner_step = (int *)malloc((new_ctx->____outer_n + 1) * " <<
+        "sizeof(int));\n";
+    ss << "new_ctx->____offsets[0] = 0;\n";
+    ss << "{\n";
+    ss << getDeclarationTypeStr(outer->getType(), outer->getNameAsString(), "",
+            "") << ";\n";
+    ss << "int ____o;\n";
+    ss << "for (____o = 0; ____o < new_ctx->____outer_n; ____o++) {\n";
+    ss << "    " << outer->getNameAsString() << " = new_ctx->____outer_low + " <<
+        "____o * new_ctx->____outer_step;\n";
+    ss << "    const int ____low = " << lows->at(1) << ";\n";
+    ss << "    const int ____high = " << highs->at(1) << ";\n";
+    ss << "    const int ____step = " << strides->at(1) << ";\n";
+    ss << "    new_ctx->____inner_low[____o] = ____low;\n";
+    ss << "    new_ctx->____inner_step[____o] = ____step;\n";
+    ss << "    new_ctx->____offsets[____o + 1] = new_ctx->____offsets[____o] + " <<
+        "(____high > ____low ? (____high - ____low + ____step - 1) / " <<
+        "____step : 0);\n";
+    ss << "}\n";
+    ss << "}\n";
+
+    std::string total = "new_ctx->____offsets[new_ctx->____outer_n]";
+    std::string tile = getTileStr(clauses, 0, "0", total, "1");
+    if (tile == "-1") {
+        // A few tiles per worker, as for range closures
+        tile = "1 + (" + total + " - 1) / (4 * hclib_get_num_workers())";
+    }
+    ss << "new_ctx->____tile = " << tile << ";\n";
+    ss << "if (new_ctx->____tile <= 0) new_ctx->____tile = 1;\n";
+    // forasync counts the tiles in an int
+    ss << "if (new_ctx->____tile < 1 + (" << total << " - 1) / " <<
+        WIDE_CHUNK_ITERS << ") new_ctx->____tile = 1 + (" << total <<
+        " - 1) / " << WIDE_CHUNK_ITERS << ";\n";
+    ss << "domain[0].low = 0;\n";
+    ss << "domain[0].high = (" << total << " + new_ctx->____tile - 1) / " <<
+        "new_ctx->____tile;\n";
+    ss << "domain[0].stride = 1;\n";
+    ss << "domain[0].tile = 1;\n";
+    return ss.str();
+}
+
 void OMPToHClib::traverseFunctorBody(const clang::Stmt *curr,
         ParallelRegionInfo &acc, bool beneathFunctionCall) {
 #ifdef VERBOSE
@@ -1227,7 +1858,8 @@ std::string OMPToHClib::getClosureDecl(std::string closureName,
         bool isForasyncClosure, int forasyncDim, bool isFuture,
         bool &isAcceleratable, std::string iterator, std::string bodyStr,
         const clang::Stmt *body, std::vector<clang::ValueDecl *> *captured,
-        OMPClauses *clauses, CUDAFunctorParameters *functor_params) {
+        OMPClauses *clauses, CUDAFunctorParameters *functor_params,
+        bool rangeClosure, bool linearized) {
     std::stringstream ss;
 
     if (target == CUDA) {
@@ -1250,8 +1882,13 @@ std::string OMPToHClib::getClosureDecl(std::string closureName,
         ss << closureName << "(void *____arg";
         if (isForasyncClosure) {
             assert(forasyncDim > 0);
+            // Named as by getClosureDef
             for (int i = 0; i < forasyncDim; i++) {
-                ss << ", const int ___iter" << i;
+                if (rangeClosure || linearized) {
+                    ss << ", const int ___tile" << i;
+                } else {
+                    ss << ", const int ___iter" << i;
+                }
             }
         } else {
             assert(forasyncDim == -1);
@@ -1262,76 +1899,3700 @@ std::string OMPToHClib::getClosureDecl(std::string closureName,
     return ss.str();
 }
 
-bool OMPToHClib::canLaunchTasks(const clang::Stmt *body) {
-    if (const clang::CallExpr *call = clang::dyn_cast<clang::CallExpr>(body)) {
-        /*
-         * For now, if there are any function calls assume they may result in
-         * task creation. This is a very conservative decision. TODO improve.
-         */
+/*
+ * Functions without a definition in this translation unit that are known not
+ * to create tasks or call back into code that could.
+ */
+static const char *leafFunctions[] = {
+    // libc
+    "malloc", "calloc", "realloc", "free", "memcpy", "memmove", "memset",
+    "memcmp", "strlen", "strcmp", "strncmp", "strcpy", "strncpy", "strcat",
+    "strncat", "strchr", "strrchr", "strstr", "strdup", "printf", "fprintf",
+    "sprintf", "snprintf", "puts", "putchar", "fputs", "fputc", "fflush",
+    "atoi", "atol", "atof", "strtol", "strtoul", "strtod", "strtof", "rand",
+    "rand_r", "srand", "random", "drand48", "erand48", "abs", "labs", "exit",
+    "abort", "__assert_fail", "__assert_rtn", "__assert", "gettimeofday",
+    "clock_gettime", "time",
+    // libm
+    "sqrt", "sqrtf", "cbrt", "cbrtf", "fabs", "fabsf", "exp", "expf", "exp2",
+    "exp2f", "log", "logf", "log2", "log2f", "log10", "log10f", "pow", "powf",
+    "sin", "sinf", "cos", "cosf", "tan", "tanf", "asin", "asinf", "acos",
+    "acosf", "atan", "atanf", "atan2", "atan2f", "sinh", "cosh", "tanh",
+    "floor", "floorf", "ceil", "ceilf", "round", "roundf", "trunc", "truncf",
+    "fmod", "fmodf", "fmin", "fminf", "fmax", "fmaxf", "hypot", "hypotf",
+    "erf", "erff",
+    // OpenMP runtime queries, answered by the team they run in
+    "omp_get_thread_num", "omp_get_num_threads",
+    // Used in generated code
+    "pthread_mutex_lock", "pthread_mutex_unlock", "hclib_get_current_worker",
+    "hclib_get_num_workers", "hclib_yield", "hclib_get_future_for_promise",
+    "hclib_future_wait", "hclib_promise_init", "hclib_promise_put",
+    NULL
+};
+
+static bool isLeafFunction(const clang::FunctionDecl *callee) {
+    if (callee->getBuiltinID() != 0) {
         return true;
     }
 
-    for (clang::Stmt::const_child_iterator i = body->child_begin(),
-            e = body->child_end(); i != e; i++) {
-        const clang::Stmt *child = *i;
-        if (child != NULL && canLaunchTasks(child)) {
+    const std::string name = callee->getNameAsString();
+    for (int i = 0; leafFunctions[i] != NULL; i++) {
+        if (name == leafFunctions[i]) {
             return true;
         }
     }
     return false;
 }
 
-std::string OMPToHClib::getClosureDef(std::string closureName,
-        bool isForasyncClosure, bool isAsyncClosure,
-        std::string contextName, std::vector<clang::ValueDecl *> *captured,
-        std::string bodyStr, bool isFuture, OMPClauses *clauses,
-        bool wrapBodyInFinish, bool waitAtEnd,
-        std::vector<const clang::ValueDecl *> *condVars) {
-    assert(!(isForasyncClosure && isAsyncClosure));
-    std::vector<OMPReductionVar> *reductions = clauses->getReductions();
-    std::vector<OMPVarInfo> *vars = clauses->getVarInfo(captured);
-
-    std::stringstream ss;
+static std::string getOMPPragmaCmd(std::string pragmaArgs) {
+    return pragmaArgs.substr(0, pragmaArgs.find(' '));
+}
 
-    ss << "\nstatic ";
-    if (isFuture) {
-        ss << "void *";
-    } else {
-        ss << "void ";
-    }
-    ss << closureName << "(void *____arg";
-    if (isForasyncClosure) {
-        for (int i = 0; i < condVars->size(); i++) {
-            ss << ", const int ___iter" << i;
+/*
+ * Find the calls made directly by stmt. found is set if any of them satisfies
+ * the given analysis without going through a function defined in this
+ * translation unit, and the definitions of all other non-leaf callees are
+ * appended to callees. If skipTaskBodies is set, omp task pragmas that have not
+ * been converted yet and their bodies are ignored.
+ */
+void OMPToHClib::collectCalls(const clang::Stmt *stmt, CallAnalysis analysis,
+        bool &found, std::vector<const clang::FunctionDecl *> *callees,
+        bool skipTaskBodies) {
+    if (skipTaskBodies) {
+        if (const clang::CompoundStmt *cmpd =
+                clang::dyn_cast<clang::CompoundStmt>(stmt)) {
+            for (clang::CompoundStmt::const_body_iterator i =
+                    cmpd->body_begin(), e = cmpd->body_end(); i != e; i++) {
+                const clang::CallExpr *call =
+                    clang::dyn_cast<clang::CallExpr>(*i);
+                if (call && call->getDirectCallee() &&
+                        call->getDirectCallee()->getNameAsString() ==
+                        "hclib_pragma_marker" &&
+                        getPragmaNameForMarker(call) == "omp" &&
+                        getOMPPragmaCmd(getPragmaArgumentsForMarker(call)) ==
+                        "task") {
+                    // Skip the marker and the task body that follows it
+                    i++;
+                    if (i == e) {
+                        break;
+                    }
+                    continue;
+                }
+                collectCalls(*i, analysis, found, callees, skipTaskBodies);
+            }
+            return;
         }
     }
-    ss << ") {\n";
 
-    ss << "    " << contextName << " *ctx = (" << contextName <<
-        " *)____arg;\n";
-    
-    for (std::vector<OMPVarInfo>::iterator i = vars->begin(), e = vars->end();
-            i != e; i++) {
-        OMPVarInfo var = *i;
-        clang::ValueDecl *decl = var.getDecl();
+    if (const clang::CallExpr *call = clang::dyn_cast<clang::CallExpr>(stmt)) {
+        const clang::FunctionDecl *callee = call->getDirectCallee();
+        const clang::FunctionDecl *definition = NULL;
+        const clang::CXXMethodDecl *method = (callee == NULL ? NULL :
+                clang::dyn_cast<clang::CXXMethodDecl>(callee));
+
+        if (callee == NULL || (method != NULL && method->isVirtual())) {
+            // We can't tell where an indirect call ends up
+            found = true;
+        } else if (callee->getNameAsString() == "hclib_pragma_marker") {
+            /*
+             * Of the pragmas that have not been converted yet, only tasks and
+             * nogroup taskloops can outlive the construct that created them
+             * and only taskwaits wait on a finish scope. The bodies of all
+             * pragmas are visited as ordinary statements below.
+             */
+            if (getPragmaNameForMarker(call) != "omp") {
+                found = true;
+            } else {
+                std::string ompPragma = getOMPPragmaCmd(
+                        getPragmaArgumentsForMarker(call));
+                if ((analysis == LAUNCHES_TASKS && (ompPragma == "task" ||
+                                (ompPragma == "taskloop" &&
+                                 getOMPClausesForMarker(call)->hasClause(
+                                     "nogroup")))) ||
+                        (analysis == WAITS_ON_FINISH &&
+                         ompPragma == "taskwait")) {
+                    found = true;
+                }
+            }
+        } else if (analysis == WAITS_ON_FINISH &&
+                callee->getNameAsString() == "hclib_end_finish") {
+            found = true;
+        } else if (isLeafFunction(callee)) {
+            // Nothing to do
+        } else if (callee->hasBody(definition)) {
+            callees->push_back(definition);
+        } else if (analysis == LAUNCHES_TASKS) {
+            // Unknown external function, assume the worst
+            found = true;
+        }
+    }
 
-        switch (var.getType()) {
-            case (CAPTURE_TYPE::SHARED):
-                // Do nothing, should refer to the captured address in the body
-                break;
-            case (CAPTURE_TYPE::PRIVATE):
-            case (CAPTURE_TYPE::FIRSTPRIVATE):
-            case (CAPTURE_TYPE::LASTPRIVATE):
-                ss << "    " << getUnpackStr(decl) << std::endl;
-                break;
-            default:
-                std::cerr << "Unsupported capture type" << std::endl;
-                exit(1);
+    for (clang::Stmt::const_child_iterator i = stmt->child_begin(),
+            e = stmt->child_end(); i != e; i++) {
+        const clang::Stmt *child = *i;
+        if (child != NULL) {
+            collectCalls(child, analysis, found, callees, skipTaskBodies);
         }
     }
+}
 
-    if (wrapBodyInFinish) {
-        /*
+/*
+ * Decide whether a call to fdecl satisfies the given analysis, by walking the
+ * call graph reachable from it. Recursion is handled by iterating to a fixed
+ * point over all reachable functions, whose results are then cached.
+ */
+bool OMPToHClib::functionSatisfies(const clang::FunctionDecl *fdecl,
+        CallAnalysis analysis) {
+    std::map<const clang::FunctionDecl *, bool> &cache =
+        analysisCache[analysis];
+    std::map<const clang::FunctionDecl *, bool>::iterator found =
+        cache.find(fdecl);
+    if (found != cache.end()) {
+        return found->second;
+    }
+
+    std::map<const clang::FunctionDecl *, bool> satisfies;
+    std::map<const clang::FunctionDecl *,
+        std::vector<const clang::FunctionDecl *> > calls;
+    std::vector<const clang::FunctionDecl *> worklist;
+    worklist.push_back(fdecl);
+
+    while (!worklist.empty()) {
+        const clang::FunctionDecl *curr = worklist.back();
+        worklist.pop_back();
+        if (satisfies.find(curr) != satisfies.end()) {
+            continue;
+        }
+
+        found = cache.find(curr);
+        if (found != cache.end()) {
+            // Already resolved by an earlier query
+            satisfies[curr] = found->second;
+            continue;
+        }
+
+        bool direct = false;
+        std::vector<const clang::FunctionDecl *> callees;
+        if (curr->getBody() == NULL) {
+            direct = true;
+        } else {
+            collectCalls(curr->getBody(), analysis, direct, &callees);
+        }
+        satisfies[curr] = direct;
+        calls[curr] = callees;
+        worklist.insert(worklist.end(), callees.begin(), callees.end());
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (std::map<const clang::FunctionDecl *,
+                std::vector<const clang::FunctionDecl *> >::iterator i =
+                calls.begin(), e = calls.end(); i != e; i++) {
+            if (satisfies[i->first]) {
+                continue;
+            }
+            for (std::vector<const clang::FunctionDecl *>::iterator ii =
+                    i->second.begin(), ee = i->second.end(); ii != ee; ii++) {
+                if (satisfies[*ii]) {
+                    satisfies[i->first] = true;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    cache.insert(satisfies.begin(), satisfies.end());
+    return cache[fdecl];
+}
+
+bool OMPToHClib::stmtSatisfies(const clang::Stmt *body, CallAnalysis analysis,
+        bool skipTaskBodies) {
+    bool direct = false;
+    std::vector<const clang::FunctionDecl *> callees;
+    collectCalls(body, analysis, direct, &callees, skipTaskBodies);
+    if (direct) {
+        return true;
+    }
+
+    for (std::vector<const clang::FunctionDecl *>::iterator i =
+            callees.begin(), e = callees.end(); i != e; i++) {
+        if (functionSatisfies(*i, analysis)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool OMPToHClib::canLaunchTasks(const clang::Stmt *body) {
+    return stmtSatisfies(body, LAUNCHES_TASKS, false);
+}
+
+/*
+ * Whether control can leave stmt other than by completing it: a return or a
+ * goto anywhere, or a break or continue that does not belong to a loop or
+ * switch inside stmt.
+ */
+static bool canJumpOut(const clang::Stmt *stmt, bool inLoop, bool inSwitch) {
+    if (clang::isa<clang::ReturnStmt>(stmt) ||
+            clang::isa<clang::GotoStmt>(stmt) ||
+            clang::isa<clang::IndirectGotoStmt>(stmt)) {
+        return true;
+    }
+    if (clang::isa<clang::BreakStmt>(stmt)) {
+        return !inLoop && !inSwitch;
+    }
+    if (clang::isa<clang::ContinueStmt>(stmt)) {
+        return !inLoop;
+    }
+
+    if (clang::isa<clang::ForStmt>(stmt) || clang::isa<clang::WhileStmt>(stmt) ||
+            clang::isa<clang::DoStmt>(stmt)) {
+        inLoop = true;
+    } else if (clang::isa<clang::SwitchStmt>(stmt)) {
+        inSwitch = true;
+    }
+    for (clang::Stmt::const_child_iterator i = stmt->child_begin(),
+            e = stmt->child_end(); i != e; i++) {
+        if (*i != NULL && canJumpOut(*i, inLoop, inSwitch)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Find the region whose tasks a taskwait at node would wait on, i.e. the body
+ * of the closest enclosing task or, failing that, of the enclosing function.
+ * Returns false if another construct sits in between, in which case the
+ * region is not tracked.
+ */
+bool OMPToHClib::getTaskRegion(PragmaNode *node, clang::FunctionDecl *func,
+        PragmaNode **owner, const clang::CompoundStmt **region) {
+    PragmaNode *curr = node->getParent();
+    const clang::Stmt *body = NULL;
+
+    if (curr->getPragmaName() == "root") {
+        *owner = NULL;
+        body = func->getBody();
+    } else if (curr->getPragmaName() == "omp_to_hclib" ||
+            (curr->getPragmaName() == "omp" &&
+             curr->getPragmaCmd() == "task")) {
+        *owner = curr;
+        body = curr->getBody();
+    } else {
+        return false;
+    }
+
+    *region = clang::dyn_cast<clang::CompoundStmt>(body);
+    return *region != NULL;
+}
+
+/*
+ * Whether each task spawned directly in region is certain to be waited on by a
+ * later taskwait in it, so that no task can still hold a pointer to the
+ * region's counter once its frame is gone. A task is covered if it sits, at
+ * any depth, in a statement of the compound holding the taskwait, ahead of the
+ * taskwait and with nothing in between able to jump past it.
+ */
+bool OMPToHClib::regionAwaitsAllTasks(PragmaNode *regionNode) {
+    std::vector<PragmaNode *> *children = regionNode->getChildren();
+    for (std::vector<PragmaNode *>::iterator t = children->begin(),
+            te = children->end(); t != te; t++) {
+        if ((*t)->getPragmaName() != "omp" ||
+                (*t)->getPragmaCmd() != "task") {
+            continue;
+        }
+
+        bool covered = false;
+        for (std::vector<PragmaNode *>::iterator w = children->begin(),
+                we = children->end(); w != we && !covered; w++) {
+            if ((*w)->getPragmaName() != "omp" ||
+                    (*w)->getPragmaCmd() != "taskwait") {
+                continue;
+            }
+
+            const clang::CompoundStmt *compound =
+                clang::dyn_cast<clang::CompoundStmt>(getParent(
+                            (*w)->getMarker()));
+            if (compound == NULL) {
+                continue;
+            }
+
+            // The statement of compound that the task is spawned from
+            const clang::Stmt *spawn = (*t)->getMarker();
+            while (parentMap.find(spawn) != parentMap.end() &&
+                    getParent(spawn) != compound) {
+                spawn = getParent(spawn);
+            }
+            if (parentMap.find(spawn) == parentMap.end()) {
+                continue;
+            }
+
+            bool inRange = false;
+            for (clang::CompoundStmt::const_body_iterator s =
+                    compound->body_begin(), se = compound->body_end();
+                    s != se; s++) {
+                if (*s == spawn) {
+                    inRange = true;
+                }
+                if (*s == (*w)->getMarker()) {
+                    covered = inRange;
+                    break;
+                }
+                if (inRange && canJumpOut(*s, false, false)) {
+                    break;
+                }
+            }
+        }
+
+        if (!covered) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * A taskwait that runs as waitStr. With task cutoffs, the other tasks that the
+ * worker executes meanwhile set its worker-local task depth, and the waiting
+ * code may even resume on another worker, so the depth that the code had
+ * before the wait is set again afterwards.
+ */
+std::string OMPToHClib::getTaskwaitStr(std::string waitStr, bool taskCutoff,
+        std::string &structDefs) {
+    if (!taskCutoff) {
+        return waitStr;
+    }
+
+    std::string def = getTaskDepthDef();
+    if (structDefs.find(def) == std::string::npos) {
+        structDefs += def;
+    }
+    return std::string(" { const int ____resume_depth = ") + TASK_DEPTH_VAR +
+        "; " + waitStr + TASK_DEPTH_VAR + "_set(____resume_depth); } ";
+}
+
+std::string OMPToHClib::getPendingChildrenCounter(PragmaNode *owner) {
+    if (owner == NULL) {
+        return std::string(PENDING_CHILDREN_PREFIX) + "root";
+    }
+    return PENDING_CHILDREN_PREFIX + owner->getLbl();
+}
+
+/*
+ * Record properties of the whole translation unit that affect how individual
+ * pragmas are converted: whether any taskwait is still to be lowered, and
+ * whether any task has a final clause, converted or not.
+ */
+void OMPToHClib::scanFunctionBody(const clang::Stmt *stmt) {
+    if (const clang::CallExpr *call = clang::dyn_cast<clang::CallExpr>(stmt)) {
+        const clang::FunctionDecl *callee = call->getDirectCallee();
+        if (callee && callee->getNameAsString() == "hclib_pragma_marker" &&
+                getPragmaNameForMarker(call) == "omp") {
+            std::string ompCmd = getOMPPragmaCmd(
+                    getPragmaArgumentsForMarker(call));
+            if (ompCmd == "taskwait") {
+                pendingTaskwaits = true;
+            } else if (ompCmd == "task" &&
+                    getOMPClausesForMarker(call)->hasClause("final")) {
+                anyFinalTasks = true;
+            }
+        }
+    } else if (const clang::DeclRefExpr *ref =
+            clang::dyn_cast<clang::DeclRefExpr>(stmt)) {
+        if (ref->getDecl()->getNameAsString() == FINAL_DEPTH_VAR) {
+            anyFinalTasks = true;
+        }
+    }
+
+    for (clang::Stmt::const_child_iterator i = stmt->child_begin(),
+            e = stmt->child_end(); i != e; i++) {
+        if (*i != NULL) {
+            scanFunctionBody(*i);
+        }
+    }
+}
+
+static void collectReferencedDecls(const clang::Stmt *stmt,
+        std::set<const clang::ValueDecl *> *decls) {
+    if (const clang::DeclRefExpr *ref =
+            clang::dyn_cast<clang::DeclRefExpr>(stmt)) {
+        decls->insert(ref->getDecl());
+    }
+
+    for (clang::Stmt::const_child_iterator i = stmt->child_begin(),
+            e = stmt->child_end(); i != e; i++) {
+        if (*i != NULL) {
+            collectReferencedDecls(*i, decls);
+        }
+    }
+}
+
+/*
+ * Build the code that runs a task's body in place of spawning it. Unless the
+ * task is mergeable, the private and firstprivate variables the body refers to
+ * are shadowed by copies so that it cannot modify the originals. Reduction
+ * variables, as on a parallel loop run in place, are updated directly. Returns
+ * false if one of those variables cannot be copied by a plain declaration.
+ * With redirectCalls, the body calls sequential clones where there are any.
+ */
+bool OMPToHClib::getInlineTaskStr(PragmaNode *node, OMPClauses *clauses,
+        std::string &inlineStr, bool redirectCalls) {
+    const clang::Stmt *body = node->getBody();
+    std::stringstream temps;
+    std::stringstream shadows;
+
+    if (!clauses->hasClause("mergeable")) {
+        std::set<const clang::ValueDecl *> referenced;
+        collectReferencedDecls(body, &referenced);
+
+        std::vector<std::string> reductionVars;
+        std::vector<OMPReductionVar> *reductions = clauses->getReductions();
+        for (std::vector<OMPReductionVar>::iterator i = reductions->begin(),
+                e = reductions->end(); i != e; i++) {
+            reductionVars.push_back(i->getVar());
+        }
+
+        std::vector<OMPVarInfo> *vars = clauses->getVarInfo(
+                node->getCaptures());
+        for (std::vector<OMPVarInfo>::iterator i = vars->begin(),
+                e = vars->end(); i != e; i++) {
+            OMPVarInfo var = *i;
+            clang::ValueDecl *decl = var.getDecl();
+            if (var.checkIsGlobal() ||
+                    referenced.find(decl) == referenced.end() ||
+                    (var.getType() != CAPTURE_TYPE::PRIVATE &&
+                     var.getType() != CAPTURE_TYPE::FIRSTPRIVATE) ||
+                    std::find(reductionVars.begin(), reductionVars.end(),
+                        decl->getNameAsString()) != reductionVars.end()) {
+                continue;
+            }
+
+            clang::QualType type = decl->getType();
+            if (type->isArrayType() || type->isReferenceType()) {
+                return false;
+            }
+
+            std::string varname = decl->getNameAsString();
+            if (var.getType() == CAPTURE_TYPE::FIRSTPRIVATE) {
+                temps << getDeclarationTypeStr(type, "____inline_" + varname,
+                        "", "") << " = " << varname << ";\n";
+                shadows << getDeclarationTypeStr(type, varname, "", "") <<
+                    " = ____inline_" << varname << "; ";
+            } else {
+                shadows << getDeclarationStr(decl) << " ";
+            }
+        }
+    }
+
+    std::stringstream ss;
+    ss << temps.str();
+    if (shadows.str().size() > 0) {
+        ss << "{ " << shadows.str() << "\n";
+    }
+    ss << (redirectCalls ? getRedirectedBodyStr(node) : stmtToString(body));
+    if (clang::isa<clang::Expr>(body)) {
+        // The semicolon of an expression statement is not part of the body
+        ss << ";";
+    }
+    ss << "\n";
+    if (shadows.str().size() > 0) {
+        ss << "}\n";
+    }
+    inlineStr = ss.str();
+    return true;
+}
+
+/*
+ * Definition of an int that each worker thread keeps for itself, e.g. the
+ * nesting depth of final tasks on the current worker. The definition is weak
+ * so that translation units share it, and is repeated before every function
+ * that needs it.
+ */
+std::string OMPToHClib::getWorkerLocalDef(std::string varname) {
+    std::stringstream ss;
+    ss << "#ifndef " << varname << "_DEFINED\n";
+    ss << "#define " << varname << "_DEFINED\n";
+    ss << "__attribute__((weak)) __thread int " << varname << " = 0;\n";
+    ss << "#endif\n";
+    return ss.str();
+}
+
+/*
+ * Whether func is a task-free copy of another function, see
+ * createSequentialClone.
+ */
+bool OMPToHClib::isSequentialClone(clang::FunctionDecl *func) {
+    std::string fname = func->getNameAsString();
+    std::string suffix = SEQ_CLONE_SUFFIX;
+    return fname.size() > suffix.size() &&
+        fname.compare(fname.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/*
+ * A function can be cloned into a sequential version if it is a plain
+ * function that spawns tasks, and if every pragma in it either disappears
+ * when run sequentially (task, taskwait) or keeps its meaning (critical,
+ * atomic).
+ */
+bool OMPToHClib::canCloneSequentially(clang::FunctionDecl *func,
+        PragmaNode *node, int &nTasks) {
+    if (node->getPragmaName() == "root") {
+        if (func->isMain() || clang::isa<clang::CXXMethodDecl>(func) ||
+                func->getTemplatedKind() !=
+                clang::FunctionDecl::TemplatedKind::TK_NonTemplate ||
+                isSequentialClone(func)) {
+            return false;
+        }
+    } else if (node->getPragmaName() == "omp") {
+        std::string ompCmd = node->getPragmaCmd();
+        if (ompCmd == "task") {
+            std::string inlineStr;
+            if (!getInlineTaskStr(node, getOMPClausesForMarker(
+                            node->getMarker()), inlineStr)) {
+                return false;
+            }
+            nTasks++;
+        } else if (ompCmd != "taskwait" && ompCmd != "critical" &&
+                ompCmd != "atomic") {
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    std::vector<PragmaNode *> *children = node->getChildren();
+    for (std::vector<PragmaNode *>::iterator i = children->begin(),
+            e = children->end(); i != e; i++) {
+        if (!canCloneSequentially(func, *i, nTasks)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Emit a copy of func named <func>____seq right after it, and a prototype for
+ * the copy ahead of the first declaration of func in this file. The pragmas in
+ * the copy are converted on later iterations, running every task in place and
+ * calling the sequential clones of other functions.
+ */
+void OMPToHClib::createSequentialClone(clang::FunctionDecl *func) {
+    const std::string fname = func->getNameAsString();
+    const std::string cloneName = fname + SEQ_CLONE_SUFFIX;
+
+    std::string text = rewriter->getRewrittenText(func->getSourceRange());
+    const unsigned start = SM->getFileOffset(func->getLocStart());
+    const unsigned nameOffset = SM->getFileOffset(func->getLocation()) - start;
+    const unsigned bodyOffset = SM->getFileOffset(
+            func->getBody()->getLocStart()) - start;
+    assert(text.substr(nameOffset, fname.size()) == fname);
+
+    std::string clone = text.substr(0, nameOffset) + cloneName +
+        text.substr(nameOffset + fname.size());
+    std::string prototype = clone.substr(0,
+            bodyOffset + cloneName.size() - fname.size());
+    while (prototype.size() > 0 && isspace(prototype[prototype.size() - 1])) {
+        prototype = prototype.substr(0, prototype.size() - 1);
+    }
+
+    clang::SourceLocation prototypeLoc = func->getLocStart();
+    for (clang::FunctionDecl::redecl_iterator i = func->redecls_begin(),
+            e = func->redecls_end(); i != e; i++) {
+        clang::SourceLocation loc = (*i)->getLocStart();
+        if (SM->isInMainFile(loc) &&
+                SM->isBeforeInTranslationUnit(loc, prototypeLoc)) {
+            prototypeLoc = loc;
+        }
+    }
+
+    bool failed = rewriter->InsertText(prototypeLoc, prototype + ";\n", true,
+            true);
+    assert(!failed);
+    failed = rewriter->ReplaceText(func->getLocEnd(), 1, "}\n\n" + clone);
+    assert(!failed);
+}
+
+/*
+ * The names of the callees, in source order, of the calls in stmt to functions
+ * that have a sequential clone.
+ */
+void OMPToHClib::collectCallsToClones(const clang::Stmt *stmt,
+        std::vector<const clang::DeclRefExpr *> *refs) {
+    if (const clang::CallExpr *call = clang::dyn_cast<clang::CallExpr>(stmt)) {
+        const clang::FunctionDecl *callee = call->getDirectCallee();
+        const clang::DeclRefExpr *ref = clang::dyn_cast<clang::DeclRefExpr>(
+                call->getCallee()->IgnoreParenImpCasts());
+        if (callee && ref && definedFunctions.find(callee->getNameAsString() +
+                    SEQ_CLONE_SUFFIX) != definedFunctions.end()) {
+            refs->push_back(ref);
+        }
+    }
+
+    // The callee comes before the arguments, so children keep source order
+    for (clang::Stmt::const_child_iterator i = stmt->child_begin(),
+            e = stmt->child_end(); i != e; i++) {
+        if (*i != NULL) {
+            collectCallsToClones(*i, refs);
+        }
+    }
+}
+
+/*
+ * In a sequential clone, call the sequential clones of other functions.
+ */
+void OMPToHClib::redirectCallsToClones(const clang::Stmt *stmt) {
+    std::vector<const clang::DeclRefExpr *> refs;
+    collectCallsToClones(stmt, &refs);
+    for (std::vector<const clang::DeclRefExpr *>::iterator i = refs.begin(),
+            e = refs.end(); i != e; i++) {
+        const std::string fname = (*i)->getDecl()->getNameAsString();
+        const bool failed = rewriter->ReplaceText((*i)->getLocation(),
+                fname.size(), fname + SEQ_CLONE_SUFFIX);
+        assert(!failed);
+    }
+}
+
+/*
+ * The same redirection for the body of a task that is run in place below its
+ * cutoff, whose text is also used for the closure and so cannot be rewritten
+ * in the AST. The text is instead pieced together around the callee names of
+ * the calls found in the AST. Calls inside pragmas of the body, which have
+ * been converted already, keep calling the original function.
+ */
+std::string OMPToHClib::getRedirectedBodyStr(PragmaNode *node) {
+    const clang::Stmt *body = node->getBody();
+    std::vector<const clang::DeclRefExpr *> refs;
+    collectCallsToClones(body, &refs);
+
+    std::string str = "";
+    clang::SourceLocation cursor = body->getLocStart();
+    std::vector<PragmaNode *> *children = node->getChildren();
+    for (std::vector<const clang::DeclRefExpr *>::iterator i = refs.begin(),
+            e = refs.end(); i != e; i++) {
+        clang::SourceLocation loc = (*i)->getLocation();
+        bool inChild = !loc.isFileID();
+        for (std::vector<PragmaNode *>::iterator c = children->begin(),
+                ce = children->end(); c != ce && !inChild; c++) {
+            inChild = !SM->isBeforeInTranslationUnit(loc,
+                    (*c)->getStartLoc()) &&
+                !SM->isBeforeInTranslationUnit((*c)->getEndLoc(), loc);
+        }
+        if (inChild) {
+            continue;
+        }
+
+        // Up to and including the callee name
+        const std::string fname = (*i)->getDecl()->getNameAsString();
+        str += rewriter->getRewrittenText(clang::SourceRange(cursor, loc));
+        assert(str.size() >= fname.size() &&
+                str.compare(str.size() - fname.size(), fname.size(),
+                    fname) == 0);
+        str += SEQ_CLONE_SUFFIX;
+        cursor = loc.getLocWithOffset(fname.size());
+    }
+    str += rewriter->getRewrittenText(clang::SourceRange(cursor,
+                body->getLocEnd()));
+    return str;
+}
+
+static bool containsPragmaCmd(PragmaNode *node, std::string cmd) {
+    if (node->getPragmaName() == "omp" && node->getPragmaCmd() == cmd) {
+        return true;
+    }
+    std::vector<PragmaNode *> *children = node->getChildren();
+    for (std::vector<PragmaNode *>::iterator i = children->begin(),
+            e = children->end(); i != e; i++) {
+        if (containsPragmaCmd(*i, cmd)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * The worker-local depth of the running task, and a setter for it that can be
+ * called where a task body's own copy of the depth shadows it.
+ */
+std::string OMPToHClib::getTaskDepthDef() {
+    std::stringstream ss;
+    ss << getWorkerLocalDef(TASK_DEPTH_VAR);
+    ss << "#ifndef " << TASK_DEPTH_VAR << "_set_DEFINED\n";
+    ss << "#define " << TASK_DEPTH_VAR << "_set_DEFINED\n";
+    ss << "static inline void " << TASK_DEPTH_VAR << "_set(int depth) { " <<
+        TASK_DEPTH_VAR << " = depth; }\n";
+    ss << "#endif\n";
+    return ss.str();
+}
+
+/*
+ * Condition under which the task at lbl runs in place and calls sequential
+ * clones instead of being spawned. It can be overridden per task at compile
+ * time, e.g. with an estimate of the size of the subproblem, or the default
+ * depth can be changed for all of them.
+ */
+std::string OMPToHClib::getCutoffDef(std::string lbl) {
+    std::stringstream ss;
+    ss << "#ifndef " << TASK_CUTOFF_DEPTH << "\n";
+    ss << "#define " << TASK_CUTOFF_DEPTH << " 10\n";
+    ss << "#endif\n";
+    ss << "#ifndef " << lbl << "_CUTOFF\n";
+    ss << "#define " << lbl << "_CUTOFF (" << TASK_DEPTH_VAR << " >= " <<
+        TASK_CUTOFF_DEPTH << ")\n";
+    ss << "#endif\n";
+    return ss.str();
+}
+
+/*
+ * Runtime support for tasks whose dependencies are resolved at compile time.
+ * Each tile of each tiled matrix records the last task that wrote it and the
+ * tasks that read it since. A new task is wired directly to the futures of
+ * its predecessors. The first one gates when it is scheduled and it waits on
+ * the others when it starts. Tiles are indexed directly by their row and
+ * column, growing the table as needed, and everything is freed at once when
+ * the enclosing function is done.
+ */
+std::string OMPToHClib::getTileGraphDef() {
+    std::stringstream ss;
+    ss << "#ifndef ____omp_tile_graph_DEFINED\n";
+    ss << "#define ____omp_tile_graph_DEFINED\n";
+    ss << "typedef struct ____omp_task_deps_t {\n";
+    ss << "    hclib_promise_t done;\n";
+    ss << "    int npreds;\n";
+    ss << "    int max_preds;\n";
+    ss << "    hclib_future_t **preds;\n";
+    ss << "    struct ____omp_task_deps_t *next;\n";
+    ss << "} ____omp_task_deps_t;\n";
+    ss << "typedef struct ____omp_tile_t {\n";
+    ss << "    hclib_future_t *writer;\n";
+    ss << "    int nreaders;\n";
+    ss << "    int max_readers;\n";
+    ss << "    hclib_future_t **readers;\n";
+    ss << "} ____omp_tile_t;\n";
+    ss << "typedef struct ____omp_tile_grid_t {\n";
+    ss << "    int rows;\n";
+    ss << "    int cols;\n";
+    ss << "    ____omp_tile_t *tiles;\n";
+    ss << "} ____omp_tile_grid_t;\n";
+    ss << "typedef struct ____omp_tile_graph_t {\n";
+    ss << "    ____omp_tile_grid_t *grids;\n";
+    ss << "    int ngrids;\n";
+    ss << "    ____omp_task_deps_t *tasks;\n";
+    ss << "} ____omp_tile_graph_t;\n";
+    ss << "static inline void ____omp_tile_graph_init(____omp_tile_graph_t " <<
+        "*graph, int ngrids) {\n";
+    ss << "    graph->grids = (____omp_tile_grid_t *)calloc(ngrids, " <<
+        "sizeof(____omp_tile_grid_t));\n";
+    ss << "    graph->ngrids = ngrids;\n";
+    ss << "    graph->tasks = NULL;\n";
+    ss << "}\n";
+    ss << "static inline void ____omp_future_append(hclib_future_t ***list, " <<
+        "int *n, int *max, hclib_future_t *future) {\n";
+    ss << "    if (*n == *max) {\n";
+    ss << "        *max = (*max == 0 ? 4 : 2 * *max);\n";
+    ss << "        *list = (hclib_future_t **)realloc(*list, *max * " <<
+        "sizeof(hclib_future_t *));\n";
+    ss << "    }\n";
+    ss << "    (*list)[(*n)++] = future;\n";
+    ss << "}\n";
+    ss << "static inline ____omp_tile_t *____omp_tile_lookup(" <<
+        "____omp_tile_graph_t *graph, int grid, int row, int col) {\n";
+    ss << "    ____omp_tile_grid_t *g = &graph->grids[grid];\n";
+    ss << "    if (row >= g->rows || col >= g->cols) {\n";
+    ss << "        const int rows = (row < g->rows ? g->rows : (row + 1 > " <<
+        "2 * g->rows ? row + 1 : 2 * g->rows));\n";
+    ss << "        const int cols = (col < g->cols ? g->cols : (col + 1 > " <<
+        "2 * g->cols ? col + 1 : 2 * g->cols));\n";
+    ss << "        ____omp_tile_t *tiles = (____omp_tile_t *)calloc(" <<
+        "(size_t)rows * cols, sizeof(____omp_tile_t));\n";
+    ss << "        int r;\n";
+    ss << "        for (r = 0; r < g->rows; r++) {\n";
+    ss << "            memcpy(tiles + (size_t)r * cols, g->tiles + (size_t)r * " <<
+        "g->cols, g->cols * sizeof(____omp_tile_t));\n";
+    ss << "        }\n";
+    ss << "        free(g->tiles);\n";
+    ss << "        g->tiles = tiles;\n";
+    ss << "        g->rows = rows;\n";
+    ss << "        g->cols = cols;\n";
+    ss << "    }\n";
+    ss << "    return &g->tiles[(size_t)row * g->cols + col];\n";
+    ss << "}\n";
+    ss << "static inline ____omp_task_deps_t *____omp_tile_task_create(" <<
+        "____omp_tile_graph_t *graph) {\n";
+    ss << "    ____omp_task_deps_t *deps = (____omp_task_deps_t *)malloc(" <<
+        "sizeof(____omp_task_deps_t));\n";
+    ss << "    hclib_promise_init(&deps->done);\n";
+    ss << "    deps->npreds = 0;\n";
+    ss << "    deps->max_preds = 0;\n";
+    ss << "    deps->preds = NULL;\n";
+    ss << "    deps->next = graph->tasks;\n";
+    ss << "    graph->tasks = deps;\n";
+    ss << "    return deps;\n";
+    ss << "}\n";
+    ss << "static inline void ____omp_tile_in(____omp_tile_graph_t *graph, " <<
+        "int grid, int row, int col, ____omp_task_deps_t *deps) {\n";
+    ss << "    ____omp_tile_t *tile = ____omp_tile_lookup(graph, grid, row, " <<
+        "col);\n";
+    ss << "    hclib_future_t *self = hclib_get_future_for_promise(" <<
+        "&deps->done);\n";
+    ss << "    if (tile->writer != NULL && tile->writer != self) {\n";
+    ss << "        ____omp_future_append(&deps->preds, &deps->npreds, " <<
+        "&deps->max_preds, tile->writer);\n";
+    ss << "    }\n";
+    ss << "    ____omp_future_append(&tile->readers, &tile->nreaders, " <<
+        "&tile->max_readers, self);\n";
+    ss << "}\n";
+    ss << "static inline void ____omp_tile_out(____omp_tile_graph_t *graph, " <<
+        "int grid, int row, int col, ____omp_task_deps_t *deps) {\n";
+    ss << "    ____omp_tile_t *tile = ____omp_tile_lookup(graph, grid, row, " <<
+        "col);\n";
+    ss << "    hclib_future_t *self = hclib_get_future_for_promise(" <<
+        "&deps->done);\n";
+    ss << "    int r;\n";
+    ss << "    if (tile->writer != NULL && tile->writer != self) {\n";
+    ss << "        ____omp_future_append(&deps->preds, &deps->npreds, " <<
+        "&deps->max_preds, tile->writer);\n";
+    ss << "    }\n";
+    ss << "    for (r = 0; r < tile->nreaders; r++) {\n";
+    ss << "        if (tile->readers[r] != self) {\n";
+    ss << "            ____omp_future_append(&deps->preds, &deps->npreds, " <<
+        "&deps->max_preds, tile->readers[r]);\n";
+    ss << "        }\n";
+    ss << "    }\n";
+    ss << "    tile->nreaders = 0;\n";
+    ss << "    tile->writer = self;\n";
+    ss << "}\n";
+    ss << "static inline hclib_future_t *____omp_tile_task_first(" <<
+        "____omp_task_deps_t *deps) {\n";
+    ss << "    return (deps->npreds > 0 ? deps->preds[0] : NULL);\n";
+    ss << "}\n";
+    ss << "static inline void ____omp_tile_task_wait(____omp_task_deps_t " <<
+        "*deps) {\n";
+    ss << "    int p;\n";
+    ss << "    for (p = 1; p < deps->npreds; p++) {\n";
+    ss << "        hclib_future_wait(deps->preds[p]);\n";
+    ss << "    }\n";
+    ss << "}\n";
+    ss << "static inline void ____omp_tile_task_done(____omp_task_deps_t " <<
+        "*deps) {\n";
+    ss << "    hclib_promise_put(&deps->done, NULL);\n";
+    ss << "}\n";
+    ss << "static inline void ____omp_tile_graph_free(____omp_tile_graph_t " <<
+        "*graph) {\n";
+    ss << "    int g;\n";
+    ss << "    for (g = 0; g < graph->ngrids; g++) {\n";
+    ss << "        size_t t;\n";
+    ss << "        for (t = 0; t < (size_t)graph->grids[g].rows * " <<
+        "graph->grids[g].cols; t++) {\n";
+    ss << "            free(graph->grids[g].tiles[t].readers);\n";
+    ss << "        }\n";
+    ss << "        free(graph->grids[g].tiles);\n";
+    ss << "    }\n";
+    ss << "    free(graph->grids);\n";
+    ss << "    while (graph->tasks != NULL) {\n";
+    ss << "        ____omp_task_deps_t *next = graph->tasks->next;\n";
+    ss << "        free(graph->tasks->preds);\n";
+    ss << "        free(graph->tasks);\n";
+    ss << "        graph->tasks = next;\n";
+    ss << "    }\n";
+    ss << "}\n";
+    ss << "#endif\n";
+    return ss.str();
+}
+
+static std::string trimSpaces(std::string str) {
+    size_t start = str.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = str.find_last_not_of(" \t\r\n");
+    return str.substr(start, end - start + 1);
+}
+
+static bool isSimpleOperand(std::string str) {
+    if (str.size() == 0) {
+        return false;
+    }
+    for (unsigned c = 0; c < str.size(); c++) {
+        if (!isalnum(str[c]) && str[c] != '_') {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Parse a call to a tile accessor, e.g. A(m, n), whose arguments are plain
+ * variables or constants.
+ */
+static bool parseTileAccessor(std::string str, std::string &grid,
+        std::string &row, std::string &col) {
+    str = trimSpaces(str);
+    size_t open = str.find("(");
+    size_t comma = str.find(",");
+    if (open == std::string::npos || comma == std::string::npos ||
+            comma < open || str[str.size() - 1] != ')') {
+        return false;
+    }
+
+    grid = trimSpaces(str.substr(0, open));
+    row = trimSpaces(str.substr(open + 1, comma - open - 1));
+    col = trimSpaces(str.substr(comma + 1, str.size() - comma - 2));
+    return isSimpleOperand(grid) && !isdigit(grid[0]) &&
+        isSimpleOperand(row) && isSimpleOperand(col);
+}
+
+/*
+ * Recognize a dependence on a whole tile of a tiled matrix: the item names a
+ * pointer, with an offset of zero, that is declared earlier in the same block
+ * as the task from a tile accessor such as PLASMA's A(m, n). Neither the
+ * pointer nor the accessor's arguments may be modified in between, so that
+ * the arguments still identify the tile when the task is created.
+ */
+bool OMPToHClib::getTileDependence(PragmaNode *node, std::string item,
+        std::string &grid, std::string &row, std::string &col) {
+    std::string name = item;
+    size_t openBrace = item.find("[");
+    if (openBrace != std::string::npos) {
+        size_t colon = item.find(":", openBrace);
+        if (colon == std::string::npos || trimSpaces(item.substr(
+                        openBrace + 1, colon - openBrace - 1)) != "0") {
+            return false;
+        }
+        name = item.substr(0, openBrace);
+    }
+    name = trimSpaces(name);
+
+    const clang::CompoundStmt *compound =
+        clang::dyn_cast_or_null<clang::CompoundStmt>(getParent(
+                    node->getMarker()));
+    if (compound == NULL) {
+        return false;
+    }
+    std::vector<const clang::Stmt *> stmts(compound->body_begin(),
+            compound->body_end());
+    int markerIndex = -1;
+    for (unsigned s = 0; s < stmts.size(); s++) {
+        if (stmts[s] == node->getMarker()) {
+            markerIndex = s;
+        }
+    }
+
+    std::set<const clang::ValueDecl *> written;
+    for (int s = markerIndex - 1; s >= 0; s--) {
+        const clang::DeclStmt *declStmt = clang::dyn_cast<clang::DeclStmt>(
+                stmts[s]);
+        const clang::VarDecl *var = NULL;
+        if (declStmt != NULL && declStmt->isSingleDecl()) {
+            var = clang::dyn_cast<clang::VarDecl>(declStmt->getSingleDecl());
+        }
+
+        if (var != NULL && var->getNameAsString() == name) {
+            if (!var->getType()->isPointerType() || !var->hasInit()) {
+                return false;
+            }
+            std::string declStr = stmtToString(declStmt);
+            size_t eq = declStr.find("=");
+            if (eq == std::string::npos) {
+                return false;
+            }
+            std::string initStr = trimSpaces(declStr.substr(eq + 1));
+            if (initStr.size() > 0 && initStr[initStr.size() - 1] == ';') {
+                initStr = initStr.substr(0, initStr.size() - 1);
+            }
+            if (!parseTileAccessor(initStr, grid, row, col)) {
+                return false;
+            }
+
+            for (std::set<const clang::ValueDecl *>::iterator i =
+                    written.begin(), e = written.end(); i != e; i++) {
+                std::string writtenName = (*i)->getNameAsString();
+                if (writtenName == row || writtenName == col) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        collectWrittenDecls(stmts[s], NULL, &written);
+        for (std::set<const clang::ValueDecl *>::iterator i = written.begin(),
+                e = written.end(); i != e; i++) {
+            if ((*i)->getNameAsString() == name) {
+                return false;
+            }
+        }
+    }
+    return false;
+}
+
+static bool containsReturn(const clang::Stmt *stmt) {
+    if (clang::isa<clang::ReturnStmt>(stmt)) {
+        return true;
+    }
+    for (clang::Stmt::const_child_iterator i = stmt->child_begin(),
+            e = stmt->child_end(); i != e; i++) {
+        if (*i != NULL && containsReturn(*i)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Dependencies can be wired up at compile time if every task with a depend
+ * clause in func is created directly by func, every item it depends on is a
+ * whole tile, and it is never run in place. All of the tasks are then
+ * converted in the same pass, and func waits for them before it returns so
+ * that none of them interacts with tasks created elsewhere. Tiles reached
+ * through different accessors are assumed to be disjoint, as they are in
+ * PLASMA where each accessor addresses the tiles of one matrix.
+ */
+bool OMPToHClib::canResolveDependsStatically(clang::FunctionDecl *func,
+        bool taskCutoff) {
+    tileGrids.clear();
+
+    bool found = false;
+    std::vector<PragmaNode *> worklist;
+    worklist.push_back(pragmaTree);
+    while (!worklist.empty()) {
+        PragmaNode *curr = worklist.back();
+        worklist.pop_back();
+        std::vector<PragmaNode *> *children = curr->getChildren();
+        worklist.insert(worklist.end(), children->begin(), children->end());
+
+        if (curr->getPragmaName() != "omp" || curr->getPragmaCmd() != "task") {
+            continue;
+        }
+        OMPClauses *clauses = getOMPClausesForMarker(curr->getMarker());
+        if (!clauses->hasClause("depend")) {
+            continue;
+        }
+        if (curr->getParent() != pragmaTree || curr->nchildren() > 0 ||
+                clauses->hasClause("if") || clauses->hasClause("final") ||
+                anyFinalTasks || taskCutoff) {
+            return false;
+        }
+
+        std::vector<SingleClauseArgs *> *depends = clauses->getArgs("depend");
+        for (std::vector<SingleClauseArgs *>::iterator i = depends->begin(),
+                e = depends->end(); i != e; i++) {
+            std::vector<std::string> *args = (*i)->getArgs();
+            for (unsigned a = 1; a < args->size(); a++) {
+                std::string grid, row, col;
+                if (!getTileDependence(curr, args->at(a), grid, row, col)) {
+                    return false;
+                }
+                if (std::find(tileGrids.begin(), tileGrids.end(), grid) ==
+                        tileGrids.end()) {
+                    tileGrids.push_back(grid);
+                }
+            }
+        }
+        found = true;
+    }
+
+    return found && !containsReturn(func->getBody());
+}
+
+/*
+ * Whether a previous pass already declared the tile graph at the top of
+ * funcBody.
+ */
+static bool declaresTileGraph(const clang::CompoundStmt *funcBody) {
+    if (funcBody == NULL || funcBody->size() == 0) {
+        return false;
+    }
+    const clang::DeclStmt *declStmt = clang::dyn_cast<clang::DeclStmt>(
+            funcBody->body_front());
+    if (declStmt == NULL || !declStmt->isSingleDecl()) {
+        return false;
+    }
+    const clang::NamedDecl *decl = clang::dyn_cast<clang::NamedDecl>(
+            declStmt->getSingleDecl());
+    return decl != NULL && decl->getNameAsString() == TILE_GRAPH_VAR;
+}
+
+/*
+ * Register a task with the tile graph, in place of having the runtime match
+ * the addresses it depends on. All of its inputs are registered before any
+ * of its outputs, so that a task never waits on itself.
+ */
+std::string OMPToHClib::getTileDepsSetup(PragmaNode *node,
+        OMPClauses *clauses) {
+    std::stringstream in;
+    std::stringstream out;
+    std::vector<SingleClauseArgs *> *depends = clauses->getArgs("depend");
+    for (std::vector<SingleClauseArgs *>::iterator i = depends->begin(),
+            e = depends->end(); i != e; i++) {
+        std::vector<std::string> *args = (*i)->getArgs();
+        std::string direction = args->at(0);
+        for (unsigned a = 1; a < args->size(); a++) {
+            std::string grid, row, col;
+            const bool isTile = getTileDependence(node, args->at(a), grid, row,
+                    col);
+            assert(isTile);
+            std::stringstream tile;
+            tile << "(&" << TILE_GRAPH_VAR << ", " << (std::find(
+                        tileGrids.begin(), tileGrids.end(), grid) -
+                    tileGrids.begin()) << ", " << row << ", " << col <<
+                ", ____deps);\n";
+
+            if (direction == "in" || direction == "inout") {
+                in << "____omp_tile_in" << tile.str();
+            }
+            if (direction == "out" || direction == "inout") {
+                out << "____omp_tile_out" << tile.str();
+            }
+        }
+    }
+
+    std::stringstream ss;
+    ss << "____omp_task_deps_t *____deps = ____omp_tile_task_create(&" <<
+        TILE_GRAPH_VAR << ");\n";
+    ss << in.str() << out.str();
+    ss << "new_ctx->____deps = ____deps;\n";
+    return ss.str();
+}
+
+/*
+ * Runtime support for bare parallel regions, which run as a team of one task
+ * per thread sharing a single context. A barrier suspends each arriving task
+ * on a promise that the last one to arrive satisfies, so that waiting workers
+ * go on executing other tasks. Consecutive barriers alternate between two
+ * promises, which is safe because a promise is only re-initialized once every
+ * thread has left the barrier that used it.
+ */
+std::string OMPToHClib::getTeamRuntimeDef() {
+    std::stringstream ss;
+    ss << "#ifndef ____omp_team_DEFINED\n";
+    ss << "#define ____omp_team_DEFINED\n";
+    ss << "typedef struct ____omp_team_t {\n";
+    ss << "    int nthreads;\n";
+    ss << "    int next_thread_num;\n";
+    ss << "    int arrived;\n";
+    ss << "    int episode;\n";
+    ss << "    int lock;\n";
+    ss << "    hclib_promise_t release[2];\n";
+    ss << "} ____omp_team_t;\n";
+    ss << "static inline void ____omp_team_init(____omp_team_t *team, " <<
+        "int nthreads) {\n";
+    ss << "    team->nthreads = (nthreads > 0 ? nthreads : 1);\n";
+    ss << "    team->next_thread_num = 0;\n";
+    ss << "    team->arrived = 0;\n";
+    ss << "    team->episode = 0;\n";
+    ss << "    team->lock = 0;\n";
+    ss << "    hclib_promise_init(&team->release[0]);\n";
+    ss << "}\n";
+    ss << "static inline int ____omp_team_join(____omp_team_t *team) {\n";
+    ss << "    return __atomic_fetch_add(&team->next_thread_num, 1, " <<
+        "__ATOMIC_RELAXED);\n";
+    ss << "}\n";
+    ss << "static inline int ____omp_team_size(____omp_team_t *team) {\n";
+    ss << "    return (team == NULL ? 1 : team->nthreads);\n";
+    ss << "}\n";
+    /*
+     * Reductions are combined under a lock private to the team, so that they
+     * neither serialize with unrelated critical sections nor deadlock against
+     * a reduction inside one. Nothing suspends while holding it.
+     */
+    ss << "static inline void ____omp_team_lock(____omp_team_t *team) {\n";
+    ss << "    if (team == NULL) return;\n";
+    ss << "    while (__atomic_exchange_n(&team->lock, 1, __ATOMIC_ACQUIRE)) " <<
+        "{ }\n";
+    ss << "}\n";
+    ss << "static inline void ____omp_team_unlock(____omp_team_t *team) {\n";
+    ss << "    if (team == NULL) return;\n";
+    ss << "    __atomic_store_n(&team->lock, 0, __ATOMIC_RELEASE);\n";
+    ss << "}\n";
+    ss << "static inline void ____omp_team_barrier(____omp_team_t *team) {\n";
+    ss << "    if (____omp_team_size(team) == 1) return;\n";
+    ss << "    const int episode = __atomic_load_n(&team->episode, " <<
+        "__ATOMIC_ACQUIRE);\n";
+    ss << "    hclib_promise_t *release = &team->release[episode & 1];\n";
+    ss << "    if (__atomic_add_fetch(&team->arrived, 1, __ATOMIC_ACQ_REL) == " <<
+        "team->nthreads) {\n";
+    ss << "        __atomic_store_n(&team->arrived, 0, __ATOMIC_RELAXED);\n";
+    ss << "        hclib_promise_init(&team->release[(episode + 1) & 1]);\n";
+    ss << "        __atomic_store_n(&team->episode, episode + 1, " <<
+        "__ATOMIC_RELEASE);\n";
+    ss << "        hclib_promise_put(release, NULL);\n";
+    ss << "    } else {\n";
+    ss << "        hclib_future_wait(hclib_get_future_for_promise(release));\n";
+    ss << "    }\n";
+    ss << "}\n";
+    /*
+     * Chunks of a statically scheduled loop are dealt out round-robin. Without
+     * a chunk size each thread gets a single contiguous block.
+     */
+    ss << "static inline int ____omp_team_static_chunk(____omp_team_t *team, " <<
+        "long chunk, long niters, long chunk_size, long *begin, " <<
+        "long *end) {\n";
+    ss << "    if (chunk_size <= 0) {\n";
+    ss << "        const long nthreads = ____omp_team_size(team);\n";
+    ss << "        chunk_size = (niters + nthreads - 1) / nthreads;\n";
+    ss << "    }\n";
+    ss << "    if (chunk_size <= 0 || chunk >= (niters + chunk_size - 1) / " <<
+        "chunk_size) return 0;\n";
+    ss << "    *begin = chunk * chunk_size;\n";
+    ss << "    *end = (*begin + chunk_size < niters ? *begin + chunk_size : " <<
+        "niters);\n";
+    ss << "    return 1;\n";
+    ss << "}\n";
+    ss << "#endif\n";
+    return ss.str();
+}
+
+/*
+ * The bare parallel region that a worksharing construct binds to, or NULL if
+ * it is not directly nested inside one.
+ */
+PragmaNode *OMPToHClib::getEnclosingTeam(PragmaNode *node) {
+    PragmaNode *parent = node->getParent();
+    if (parent == NULL || parent->getPragmaName() != "omp" ||
+            parent->getPragmaCmd() != "parallel") {
+        return NULL;
+    }
+    OMPClauses *clauses = getOMPClausesForMarker(parent->getMarker());
+    if (clauses->hasClause("for")) {
+        return NULL;
+    }
+    return parent;
+}
+
+/*
+ * Constructs inside a team refer to the team and to the number of the
+ * executing thread. Until the region itself is lowered, these are declared at
+ * the top of its body as a team of one, which the region's closure replaces
+ * with the real thing.
+ */
+void OMPToHClib::declareTeamVars(PragmaNode *team,
+        std::string &structDefs) {
+    const clang::CompoundStmt *region = clang::dyn_cast<clang::CompoundStmt>(
+            team->getBody());
+    if (region == NULL) {
+        std::cerr << "Expected a compound statement as the body of the " <<
+            "parallel region at line " << team->getStartLine() << std::endl;
+        exit(1);
+    }
+
+    if ((region->size() == 0 ||
+                getTeamVarDecl(region->body_front()) == NULL) &&
+            regionsWithTeamVars.find(region) == regionsWithTeamVars.end()) {
+        const bool failed = rewriter->InsertTextAfterToken(
+                region->getLBracLoc(), std::string(" ____omp_team_t *") +
+                TEAM_VAR + " = NULL; int " + THREAD_NUM_VAR + " = 0; ");
+        assert(!failed);
+        regionsWithTeamVars.insert(region);
+    }
+
+    std::string def = getTeamRuntimeDef();
+    if (structDefs.find(def) == std::string::npos) {
+        structDefs += def;
+    }
+}
+
+/*
+ * If stmt is one of the declarations added by declareTeamVars, return it.
+ */
+const clang::DeclStmt *OMPToHClib::getTeamVarDecl(const clang::Stmt *stmt) {
+    const clang::DeclStmt *declStmt = clang::dyn_cast_or_null<clang::DeclStmt>(
+            stmt);
+    if (declStmt == NULL || !declStmt->isSingleDecl()) {
+        return NULL;
+    }
+    const clang::NamedDecl *decl = clang::dyn_cast<clang::NamedDecl>(
+            declStmt->getSingleDecl());
+    if (decl == NULL || (decl->getNameAsString() != TEAM_VAR &&
+                decl->getNameAsString() != THREAD_NUM_VAR)) {
+        return NULL;
+    }
+    return declStmt;
+}
+
+/*
+ * Calls in the body of a team that ask for the executing thread's number or
+ * the size of the team are answered by the team itself.
+ */
+void OMPToHClib::replaceTeamQueries(const clang::Stmt *stmt) {
+    if (const clang::CallExpr *call = clang::dyn_cast<clang::CallExpr>(stmt)) {
+        const clang::FunctionDecl *callee = call->getDirectCallee();
+        std::string replacement;
+        if (callee != NULL && call->getNumArgs() == 0) {
+            if (callee->getNameAsString() == "omp_get_thread_num") {
+                replacement = THREAD_NUM_VAR;
+            } else if (callee->getNameAsString() == "omp_get_num_threads") {
+                replacement = std::string("____omp_team_size(") + TEAM_VAR +
+                    ")";
+            }
+        }
+        if (replacement.size() > 0) {
+            const bool failed = rewriter->ReplaceText(call->getSourceRange(),
+                    replacement);
+            assert(!failed);
+            return;
+        }
+    }
+
+    for (clang::Stmt::const_child_iterator i = stmt->child_begin(),
+            e = stmt->child_end(); i != e; i++) {
+        if (*i != NULL) {
+            replaceTeamQueries(*i);
+        }
+    }
+}
+
+/*
+ * Lower an omp for nested in a bare parallel region. Each thread of the team
+ * executes its share of the iterations, using private copies of the loop
+ * variable and of any private, firstprivate or reduction variables, and then
+ * waits at a team barrier unless the loop is nowait. Reductions are combined
+ * into the shared variable under the team's lock.
+ */
+std::string OMPToHClib::getTeamForStr(PragmaNode *node, OMPClauses *clauses) {
+    const clang::ForStmt *loop = clang::dyn_cast<clang::ForStmt>(
+            node->getBody());
+    if (loop == NULL) {
+        std::cerr << "Expected to find for loop inside omp for at line " <<
+            node->getStartLine() << " but found a " <<
+            node->getBody()->getStmtClassName() << " instead." << std::endl;
+        exit(1);
+    }
+    if (clauses->hasClause("collapse") &&
+            atoi(clauses->getSingleArg("collapse").c_str()) > 1) {
+        std::cerr << "Collapsed omp for at line " << node->getStartLine() <<
+            " inside a parallel region is unsupported" << std::endl;
+        exit(1);
+    }
+
+    const clang::ValueDecl *condVar = NULL;
+    std::string lowStr = getCondVarAndLowerBoundFromInit(loop->getInit(),
+            &condVar);
+    assert(condVar);
+    std::string highStr = getUpperBoundFromCond(loop->getCond(), condVar);
+    std::string strideStr = getStrideFromIncr(loop->getInc(), condVar);
+    std::string chunkStr = clauses->getScheduleChunk();
+    if (chunkStr.size() == 0) {
+        chunkStr = "0";
+    }
+
+    std::vector<OMPVarInfo> *vars = clauses->getVarInfo(node->getCaptures());
+    std::vector<OMPReductionVar> *reductions = clauses->getReductions();
+    std::set<std::string> reductionVars;
+    for (std::vector<OMPReductionVar>::iterator i = reductions->begin(),
+            e = reductions->end(); i != e; i++) {
+        reductionVars.insert(i->getVar());
+    }
+
+    /*
+     * The iteration space of a wider induction variable is walked in longs,
+     * which the chunks are always counted in.
+     */
+    const std::string iterType = (isWideInductionVar(condVar, Context) ?
+            "long" : "int");
+    std::stringstream outer;
+    std::stringstream inner;
+    outer << " { const " << iterType << " ____low = " << lowStr <<
+        "; const " << iterType << " ____high = " << highStr << "; const " <<
+        iterType << " ____stride = " << strideStr << "; ";
+    outer << "const " << iterType << " ____niters = (____high > ____low ? " <<
+        "(____high - ____low + ____stride - 1) / ____stride : 0); ";
+
+    inner << "{ " << getDeclarationTypeStr(condVar->getType(),
+            condVar->getNameAsString(), "", "") << "; ";
+    std::stringstream lastprivate;
+    for (std::vector<OMPVarInfo>::iterator i = vars->begin(), e = vars->end();
+            i != e; i++) {
+        OMPVarInfo var = *i;
+        clang::ValueDecl *decl = var.getDecl();
+        std::string name = decl->getNameAsString();
+        if (decl == condVar && var.getType() == CAPTURE_TYPE::LASTPRIVATE) {
+            // Left one step past the last iteration, as by the sequential loop
+            outer << getDeclarationTypeStr(decl->getType(),
+                    "____lastprivate_" + name, "(*", ")") << " = &(" << name <<
+                "); ";
+            lastprivate << "*____lastprivate_" << name << " = ____low + " <<
+                "____niters * ____stride; ";
+        }
+        if (decl == condVar || reductionVars.find(name) !=
+                reductionVars.end()) {
+            // Declared separately below
+            continue;
+        }
+
+        if (var.getType() == CAPTURE_TYPE::PRIVATE) {
+            inner << getDeclarationStr(decl) << " ";
+        } else if (var.getType() == CAPTURE_TYPE::FIRSTPRIVATE) {
+            if (decl->getType()->isArrayType()) {
+                std::cerr << "Array \"" << name << "\" in the firstprivate " <<
+                    "clause at line " << node->getStartLine() <<
+                    " is unsupported" << std::endl;
+                exit(1);
+            }
+            outer << getDeclarationTypeStr(decl->getType(),
+                    "____firstprivate_" + name, "", "") << " = " << name << "; ";
+            inner << getDeclarationTypeStr(decl->getType(), name, "", "") <<
+                " = ____firstprivate_" << name << "; ";
+        } else if (var.getType() == CAPTURE_TYPE::LASTPRIVATE) {
+            if (decl->getType()->isArrayType()) {
+                std::cerr << "Array \"" << name << "\" in the lastprivate " <<
+                    "clause at line " << node->getStartLine() <<
+                    " is unsupported" << std::endl;
+                exit(1);
+            }
+            outer << getDeclarationTypeStr(decl->getType(),
+                    "____lastprivate_" + name, "(*", ")") << " = &(" << name <<
+                "); ";
+            inner << getDeclarationTypeStr(decl->getType(), name, "", "") <<
+                "; ";
+            lastprivate << "*____lastprivate_" << name << " = " << name << "; ";
+        }
+    }
+
+    std::stringstream combine;
+    for (std::vector<OMPReductionVar>::iterator i = reductions->begin(),
+            e = reductions->end(); i != e; i++) {
+        OMPReductionVar red = *i;
+        std::string name = red.getVar();
+        clang::QualType type = getReductionDecl(red, vars)->getType();
+
+        outer << getDeclarationTypeStr(type, "____reduction_" + name, "(*",
+                ")") << " = &(" << name << "); ";
+        inner << getDeclarationTypeStr(type, name, "", "") << " = " <<
+            red.getInitialValue(type) << "; ";
+        combine << red.getCombineStr("(*____reduction_" + name + ")", name,
+                type) << " ";
+    }
+
+    inner << "long ____chunk, ____begin, ____end, ____iter; ";
+    inner << "for (____chunk = " << THREAD_NUM_VAR << "; " <<
+        "____omp_team_static_chunk(" << TEAM_VAR << ", ____chunk, " <<
+        "____niters, " << chunkStr << ", &____begin, &____end); " <<
+        "____chunk += ____omp_team_size(" << TEAM_VAR << ")) { ";
+    inner << "for (____iter = ____begin; ____iter < ____end; ____iter++) { ";
+    inner << condVar->getNameAsString() << " = ____low + ____iter * " <<
+        "____stride;\n";
+    inner << stmtToString(loop->getBody()) << "\n} ";
+    if (lastprivate.str().size() > 0) {
+        // Chunks run in order, so the one ending the loop runs last
+        inner << "if (____begin < ____end && ____end == ____niters) { " <<
+            lastprivate.str() << "} ";
+    }
+    inner << "} ";
+
+    if (!reductions->empty()) {
+        inner << "____omp_team_lock(" << TEAM_VAR << "); " << combine.str() <<
+            "____omp_team_unlock(" << TEAM_VAR << "); ";
+    }
+    inner << "} ";
+
+    outer << inner.str() << "} ";
+    if (!clauses->hasClause("nowait")) {
+        outer << "____omp_team_barrier(" << TEAM_VAR << "); ";
+    }
+    return outer.str();
+}
+
+/*
+ * Clauses of a parallel for that carry over to a fused parallel region, either
+ * on the region itself or on the omp for of each loop.
+ */
+static bool isFusibleClause(std::string clauseName) {
+    return clauseName == "for" || clauseName == "private" ||
+        clauseName == "firstprivate" || clauseName == "shared" ||
+        clauseName == "default" || clauseName == "schedule" ||
+        clauseName == "reduction" || clauseName == "num_threads" ||
+        clauseName == "collapse";
+}
+
+static std::string getClauseName(std::string clause) {
+    std::string clauseName = clause.substr(0, clause.find("("));
+    while (clauseName.size() > 0 &&
+            clauseName[clauseName.size() - 1] == ' ') {
+        clauseName = clauseName.substr(0, clauseName.size() - 1);
+    }
+    return clauseName;
+}
+
+/*
+ * Whether node is a parallel for whose loop could equally be run as a
+ * statically scheduled omp for by the threads of a team.
+ */
+bool OMPToHClib::isFusibleParallelFor(PragmaNode *node) {
+    if (node->getPragmaName() != "omp" || node->getPragmaCmd() != "parallel" ||
+            node->nchildren() > 0 || node->getBody() == NULL ||
+            !clang::isa<clang::ForStmt>(node->getBody())) {
+        return false;
+    }
+
+    OMPClauses *clauses = getOMPClausesForMarker(node->getMarker());
+    if (!clauses->hasClause("for")) {
+        return false;
+    }
+    for (std::map<std::string, std::vector<SingleClauseArgs *> *>::iterator i =
+            clauses->begin(), e = clauses->end(); i != e; i++) {
+        if (!isFusibleClause(i->first)) {
+            return false;
+        }
+    }
+
+    std::string kind = clauses->getScheduleKind();
+    if (kind != "" && kind != "static") {
+        return false;
+    }
+    if (clauses->getNumCollapsedLoops() > 1) {
+        return false;
+    }
+    if (clauses->hasClause("default") &&
+            clauses->getSingleArg("default") != "shared") {
+        return false;
+    }
+    return true;
+}
+
+/*
+ * The parallel for sibling of node that immediately follows (or precedes) it
+ * in the same compound statement, if any.
+ */
+PragmaNode *OMPToHClib::getAdjacentParallelFor(PragmaNode *node, bool next) {
+    const clang::CompoundStmt *compound =
+        clang::dyn_cast_or_null<clang::CompoundStmt>(getParent(
+                    node->getMarker()));
+    if (compound == NULL || node->getParent() == NULL) {
+        return NULL;
+    }
+
+    std::vector<const clang::Stmt *> stmts(compound->body_begin(),
+            compound->body_end());
+    const clang::Stmt *adjacent = NULL;
+    for (unsigned s = 0; s < stmts.size(); s++) {
+        if (stmts[s] == node->getMarker()) {
+            if (next && s + 2 < stmts.size()) {
+                adjacent = stmts[s + 2];
+            } else if (!next && s >= 2) {
+                adjacent = stmts[s - 2];
+            }
+            break;
+        }
+    }
+    if (adjacent == NULL) {
+        return NULL;
+    }
+
+    std::vector<PragmaNode *> *siblings = node->getParent()->getChildren();
+    for (std::vector<PragmaNode *>::iterator i = siblings->begin(),
+            e = siblings->end(); i != e; i++) {
+        if ((*i)->getMarker() == adjacent && isFusibleParallelFor(*i)) {
+            return *i;
+        }
+    }
+    return NULL;
+}
+
+bool OMPToHClib::canFuseParallelFors(PragmaNode *first, PragmaNode *second) {
+    if (!isFusibleParallelFor(first) || !isFusibleParallelFor(second)) {
+        return false;
+    }
+
+    // Both loops run on the same team
+    OMPClauses *firstClauses = getOMPClausesForMarker(first->getMarker());
+    OMPClauses *secondClauses = getOMPClausesForMarker(second->getMarker());
+    std::string firstThreads = (firstClauses->hasClause("num_threads") ?
+            firstClauses->getSingleArg("num_threads") : "");
+    std::string secondThreads = (secondClauses->hasClause("num_threads") ?
+            secondClauses->getSingleArg("num_threads") : "");
+    return firstThreads == secondThreads;
+}
+
+/*
+ * A load or store performed by a parallel loop. Element accesses record the
+ * variable they index into and the index into its first dimension. Accesses
+ * to a variable itself have a NULL index, and accesses through any other
+ * lvalue a NULL base.
+ */
+struct LoopAccess {
+    const clang::ValueDecl *base;
+    const clang::Expr *index;
+    clang::QualType type;
+    bool isWrite;
+};
+
+static void addLoopAccess(const clang::ValueDecl *base,
+        const clang::Expr *index, clang::QualType type, bool isWrite,
+        std::vector<LoopAccess> *accesses) {
+    LoopAccess access;
+    access.base = base;
+    access.index = index;
+    access.type = type;
+    access.isWrite = isWrite;
+    accesses->push_back(access);
+}
+
+static bool collectLoopAccesses(const clang::Stmt *stmt,
+        std::set<const clang::ValueDecl *> *locals,
+        std::vector<LoopAccess> *accesses);
+
+/*
+ * Strip the subscripts off of a (possibly multi-dimensional) array element,
+ * collecting their indices from the innermost dimension outwards.
+ */
+static const clang::Expr *getSubscriptRoot(
+        const clang::ArraySubscriptExpr *subscript,
+        std::vector<const clang::Expr *> *indices) {
+    indices->push_back(subscript->getIdx());
+    const clang::Expr *base = subscript->getBase()->IgnoreParenImpCasts();
+    while (const clang::ArraySubscriptExpr *outer =
+            clang::dyn_cast<clang::ArraySubscriptExpr>(base)) {
+        // Rows reached through pointers may overlap
+        if (!outer->getType()->isArrayType()) {
+            break;
+        }
+        indices->push_back(outer->getIdx());
+        base = outer->getBase()->IgnoreParenImpCasts();
+    }
+    return base;
+}
+
+/*
+ * Record an access to the object designated by lvalue. Only stores to loop
+ * locals and to elements of a named array or pointer can be analyzed, false
+ * is returned for any other store.
+ */
+static bool collectLvalueAccess(const clang::Expr *lvalue, bool isWrite,
+        std::set<const clang::ValueDecl *> *locals,
+        std::vector<LoopAccess> *accesses) {
+    lvalue = lvalue->IgnoreParens();
+
+    if (const clang::DeclRefExpr *ref =
+            clang::dyn_cast<clang::DeclRefExpr>(lvalue)) {
+        const clang::ValueDecl *decl = ref->getDecl();
+        if (!clang::isa<clang::VarDecl>(decl) ||
+                locals->find(decl) != locals->end()) {
+            return true;
+        }
+        if (isWrite) {
+            return false;
+        }
+        addLoopAccess(decl, NULL, lvalue->getType(), false, accesses);
+        return true;
+    }
+
+    if (const clang::ArraySubscriptExpr *subscript =
+            clang::dyn_cast<clang::ArraySubscriptExpr>(lvalue)) {
+        std::vector<const clang::Expr *> indices;
+        const clang::Expr *root = getSubscriptRoot(subscript, &indices);
+        for (std::vector<const clang::Expr *>::iterator i = indices.begin(),
+                e = indices.end(); i != e; i++) {
+            if (!collectLoopAccesses(*i, locals, accesses)) {
+                return false;
+            }
+        }
+
+        const clang::DeclRefExpr *ref = clang::dyn_cast<clang::DeclRefExpr>(
+                root);
+        if (ref != NULL && locals->find(ref->getDecl()) != locals->end()) {
+            // A private array, whereas a private pointer may point anywhere
+            if (ref->getDecl()->getType()->isArrayType()) {
+                return true;
+            }
+            ref = NULL;
+        }
+        if (ref != NULL) {
+            addLoopAccess(ref->getDecl(), indices.back(), lvalue->getType(),
+                    isWrite, accesses);
+            return true;
+        }
+        if (isWrite || !collectLoopAccesses(root, locals, accesses)) {
+            return false;
+        }
+        addLoopAccess(NULL, NULL, lvalue->getType(), false, accesses);
+        return true;
+    }
+
+    // e.g. *p or s->x
+    if (isWrite || !collectLoopAccesses(lvalue, locals, accesses)) {
+        return false;
+    }
+    addLoopAccess(NULL, NULL, lvalue->getType(), false, accesses);
+    return true;
+}
+
+/*
+ * Collect the loads and stores performed by stmt, other than to the given
+ * locals. Returns false if stmt performs any store that cannot be analyzed,
+ * including through calls to anything but builtins that are not passed a
+ * pointer.
+ */
+static bool collectLoopAccesses(const clang::Stmt *stmt,
+        std::set<const clang::ValueDecl *> *locals,
+        std::vector<LoopAccess> *accesses) {
+    if (const clang::BinaryOperator *bin =
+            clang::dyn_cast<clang::BinaryOperator>(stmt)) {
+        if (bin->isAssignmentOp()) {
+            if (bin->isCompoundAssignmentOp() && !collectLvalueAccess(
+                        bin->getLHS(), false, locals, accesses)) {
+                return false;
+            }
+            return collectLvalueAccess(bin->getLHS(), true, locals,
+                    accesses) && collectLoopAccesses(bin->getRHS(), locals,
+                    accesses);
+        }
+    } else if (const clang::UnaryOperator *unary =
+            clang::dyn_cast<clang::UnaryOperator>(stmt)) {
+        if (unary->isIncrementDecrementOp()) {
+            return collectLvalueAccess(unary->getSubExpr(), false, locals,
+                    accesses) && collectLvalueAccess(unary->getSubExpr(), true,
+                    locals, accesses);
+        }
+    } else if (const clang::ImplicitCastExpr *cast =
+            clang::dyn_cast<clang::ImplicitCastExpr>(stmt)) {
+        if (cast->getCastKind() == clang::CK_LValueToRValue) {
+            return collectLvalueAccess(cast->getSubExpr(), false, locals,
+                    accesses);
+        }
+    } else if (const clang::CallExpr *call =
+            clang::dyn_cast<clang::CallExpr>(stmt)) {
+        const clang::FunctionDecl *callee = call->getDirectCallee();
+        if (callee == NULL || callee->getBuiltinID() == 0 ||
+                clang::isa<clang::CXXOperatorCallExpr>(call) ||
+                clang::isa<clang::CXXMemberCallExpr>(call)) {
+            return false;
+        }
+        for (unsigned a = 0; a < call->getNumArgs(); a++) {
+            if (call->getArg(a)->getType()->isPointerType()) {
+                return false;
+            }
+        }
+    } else if (clang::isa<clang::CXXConstructExpr>(stmt) ||
+            clang::isa<clang::AsmStmt>(stmt)) {
+        return false;
+    }
+
+    for (clang::Stmt::const_child_iterator i = stmt->child_begin(),
+            e = stmt->child_end(); i != e; i++) {
+        if (*i != NULL && !collectLoopAccesses(*i, locals, accesses)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Collect the variables whose address may be taken somewhere in stmt, i.e.
+ * any variable referenced other than by loading from or storing to it.
+ */
+static void collectEscapedDecls(const clang::Stmt *stmt,
+        const clang::Stmt *parent,
+        std::set<const clang::ValueDecl *> *escaped) {
+    if (const clang::DeclRefExpr *ref =
+            clang::dyn_cast<clang::DeclRefExpr>(stmt)) {
+        bool escapes = true;
+        if (const clang::ImplicitCastExpr *cast =
+                clang::dyn_cast_or_null<clang::ImplicitCastExpr>(parent)) {
+            escapes = (cast->getCastKind() != clang::CK_LValueToRValue);
+        } else if (const clang::BinaryOperator *bin =
+                clang::dyn_cast_or_null<clang::BinaryOperator>(parent)) {
+            escapes = !(bin->isAssignmentOp() &&
+                    bin->getLHS()->IgnoreParens() == ref);
+        } else if (const clang::UnaryOperator *unary =
+                clang::dyn_cast_or_null<clang::UnaryOperator>(parent)) {
+            escapes = !unary->isIncrementDecrementOp();
+        }
+        if (escapes) {
+            escaped->insert(ref->getDecl());
+        }
+    }
+
+    // Parentheses do not change how their operand is used
+    const clang::Stmt *childParent = (clang::isa<clang::ParenExpr>(stmt) ?
+            parent : stmt);
+    for (clang::Stmt::const_child_iterator i = stmt->child_begin(),
+            e = stmt->child_end(); i != e; i++) {
+        if (*i != NULL) {
+            collectEscapedDecls(*i, childParent, escaped);
+        }
+    }
+}
+
+static bool isReferenceTo(const clang::Expr *expr,
+        const clang::ValueDecl *decl) {
+    if (expr == NULL) {
+        return false;
+    }
+    const clang::DeclRefExpr *ref = clang::dyn_cast<clang::DeclRefExpr>(
+            expr->IgnoreParenImpCasts());
+    return ref != NULL && ref->getDecl() == decl;
+}
+
+/*
+ * A local variable of the enclosing function whose address is never taken
+ * cannot be reached through any pointer.
+ */
+static bool isUnaliasedVariable(LoopAccess &access,
+        std::set<const clang::ValueDecl *> *escaped) {
+    if (access.base == NULL || access.index != NULL) {
+        return false;
+    }
+    const clang::VarDecl *var = clang::dyn_cast<clang::VarDecl>(access.base);
+    return var != NULL && !var->hasGlobalStorage() &&
+        escaped->find(var) == escaped->end();
+}
+
+/*
+ * Whether two accesses by different loops may touch the same object in
+ * different iterations. Elements indexed by the loop variable of each loop
+ * are only touched by the same iteration of both.
+ */
+static bool accessesMayConflict(LoopAccess &a, const clang::ValueDecl *condA,
+        LoopAccess &b, const clang::ValueDecl *condB,
+        std::set<const clang::ValueDecl *> *escaped,
+        clang::ASTContext *Context) {
+    if (a.base != NULL && a.base == b.base) {
+        return !(isReferenceTo(a.index, condA) &&
+                isReferenceTo(b.index, condB));
+    }
+    if (a.base != NULL && b.base != NULL &&
+            a.base->getType()->isArrayType() &&
+            b.base->getType()->isArrayType()) {
+        // Distinct arrays
+        return false;
+    }
+    if (isUnaliasedVariable(a, escaped) || isUnaliasedVariable(b, escaped)) {
+        return false;
+    }
+    return mayAliasTypes(a.type, b.type, Context);
+}
+
+/*
+ * Whether the threads of a team can move on from the first loop to the second
+ * without waiting for each other. This holds if both loops divide the same
+ * iterations among threads in the same way and no iteration of the second
+ * loop touches anything written by another iteration of the first, or the
+ * other way around.
+ */
+bool OMPToHClib::loopsAreIndependent(PragmaNode *first, PragmaNode *second,
+        std::set<const clang::ValueDecl *> *escaped) {
+    PragmaNode *nodes[2] = { first, second };
+    const clang::ValueDecl *condVars[2] = { NULL, NULL };
+    std::string domains[2];
+    std::vector<LoopAccess> accesses[2];
+
+    for (int n = 0; n < 2; n++) {
+        OMPClauses *clauses = getOMPClausesForMarker(nodes[n]->getMarker());
+        if (!clauses->getReductions()->empty()) {
+            return false;
+        }
+
+        const clang::ForStmt *loop = clang::dyn_cast<clang::ForStmt>(
+                nodes[n]->getBody());
+        std::string lowStr = getCondVarAndLowerBoundFromInit(loop->getInit(),
+                &condVars[n]);
+        assert(condVars[n]);
+        domains[n] = lowStr + ";" + getUpperBoundFromCond(loop->getCond(),
+                condVars[n]) + ";" + getStrideFromIncr(loop->getInc(),
+                condVars[n]) + ";" + clauses->getScheduleChunk();
+
+        std::set<const clang::ValueDecl *> locals;
+        collectLocalDecls(loop, &locals);
+        locals.insert(condVars[n]);
+        std::vector<OMPVarInfo> *vars = clauses->getVarInfo(
+                nodes[n]->getCaptures());
+        for (std::vector<OMPVarInfo>::iterator i = vars->begin(),
+                e = vars->end(); i != e; i++) {
+            OMPVarInfo var = *i;
+            if (var.getType() == CAPTURE_TYPE::PRIVATE ||
+                    var.getType() == CAPTURE_TYPE::FIRSTPRIVATE) {
+                locals.insert(var.getDecl());
+            }
+        }
+
+        // The loop bounds are included, as each thread evaluates them
+        if (!collectLoopAccesses(loop, &locals, &accesses[n])) {
+            return false;
+        }
+    }
+
+    if (domains[0] != domains[1]) {
+        return false;
+    }
+
+    for (std::vector<LoopAccess>::iterator i = accesses[0].begin(),
+            e = accesses[0].end(); i != e; i++) {
+        for (std::vector<LoopAccess>::iterator j = accesses[1].begin(),
+                ee = accesses[1].end(); j != ee; j++) {
+            if ((i->isWrite || j->isWrite) && accessesMayConflict(*i,
+                        condVars[0], *j, condVars[1], escaped, Context)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*
+ * The arguments of the omp for that a fusible parallel for turns into inside a
+ * team region. Its shared variables and its num_threads clause are collected
+ * for the region.
+ */
+std::string OMPToHClib::getTeamForArgs(PragmaNode *loop,
+        std::vector<std::string> *shared, std::string &numThreads) {
+    std::vector<std::string> clauses = OMPClauses::splitClauses(
+            loop->getPragmaArguments());
+
+    std::string forArgs = "for";
+    for (std::vector<std::string>::iterator i = clauses.begin(),
+            e = clauses.end(); i != e; i++) {
+        std::string clauseName = getClauseName(*i);
+        if (clauseName == "private" || clauseName == "firstprivate" ||
+                clauseName == "reduction" || clauseName == "schedule" ||
+                clauseName == "collapse") {
+            forArgs += " " + *i;
+        } else if (clauseName == "num_threads") {
+            numThreads = " " + *i;
+        }
+    }
+
+    OMPClauses *parsed = getOMPClausesForMarker(loop->getMarker());
+    if (parsed->hasClause("shared")) {
+        std::vector<std::string> *vars = parsed->getFlattenedArgsList(
+                "shared");
+        for (std::vector<std::string>::iterator i = vars->begin(),
+                e = vars->end(); i != e; i++) {
+            if (std::find(shared->begin(), shared->end(), *i) ==
+                    shared->end()) {
+                shared->push_back(*i);
+            }
+        }
+    }
+    return forArgs;
+}
+
+static std::string getTeamParallelArgs(std::vector<std::string> *shared,
+        std::string privateClause, std::string numThreads) {
+    std::string parallelArgs = "parallel";
+    if (!shared->empty()) {
+        parallelArgs += " shared(";
+        for (unsigned s = 0; s < shared->size(); s++) {
+            parallelArgs += (s == 0 ? "" : ", ") + shared->at(s);
+        }
+        parallelArgs += ")";
+    }
+    if (privateClause.size() > 0) {
+        parallelArgs += " " + privateClause;
+    }
+    return parallelArgs + numThreads;
+}
+
+/*
+ * Rewrite a sequence of adjacent parallel for loops into a single parallel
+ * region with an omp for per loop, so that only one team is launched for all
+ * of them. Threads wait for each other between two loops unless the second
+ * only depends on iterations of earlier loops that the same thread executed.
+ */
+std::string OMPToHClib::getFusedParallelForStr(
+        std::vector<PragmaNode *> *loops, const clang::Stmt *funcBody) {
+    std::set<const clang::ValueDecl *> escaped;
+    collectEscapedDecls(funcBody, NULL, &escaped);
+
+    // The region ends with every thread done, so the last loop never waits
+    std::vector<bool> nowait(loops->size(), false);
+    nowait[loops->size() - 1] = true;
+    unsigned phaseStart = 0;
+    for (unsigned l = 1; l < loops->size(); l++) {
+        bool independent = true;
+        for (unsigned p = phaseStart; p < l && independent; p++) {
+            independent = loopsAreIndependent(loops->at(p), loops->at(l),
+                    &escaped);
+        }
+        if (independent) {
+            nowait[l - 1] = true;
+        } else {
+            phaseStart = l;
+        }
+    }
+
+    std::vector<std::string> shared;
+    std::string numThreads = "";
+    std::stringstream loopsStr;
+    for (unsigned l = 0; l < loops->size(); l++) {
+        PragmaNode *loop = loops->at(l);
+        std::string forArgs = getTeamForArgs(loop, &shared, numThreads);
+        if (nowait[l]) {
+            forArgs += " nowait";
+        }
+
+        loopsStr << "hclib_pragma_marker(\"omp\", \"" << forArgs << "\", \"" <<
+            loop->getLbl() << "\");\n" << stmtToString(loop->getBody()) <<
+            "\n";
+    }
+
+    std::string parallelArgs = getTeamParallelArgs(&shared, "", numThreads);
+
+    std::stringstream ss;
+    ss << "hclib_pragma_marker(\"omp\", \"" << parallelArgs << "\", \"" <<
+        loops->at(0)->getLbl() << "_fused\");\n";
+    ss << "{\n" << loopsStr.str() << "}\n";
+    return ss.str();
+}
+
+static bool containsStmt(const clang::Stmt *stmt,
+        const clang::Stmt *target) {
+    if (stmt == target) {
+        return true;
+    }
+    for (clang::Stmt::const_child_iterator i = stmt->child_begin(),
+            e = stmt->child_end(); i != e; i++) {
+        if (*i != NULL && containsStmt(*i, target)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool isReferencedAfter(const clang::Stmt *stmt,
+        const clang::ValueDecl *decl, clang::SourceLocation loc,
+        clang::SourceManager *SM) {
+    if (const clang::DeclRefExpr *ref =
+            clang::dyn_cast<clang::DeclRefExpr>(stmt)) {
+        if (ref->getDecl() == decl &&
+                SM->isBeforeInTranslationUnit(loc, ref->getLocStart())) {
+            return true;
+        }
+    }
+    for (clang::Stmt::const_child_iterator i = stmt->child_begin(),
+            e = stmt->child_end(); i != e; i++) {
+        if (*i != NULL && isReferencedAfter(*i, decl, loc, SM)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * The sequential loop, e.g. over time steps, whose body directly contains the
+ * parallel for node, if any.
+ */
+const clang::Stmt *OMPToHClib::getTimeLoop(PragmaNode *node) {
+    const clang::CompoundStmt *compound =
+        clang::dyn_cast_or_null<clang::CompoundStmt>(getParent(
+                    node->getMarker()));
+    if (compound == NULL) {
+        return NULL;
+    }
+    const clang::Stmt *loop = getParent(compound);
+    if (loop == NULL) {
+        return NULL;
+    }
+
+    if (const clang::ForStmt *forStmt = clang::dyn_cast<clang::ForStmt>(loop)) {
+        if (forStmt->getBody() == compound) return loop;
+    } else if (const clang::WhileStmt *whileStmt =
+            clang::dyn_cast<clang::WhileStmt>(loop)) {
+        if (whileStmt->getBody() == compound) return loop;
+    } else if (const clang::DoStmt *doStmt =
+            clang::dyn_cast<clang::DoStmt>(loop)) {
+        if (doStmt->getBody() == compound) return loop;
+    }
+    return NULL;
+}
+
+static const clang::CompoundStmt *getLoopBody(const clang::Stmt *loop) {
+    const clang::Stmt *body = NULL;
+    if (const clang::ForStmt *forStmt = clang::dyn_cast<clang::ForStmt>(loop)) {
+        body = forStmt->getBody();
+    } else if (const clang::WhileStmt *whileStmt =
+            clang::dyn_cast<clang::WhileStmt>(loop)) {
+        body = whileStmt->getBody();
+    } else if (const clang::DoStmt *doStmt =
+            clang::dyn_cast<clang::DoStmt>(loop)) {
+        body = doStmt->getBody();
+    }
+    return clang::dyn_cast_or_null<clang::CompoundStmt>(body);
+}
+
+/*
+ * The loop that makes up the body of a loop, possibly enclosed in braces, as
+ * in a perfect loop nest.
+ */
+static const clang::ForStmt *getNestedLoop(const clang::Stmt *body) {
+    if (const clang::CompoundStmt *compound =
+            clang::dyn_cast_or_null<clang::CompoundStmt>(body)) {
+        if (compound->size() != 1) {
+            return NULL;
+        }
+        body = *compound->body_begin();
+    }
+    return clang::dyn_cast_or_null<clang::ForStmt>(body);
+}
+
+/*
+ * A time step loop can run inside a single team region, instead of forking
+ * and joining a team for each parallel for in each step, if:
+ *
+ *   1. The parallel fors directly in its body can all be fused into a team
+ *      and nothing else in it is a pragma.
+ *   2. Nothing in its body jumps out of it.
+ *   3. The loop control, which every thread of the team evaluates, is not
+ *      written by the parallel fors, and the induction variable of a for loop
+ *      is only written by its increment and unused after the loop.
+ *   4. Each variable declared directly in its body is either only used by the
+ *      sequential statements around it, or is a declaration without
+ *      initializer of a variable that the parallel fors use privately.
+ *
+ * The parallel fors are returned in loops.
+ */
+bool OMPToHClib::canHoistTeam(PragmaNode *node, const clang::Stmt *timeLoop,
+        std::vector<PragmaNode *> *loops, const clang::Stmt *funcBody) {
+    PragmaNode *parent = node->getParent();
+    if (parent == NULL || (parent->getPragmaName() == "omp" &&
+                parent->getPragmaCmd() == "parallel")) {
+        return false;
+    }
+    const clang::CompoundStmt *body = getLoopBody(timeLoop);
+    assert(body != NULL);
+
+    std::vector<const clang::Stmt *> stmts(body->body_begin(),
+            body->body_end());
+    std::set<const clang::Stmt *> markers;
+    std::vector<PragmaNode *> *siblings = parent->getChildren();
+    for (std::vector<PragmaNode *>::iterator i = siblings->begin(),
+            e = siblings->end(); i != e; i++) {
+        if (!containsStmt(timeLoop, (*i)->getMarker())) {
+            continue;
+        }
+        if (!isFusibleParallelFor(*i) || (!loops->empty() &&
+                    !canFuseParallelFors(loops->front(), *i)) ||
+                getParent((*i)->getMarker()) != body) {
+            return false;
+        }
+        loops->push_back(*i);
+        markers.insert((*i)->getMarker());
+    }
+
+    // Variables that the parallel fors write or use privately
+    std::set<const clang::ValueDecl *> loopWritten;
+    std::set<std::string> loopPrivate;
+    std::set<const clang::ValueDecl *> seqWritten;
+    for (unsigned s = 0; s < stmts.size(); s++) {
+        if (markers.find(stmts[s]) != markers.end()) {
+            const clang::ForStmt *loop = clang::dyn_cast<clang::ForStmt>(
+                    stmts[s + 1]);
+            collectWrittenDecls(loop, NULL, &loopWritten);
+
+            const clang::ValueDecl *condVar = NULL;
+            getCondVarAndLowerBoundFromInit(loop->getInit(), &condVar);
+            loopPrivate.insert(condVar->getNameAsString());
+            OMPClauses *clauses = getOMPClausesForMarker(
+                    clang::dyn_cast<clang::CallExpr>(stmts[s]));
+            if (clauses->hasClause("private")) {
+                std::vector<std::string> *vars =
+                    clauses->getFlattenedArgsList("private");
+                loopPrivate.insert(vars->begin(), vars->end());
+            }
+            s++;
+        } else {
+            if (canJumpOut(stmts[s], false, false)) {
+                return false;
+            }
+            collectWrittenDecls(stmts[s], NULL, &seqWritten);
+        }
+    }
+
+    // The sequential statements between two parallel fors form one run
+    std::vector<int> runs;
+    int run = 0;
+    for (unsigned s = 0; s < stmts.size(); s++) {
+        if (markers.find(stmts[s]) != markers.end()) {
+            run++;
+        }
+        runs.push_back(run);
+    }
+
+    for (unsigned s = 0; s < stmts.size(); s++) {
+        const clang::DeclStmt *declStmt = clang::dyn_cast<clang::DeclStmt>(
+                stmts[s]);
+        if (declStmt == NULL) {
+            continue;
+        }
+        for (clang::DeclStmt::const_decl_iterator d = declStmt->decl_begin(),
+                e = declStmt->decl_end(); d != e; d++) {
+            const clang::VarDecl *var = clang::dyn_cast<clang::VarDecl>(*d);
+            if (var == NULL) {
+                return false;
+            }
+            std::vector<const clang::ValueDecl *> decl(1, var);
+            bool inLoops = false;
+            bool inOtherRuns = false;
+            for (unsigned t = 0; t < stmts.size(); t++) {
+                if (markers.find(stmts[t]) != markers.end() &&
+                        referencesAnyDecl(stmts[t + 1], &decl)) {
+                    inLoops = true;
+                } else if (runs[t] != runs[s] &&
+                        referencesAnyDecl(stmts[t], &decl)) {
+                    inOtherRuns = true;
+                }
+            }
+            if (!inLoops && inOtherRuns) {
+                return false;
+            }
+            if (inLoops && (var->hasInit() || seqWritten.find(var) !=
+                        seqWritten.end() || loopPrivate.find(
+                            var->getNameAsString()) == loopPrivate.end())) {
+                return false;
+            }
+        }
+    }
+
+    std::vector<const clang::ValueDecl *> inductionVar;
+    std::vector<const clang::Stmt *> control;
+    if (const clang::ForStmt *forStmt =
+            clang::dyn_cast<clang::ForStmt>(timeLoop)) {
+        if (forStmt->getCond() == NULL || forStmt->getInc() == NULL) {
+            return false;
+        }
+        control.push_back(forStmt->getCond());
+        control.push_back(forStmt->getInc());
+
+        std::set<const clang::ValueDecl *> incWritten;
+        collectWrittenDecls(forStmt->getInc(), NULL, &incWritten);
+        if (incWritten.size() != 1) {
+            return false;
+        }
+        const clang::ValueDecl *var = *incWritten.begin();
+        if (seqWritten.find(var) != seqWritten.end() ||
+                loopWritten.find(var) != loopWritten.end()) {
+            return false;
+        }
+        if ((forStmt->getInit() == NULL ||
+                    !clang::isa<clang::DeclStmt>(forStmt->getInit())) &&
+                isReferencedAfter(funcBody, var, timeLoop->getLocEnd(), SM)) {
+            return false;
+        }
+        inductionVar.push_back(var);
+    } else if (const clang::WhileStmt *whileStmt =
+            clang::dyn_cast<clang::WhileStmt>(timeLoop)) {
+        control.push_back(whileStmt->getCond());
+    } else {
+        control.push_back(clang::dyn_cast<clang::DoStmt>(
+                    timeLoop)->getCond());
+    }
+
+    for (std::set<const clang::ValueDecl *>::iterator i = loopWritten.begin(),
+            e = loopWritten.end(); i != e; i++) {
+        std::vector<const clang::ValueDecl *> decl(1, *i);
+        for (unsigned c = 0; c < control.size(); c++) {
+            if (referencesAnyDecl(control[c], &decl) &&
+                    loopPrivate.find((*i)->getNameAsString()) ==
+                    loopPrivate.end()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*
+ * Run a time step loop inside one team region. Every thread of the team
+ * executes the loop, taking its share of each parallel for in turn as an omp
+ * for, while the statements in between are executed by the first thread
+ * followed by a team barrier. If those statements start the body and update
+ * the loop control, a barrier first makes sure every thread has evaluated it.
+ */
+std::string OMPToHClib::getPersistentTeamStr(const clang::Stmt *timeLoop,
+        std::vector<PragmaNode *> *loops) {
+    const clang::CompoundStmt *body = getLoopBody(timeLoop);
+    std::vector<const clang::Stmt *> stmts(body->body_begin(),
+            body->body_end());
+    std::set<const clang::Stmt *> markers;
+    for (std::vector<PragmaNode *>::iterator i = loops->begin(),
+            e = loops->end(); i != e; i++) {
+        markers.insert((*i)->getMarker());
+    }
+
+    std::vector<const clang::Stmt *> control;
+    std::string privateClause = "";
+    std::string header;
+    std::string footer = "}\n";
+    if (const clang::ForStmt *forStmt =
+            clang::dyn_cast<clang::ForStmt>(timeLoop)) {
+        control.push_back(forStmt->getCond());
+        control.push_back(forStmt->getInc());
+        if (forStmt->getInit() == NULL ||
+                !clang::isa<clang::DeclStmt>(forStmt->getInit())) {
+            /*
+             * Every thread steps its own copy of the induction variable,
+             * which starts from its value before the loop if the loop has no
+             * init clause.
+             */
+            std::set<const clang::ValueDecl *> incWritten;
+            collectWrittenDecls(forStmt->getInc(), NULL, &incWritten);
+            privateClause = std::string(forStmt->getInit() == NULL ?
+                    "firstprivate" : "private") + "(" +
+                (*incWritten.begin())->getNameAsString() + ")";
+        }
+        header = rewriter->getRewrittenText(clang::SourceRange(
+                    forStmt->getLocStart(), body->getLBracLoc())) + "\n";
+    } else if (const clang::WhileStmt *whileStmt =
+            clang::dyn_cast<clang::WhileStmt>(timeLoop)) {
+        control.push_back(whileStmt->getCond());
+        header = rewriter->getRewrittenText(clang::SourceRange(
+                    whileStmt->getLocStart(), body->getLBracLoc())) + "\n";
+    } else {
+        const clang::DoStmt *doStmt = clang::dyn_cast<clang::DoStmt>(timeLoop);
+        control.push_back(doStmt->getCond());
+        header = "do {\n";
+        footer = rewriter->getRewrittenText(clang::SourceRange(
+                    body->getRBracLoc(), doStmt->getLocEnd())) + ";\n";
+    }
+
+    std::vector<std::string> shared;
+    std::string numThreads = "";
+    std::stringstream bodyStr;
+    std::stringstream replicated;
+    std::stringstream sequential;
+    std::set<const clang::ValueDecl *> sequentialWritten;
+    bool first = true;
+    for (unsigned s = 0; s <= stmts.size(); s++) {
+        const bool atLoop = (s == stmts.size() ||
+                markers.find(stmts[s]) != markers.end());
+        if (atLoop && sequential.str().size() > 0) {
+            bool writesControl = false;
+            for (std::set<const clang::ValueDecl *>::iterator i =
+                    sequentialWritten.begin(), e = sequentialWritten.end();
+                    i != e; i++) {
+                std::vector<const clang::ValueDecl *> decl(1, *i);
+                for (unsigned c = 0; c < control.size(); c++) {
+                    writesControl = writesControl ||
+                        referencesAnyDecl(control[c], &decl);
+                }
+            }
+            if (first && writesControl) {
+                bodyStr << "____omp_team_barrier(" << TEAM_VAR << ");\n";
+            }
+            bodyStr << replicated.str();
+            bodyStr << "if (" << THREAD_NUM_VAR << " == 0) {\n" <<
+                sequential.str() << "}\n";
+            bodyStr << "____omp_team_barrier(" << TEAM_VAR << ");\n";
+        } else if (atLoop) {
+            bodyStr << replicated.str();
+        }
+        if (atLoop) {
+            replicated.str("");
+            sequential.str("");
+            sequentialWritten.clear();
+        }
+        if (s == stmts.size()) {
+            break;
+        }
+
+        if (atLoop) {
+            PragmaNode *loop = NULL;
+            for (std::vector<PragmaNode *>::iterator i = loops->begin(),
+                    e = loops->end(); i != e; i++) {
+                if ((*i)->getMarker() == stmts[s]) loop = *i;
+            }
+            bodyStr << "hclib_pragma_marker(\"omp\", \"" <<
+                getTeamForArgs(loop, &shared, numThreads) << "\", \"" <<
+                loop->getLbl() << "\");\n" << stmtToString(stmts[s + 1]) <<
+                "\n";
+            first = false;
+            s++;
+            continue;
+        }
+
+        /*
+         * A declaration used by the parallel fors is a private variable of
+         * theirs, so each thread declares its own.
+         */
+        bool usedByLoops = false;
+        if (const clang::DeclStmt *declStmt =
+                clang::dyn_cast<clang::DeclStmt>(stmts[s])) {
+            std::vector<const clang::ValueDecl *> decls;
+            for (clang::DeclStmt::const_decl_iterator d =
+                    declStmt->decl_begin(), e = declStmt->decl_end(); d != e;
+                    d++) {
+                decls.push_back(clang::dyn_cast<clang::ValueDecl>(*d));
+            }
+            for (unsigned t = 0; t < stmts.size(); t++) {
+                if (markers.find(stmts[t]) != markers.end() &&
+                        referencesAnyDecl(stmts[t + 1], &decls)) {
+                    usedByLoops = true;
+                }
+            }
+        }
+        if (usedByLoops) {
+            replicated << stmtToString(stmts[s]) << " ;\n";
+        } else {
+            sequential << stmtToString(stmts[s]) << " ;\n";
+            collectWrittenDecls(stmts[s], NULL, &sequentialWritten);
+        }
+    }
+
+    std::stringstream ss;
+    ss << "{\n";
+    ss << "hclib_pragma_marker(\"omp\", \"" << getTeamParallelArgs(&shared,
+            privateClause, numThreads) << "\", \"" << loops->at(0)->getLbl() <<
+        "_persistent\");\n";
+    ss << "{\n";
+    ss << "____omp_team_t *" << TEAM_VAR << " = NULL; int " <<
+        THREAD_NUM_VAR << " = 0;\n";
+    ss << header << bodyStr.str() << footer;
+    ss << "}\n";
+    ss << "}\n";
+    return ss.str();
+}
+
+/*
+ * Match a declaration or assignment of one variable to the value of another,
+ * e.g. tmp = a.
+ */
+static bool getVarCopy(const clang::Stmt *stmt, const clang::ValueDecl **dst,
+        const clang::ValueDecl **src) {
+    const clang::Expr *value = NULL;
+    if (const clang::DeclStmt *declStmt =
+            clang::dyn_cast<clang::DeclStmt>(stmt)) {
+        if (!declStmt->isSingleDecl()) {
+            return false;
+        }
+        const clang::VarDecl *var = clang::dyn_cast<clang::VarDecl>(
+                declStmt->getSingleDecl());
+        if (var == NULL || !var->hasInit()) {
+            return false;
+        }
+        *dst = var;
+        value = var->getInit();
+    } else if (const clang::BinaryOperator *bin =
+            clang::dyn_cast<clang::BinaryOperator>(stmt)) {
+        const clang::DeclRefExpr *lhs = clang::dyn_cast<clang::DeclRefExpr>(
+                bin->getLHS()->IgnoreParens());
+        if (bin->getOpcode() != clang::BO_Assign || lhs == NULL) {
+            return false;
+        }
+        *dst = lhs->getDecl();
+        value = bin->getRHS();
+    } else {
+        return false;
+    }
+
+    const clang::DeclRefExpr *rhs = clang::dyn_cast<clang::DeclRefExpr>(
+            value->IgnoreParenImpCasts());
+    if (rhs == NULL) {
+        return false;
+    }
+    *src = rhs->getDecl();
+    return clang::isa<clang::VarDecl>(*dst) && clang::isa<clang::VarDecl>(*src);
+}
+
+/*
+ * Match the exchange of two pointer variables through a third that ends each
+ * step of a stencil, i.e. tmp = a; a = b; b = tmp;
+ */
+static bool isPointerSwap(const clang::Stmt *first, const clang::Stmt *second,
+        const clang::Stmt *third, const clang::ValueDecl **a,
+        const clang::ValueDecl **b) {
+    const clang::ValueDecl *tmp = NULL;
+    const clang::ValueDecl *dst = NULL;
+    const clang::ValueDecl *src = NULL;
+    if (!getVarCopy(first, &tmp, a) || !getVarCopy(second, &dst, b) ||
+            dst != *a || !getVarCopy(third, &dst, &src) || dst != *b ||
+            src != tmp) {
+        return false;
+    }
+    return tmp != *a && tmp != *b && *a != *b &&
+        (*a)->getType()->isPointerType() && (*b)->getType()->isPointerType();
+}
+
+/*
+ * Flatten a sum or difference into its terms, each with the sign it is added
+ * with.
+ */
+static void collectLinearTerms(const clang::Expr *expr, int sign,
+        std::vector<std::pair<const clang::Expr *, int> > *terms) {
+    expr = expr->IgnoreParenImpCasts();
+    if (const clang::BinaryOperator *bin =
+            clang::dyn_cast<clang::BinaryOperator>(expr)) {
+        if (bin->getOpcode() == clang::BO_Add ||
+                bin->getOpcode() == clang::BO_Sub) {
+            collectLinearTerms(bin->getLHS(), sign, terms);
+            collectLinearTerms(bin->getRHS(), (bin->getOpcode() ==
+                        clang::BO_Add ? sign : -sign), terms);
+            return;
+        }
+    }
+    terms->push_back(std::pair<const clang::Expr *, int>(expr, sign));
+}
+
+/*
+ * Match an index of the form i, i + c, i - c or c + i for an integer literal
+ * c, returning |c|.
+ */
+static bool getNeighborOffset(const clang::Expr *index,
+        const clang::ValueDecl *condVar, int &offset) {
+    if (isReferenceTo(index, condVar)) {
+        offset = 0;
+        return true;
+    }
+    const clang::BinaryOperator *bin = clang::dyn_cast<clang::BinaryOperator>(
+            index->IgnoreParenImpCasts());
+    if (bin == NULL || (bin->getOpcode() != clang::BO_Add &&
+                bin->getOpcode() != clang::BO_Sub)) {
+        return false;
+    }
+    const clang::Expr *other = NULL;
+    if (isReferenceTo(bin->getLHS(), condVar)) {
+        other = bin->getRHS();
+    } else if (bin->getOpcode() == clang::BO_Add &&
+            isReferenceTo(bin->getRHS(), condVar)) {
+        other = bin->getLHS();
+    } else {
+        return false;
+    }
+    const clang::IntegerLiteral *literal =
+        clang::dyn_cast<clang::IntegerLiteral>(other->IgnoreParenImpCasts());
+    if (literal == NULL || literal->getValue().getActiveBits() > 16) {
+        return false;
+    }
+    offset = (int)literal->getValue().getZExtValue();
+    return true;
+}
+
+/*
+ * Match an index into a flattened row-major array of the form r * cols + j +
+ * c, with its terms in any order, where r is a row index matched by
+ * getNeighborOffset, cols a variable holding the row length, j the column
+ * variable and c a sum of integer literals. The row offset of r is returned
+ * along with c, and cols must match any variable already found there.
+ */
+static bool getFlattenedNeighborOffset(const clang::Expr *index,
+        const clang::ValueDecl *condVar, const clang::ValueDecl *colVar,
+        const clang::ValueDecl **cols, int &rowOffset, int &colOffset) {
+    if (colVar == NULL) {
+        return false;
+    }
+    std::vector<std::pair<const clang::Expr *, int> > terms;
+    collectLinearTerms(index, 1, &terms);
+
+    bool foundRow = false;
+    bool foundCol = false;
+    colOffset = 0;
+    for (std::vector<std::pair<const clang::Expr *, int> >::iterator i =
+            terms.begin(), e = terms.end(); i != e; i++) {
+        const clang::Expr *term = i->first;
+        if (isReferenceTo(term, colVar)) {
+            if (foundCol || i->second < 0) {
+                return false;
+            }
+            foundCol = true;
+            continue;
+        }
+        if (const clang::IntegerLiteral *literal =
+                clang::dyn_cast<clang::IntegerLiteral>(term)) {
+            if (literal->getValue().getActiveBits() > 16) {
+                return false;
+            }
+            colOffset += i->second * (int)literal->getValue().getZExtValue();
+            continue;
+        }
+
+        const clang::BinaryOperator *bin =
+            clang::dyn_cast<clang::BinaryOperator>(term);
+        if (bin == NULL || bin->getOpcode() != clang::BO_Mul || foundRow ||
+                i->second < 0) {
+            return false;
+        }
+        const clang::Expr *size = NULL;
+        if (getNeighborOffset(bin->getLHS(), condVar, rowOffset)) {
+            size = bin->getRHS();
+        } else if (getNeighborOffset(bin->getRHS(), condVar, rowOffset)) {
+            size = bin->getLHS();
+        } else {
+            return false;
+        }
+        const clang::DeclRefExpr *ref = clang::dyn_cast<clang::DeclRefExpr>(
+                size->IgnoreParenImpCasts());
+        if (ref == NULL || !clang::isa<clang::VarDecl>(ref->getDecl()) ||
+                ref->getDecl() == condVar || ref->getDecl() == colVar ||
+                (*cols != NULL && ref->getDecl() != *cols)) {
+            return false;
+        }
+        *cols = ref->getDecl();
+        foundRow = true;
+    }
+    return foundRow && foundCol;
+}
+
+/*
+ * Whether cond and inc step var upwards one at a time towards a bound, i.e.
+ * var < n or var <= n, and var++ or ++var.
+ */
+static bool isUnitStepLoopControl(const clang::Stmt *cond,
+        const clang::Stmt *inc, const clang::ValueDecl *var) {
+    const clang::BinaryOperator *bin = clang::dyn_cast_or_null<
+        clang::BinaryOperator>(cond);
+    if (bin == NULL || (bin->getOpcode() != clang::BO_LT &&
+                bin->getOpcode() != clang::BO_LE) ||
+            !isReferenceTo(bin->getLHS(), var)) {
+        return false;
+    }
+    const clang::UnaryOperator *unary = clang::dyn_cast_or_null<
+        clang::UnaryOperator>(inc);
+    return unary != NULL && unary->isIncrementOp() &&
+        isReferenceTo(unary->getSubExpr(), var);
+}
+
+/*
+ * The induction variable initialized by the init statement of a for loop, if
+ * it is a plain int.
+ */
+static const clang::ValueDecl *getIntInductionVar(const clang::Stmt *init,
+        clang::ASTContext *Context) {
+    const clang::ValueDecl *var = NULL;
+    if (const clang::DeclStmt *declStmt =
+            clang::dyn_cast_or_null<clang::DeclStmt>(init)) {
+        const clang::VarDecl *decl = (declStmt->isSingleDecl() ?
+                clang::dyn_cast<clang::VarDecl>(declStmt->getSingleDecl()) :
+                NULL);
+        if (decl != NULL && decl->hasInit()) {
+            var = decl;
+        }
+    } else if (const clang::BinaryOperator *bin =
+            clang::dyn_cast_or_null<clang::BinaryOperator>(init)) {
+        const clang::DeclRefExpr *lhs = clang::dyn_cast<clang::DeclRefExpr>(
+                bin->getLHS()->IgnoreParens());
+        if (bin->getOpcode() == clang::BO_Assign && lhs != NULL) {
+            var = lhs->getDecl();
+        }
+    }
+    if (var == NULL || !var->getType()->isIntegerType() ||
+            isWideInductionVar(var, Context)) {
+        return NULL;
+    }
+    return var;
+}
+
+/*
+ * A time step loop can be temporally blocked if:
+ *
+ *   1. It is a for loop stepping an int upwards by one towards a bound that
+ *      its body does not write, and its induction variable is not used in the
+ *      body.
+ *   2. Its body is a parallel for, with only private, shared, schedule,
+ *      collapse and num_threads clauses, followed by the swap of an input and
+ *      an output pointer.
+ *   3. The parallel for steps an int upwards by one between bounds that the
+ *      time loop does not change.
+ *   4. Apart from its locals, the parallel for only stores into elements of
+ *      the output whose first index is its induction variable i, and only
+ *      loads elements of the input whose first index is i plus or minus a
+ *      constant, as well as anything that the stores cannot modify.
+ *
+ * Instead of a first index of i, all of the elements may be indexed as rows
+ * of a flattened array, i.e. output[i * cols + j] and input[(i +- r) * cols +
+ * j +- c], where j is the induction variable of the loop directly inside the
+ * parallel for and is taken to stay within a row. As a column offset may then
+ * reach into the next row over, it counts as one more row of distance.
+ *
+ * The input and output pointers are returned, along with the row length of a
+ * flattened array, if any, and the largest distance in rows between an
+ * element that is loaded and the one being computed.
+ */
+bool OMPToHClib::canBlockTemporally(PragmaNode *node,
+        const clang::Stmt *timeLoop, const clang::Stmt *funcBody,
+        const clang::ValueDecl **in, const clang::ValueDecl **out,
+        const clang::ValueDecl **cols, int &radius) {
+    PragmaNode *parent = node->getParent();
+    const clang::ForStmt *forStmt = clang::dyn_cast<clang::ForStmt>(timeLoop);
+    if (forStmt == NULL || parent == NULL || (parent->getPragmaName() ==
+                "omp" && parent->getPragmaCmd() == "parallel") ||
+            node->nchildren() > 0 || node->getBody() == NULL ||
+            !clang::isa<clang::ForStmt>(node->getBody())) {
+        return false;
+    }
+
+    OMPClauses *clauses = getOMPClausesForMarker(node->getMarker());
+    for (std::map<std::string, std::vector<SingleClauseArgs *> *>::iterator i =
+            clauses->begin(), e = clauses->end(); i != e; i++) {
+        if (i->first != "for" && i->first != "private" &&
+                i->first != "shared" && i->first != "default" &&
+                i->first != "schedule" && i->first != "collapse" &&
+                i->first != "num_threads") {
+            return false;
+        }
+    }
+    if (clauses->hasClause("default") &&
+            clauses->getSingleArg("default") != "shared") {
+        return false;
+    }
+
+    const clang::CompoundStmt *body = getLoopBody(timeLoop);
+    if (body == NULL || body->size() != 5 ||
+            *body->body_begin() != node->getMarker()) {
+        return false;
+    }
+    std::vector<const clang::Stmt *> stmts(body->body_begin(),
+            body->body_end());
+    const clang::ValueDecl *a = NULL;
+    const clang::ValueDecl *b = NULL;
+    if (!isPointerSwap(stmts[2], stmts[3], stmts[4], &a, &b)) {
+        return false;
+    }
+
+    const clang::ValueDecl *timeVar = getIntInductionVar(forStmt->getInit(),
+            Context);
+    if (timeVar == NULL || !isUnitStepLoopControl(forStmt->getCond(),
+                forStmt->getInc(), timeVar)) {
+        return false;
+    }
+    std::set<const clang::ValueDecl *> bodyWritten;
+    collectWrittenDecls(body, NULL, &bodyWritten);
+    std::vector<const clang::ValueDecl *> written(bodyWritten.begin(),
+            bodyWritten.end());
+    std::vector<const clang::ValueDecl *> timeDecl(1, timeVar);
+    if (referencesAnyDecl(body, &timeDecl) || referencesAnyDecl(
+                clang::dyn_cast<clang::BinaryOperator>(
+                    forStmt->getCond())->getRHS(), &written)) {
+        return false;
+    }
+
+    const clang::ForStmt *loop = clang::dyn_cast<clang::ForStmt>(
+            node->getBody());
+    const clang::ValueDecl *condVar = getIntInductionVar(loop->getInit(),
+            Context);
+    if (condVar == NULL || !isUnitStepLoopControl(loop->getCond(),
+                loop->getInc(), condVar)) {
+        return false;
+    }
+    const clang::Expr *low = NULL;
+    if (const clang::DeclStmt *declStmt = clang::dyn_cast<clang::DeclStmt>(
+                loop->getInit())) {
+        low = clang::dyn_cast<clang::VarDecl>(
+                declStmt->getSingleDecl())->getInit();
+    } else {
+        low = clang::dyn_cast<clang::BinaryOperator>(
+                loop->getInit())->getRHS();
+    }
+    if (referencesAnyDecl(low, &written) || referencesAnyDecl(
+                clang::dyn_cast<clang::BinaryOperator>(
+                    loop->getCond())->getRHS(), &written)) {
+        return false;
+    }
+
+    std::set<const clang::ValueDecl *> locals;
+    collectLocalDecls(loop, &locals);
+    locals.insert(condVar);
+    const clang::ForStmt *currLoop = loop;
+    for (int l = 1; l < clauses->getNumCollapsedLoops(); l++) {
+        currLoop = getNestedLoop(currLoop->getBody());
+        if (currLoop == NULL) {
+            return false;
+        }
+        const clang::ValueDecl *innerVar = NULL;
+        getCondVarAndLowerBoundFromInit(currLoop->getInit(), &innerVar);
+        locals.insert(innerVar);
+    }
+    std::vector<OMPVarInfo> *vars = clauses->getVarInfo(node->getCaptures());
+    for (std::vector<OMPVarInfo>::iterator i = vars->begin(),
+            e = vars->end(); i != e; i++) {
+        if (i->getType() == CAPTURE_TYPE::PRIVATE) {
+            locals.insert(i->getDecl());
+        }
+    }
+    if (locals.find(a) != locals.end() || locals.find(b) != locals.end()) {
+        return false;
+    }
+
+    const clang::ForStmt *rowLoop = getNestedLoop(loop->getBody());
+    const clang::ValueDecl *colVar = NULL;
+    if (rowLoop != NULL) {
+        colVar = getIntInductionVar(rowLoop->getInit(), Context);
+        std::set<const clang::ValueDecl *> rowWritten;
+        collectWrittenDecls(rowLoop->getBody(), NULL, &rowWritten);
+        if (rowWritten.find(colVar) != rowWritten.end()) {
+            colVar = NULL;
+        }
+    }
+
+    std::vector<LoopAccess> accesses;
+    if (!collectLoopAccesses(loop->getBody(), &locals, &accesses)) {
+        return false;
+    }
+
+    // The output is whichever of the two pointers the loop stores into
+    *out = NULL;
+    *cols = NULL;
+    bool flattened = false;
+    for (std::vector<LoopAccess>::iterator i = accesses.begin(),
+            e = accesses.end(); i != e; i++) {
+        if (!i->isWrite) {
+            continue;
+        }
+        if ((i->base != a && i->base != b) || (*out != NULL &&
+                    i->base != *out)) {
+            return false;
+        }
+        int rowOffset = 0;
+        int colOffset = 0;
+        const bool flat = (i->index != NULL &&
+                getFlattenedNeighborOffset(i->index, condVar, colVar, cols,
+                    rowOffset, colOffset));
+        if (flat) {
+            if (rowOffset != 0 || colOffset != 0 ||
+                    (*out != NULL && !flattened)) {
+                return false;
+            }
+        } else if (!isReferenceTo(i->index, condVar) || flattened) {
+            return false;
+        }
+        flattened = flat;
+        *out = i->base;
+    }
+    if (*out == NULL) {
+        return false;
+    }
+    *in = (*out == a ? b : a);
+    if (*cols != NULL && (locals.find(*cols) != locals.end() ||
+                bodyWritten.find(*cols) != bodyWritten.end())) {
+        return false;
+    }
+
+    std::set<const clang::ValueDecl *> escaped;
+    collectEscapedDecls(funcBody, NULL, &escaped);
+    radius = 0;
+    for (std::vector<LoopAccess>::iterator i = accesses.begin(),
+            e = accesses.end(); i != e; i++) {
+        if (i->isWrite) {
+            continue;
+        }
+        if ((i->base == *in || i->base == *out) && i->index == NULL) {
+            // The pointer itself
+            continue;
+        }
+        if (i->base == *out) {
+            return false;
+        }
+        if (i->base == *in) {
+            int offset = 0;
+            int colOffset = 0;
+            if (flattened) {
+                if (!getFlattenedNeighborOffset(i->index, condVar, colVar,
+                            cols, offset, colOffset)) {
+                    return false;
+                }
+                if (colOffset != 0) {
+                    offset++;
+                }
+            } else if (!getNeighborOffset(i->index, condVar, offset)) {
+                return false;
+            }
+            radius = std::max(radius, offset);
+            continue;
+        }
+
+        for (std::vector<LoopAccess>::iterator j = accesses.begin(),
+                ee = accesses.end(); j != ee; j++) {
+            if (j->isWrite && accessesMayConflict(*i, condVar, *j, condVar,
+                        &escaped, Context)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*
+ * Run blocks of time steps of a stencil loop tile by tile, so that each tile
+ * is read from memory once per block rather than once per step.
+ *
+ * The iteration space of the parallel for is split into tiles at least twice
+ * the block size times the stencil radius wide. For each block, a first
+ * parallel for runs each tile through the steps of the block, computing one
+ * radius less on each side of it at each step, as the neighbors it would need
+ * are computed by the tiles next to it. A second parallel for then fills in
+ * the triangles left out around each boundary between two tiles, which widen
+ * by one radius at each step.
+ *
+ * The input and output pointers trade places after each step as before, so
+ * every step reads and writes the same buffers that it would have, and the
+ * pointers are left swapped as by the original loop.
+ */
+std::string OMPToHClib::getTemporalBlockingStr(PragmaNode *node,
+        const clang::Stmt *timeLoop, const clang::ValueDecl *in,
+        const clang::ValueDecl *out, const clang::ValueDecl *cols,
+        int radius) {
+    const clang::ForStmt *forStmt = clang::dyn_cast<clang::ForStmt>(timeLoop);
+    const clang::CompoundStmt *body = getLoopBody(timeLoop);
+    std::vector<const clang::Stmt *> stmts(body->body_begin(),
+            body->body_end());
+    const clang::ForStmt *loop = clang::dyn_cast<clang::ForStmt>(
+            node->getBody());
+    OMPClauses *clauses = getOMPClausesForMarker(node->getMarker());
+
+    const clang::ValueDecl *timeVar = NULL;
+    getCondVarAndLowerBoundFromInit(forStmt->getInit(), &timeVar);
+    const std::string timeHigh = getUpperBoundFromCond(forStmt->getCond(),
+            timeVar);
+
+    const clang::ValueDecl *condVar = NULL;
+    const std::string lowStr = getCondVarAndLowerBoundFromInit(
+            loop->getInit(), &condVar);
+    const std::string highStr = getUpperBoundFromCond(loop->getCond(),
+            condVar);
+
+    /*
+     * The induction variables of the collapsed loops stay private, unless they
+     * are declared by the loops themselves.
+     */
+    std::vector<std::string> privateVars;
+    const clang::ForStmt *currLoop = loop;
+    for (int l = 0; l < clauses->getNumCollapsedLoops(); l++) {
+        if (l > 0) {
+            currLoop = getNestedLoop(currLoop->getBody());
+            assert(currLoop);
+        }
+        const clang::ValueDecl *var = NULL;
+        getCondVarAndLowerBoundFromInit(currLoop->getInit(), &var);
+        if (!clang::isa<clang::DeclStmt>(currLoop->getInit())) {
+            privateVars.push_back(var->getNameAsString());
+        }
+    }
+    if (clauses->hasClause("private")) {
+        std::vector<std::string> *vars = clauses->getFlattenedArgsList(
+                "private");
+        for (std::vector<std::string>::iterator i = vars->begin(),
+                e = vars->end(); i != e; i++) {
+            if (std::find(privateVars.begin(), privateVars.end(), *i) ==
+                    privateVars.end()) {
+                privateVars.push_back(*i);
+            }
+        }
+    }
+    std::string tileArgs = "parallel for";
+    for (unsigned v = 0; v < privateVars.size(); v++) {
+        tileArgs += (v == 0 ? " private(" : ", ") + privateVars[v];
+    }
+    if (!privateVars.empty()) {
+        tileArgs += ")";
+    }
+    if (clauses->hasClause("num_threads")) {
+        tileArgs += " num_threads(" + clauses->getSingleArg("num_threads") +
+            ")";
+    }
+
+    const std::string inName = in->getNameAsString();
+    const std::string outName = out->getNameAsString();
+    std::string loopHeader = "for (";
+    if (clang::isa<clang::DeclStmt>(loop->getInit())) {
+        loopHeader += getDeclarationTypeStr(condVar->getType(),
+                condVar->getNameAsString(), "", "");
+    } else {
+        loopHeader += condVar->getNameAsString();
+    }
+    loopHeader += " = ____tb_from; " + condVar->getNameAsString() +
+        " < ____tb_to; " + condVar->getNameAsString() + "++)";
+
+    std::stringstream step;
+    step << getDeclarationTypeStr(in->getType(), inName, "", "") <<
+        " = (((____tb_t + ____tb_s) % 2 == 0) ? ____tb_in : ____tb_out);\n";
+    step << getDeclarationTypeStr(out->getType(), outName, "", "") <<
+        " = (((____tb_t + ____tb_s) % 2 == 0) ? ____tb_out : ____tb_in);\n";
+    step << loopHeader << " " << stmtToString(loop->getBody()) << "\n";
+
+    std::stringstream swap;
+    swap << "{\n";
+    for (unsigned s = 2; s < stmts.size(); s++) {
+        swap << stmtToString(stmts[s]) << " ;\n";
+    }
+    swap << "}\n";
+
+    std::stringstream ss;
+    ss << "{\n";
+    ss << stmtToString(forStmt->getInit()) << " ;\n";
+    ss << "const int ____tb_steps = ((" << stmtToString(forStmt->getCond()) <<
+        ") ? (" << timeHigh << ") - " << timeVar->getNameAsString() <<
+        " : 0);\n";
+    ss << "const int ____tb_low = " << lowStr << ";\n";
+    ss << "const int ____tb_n = (" << highStr << ") - ____tb_low;\n";
+    ss << getDeclarationTypeStr(in->getType(), "____tb_in", "", "") << " = " <<
+        inName << ";\n";
+    ss << getDeclarationTypeStr(out->getType(), "____tb_out", "", "") <<
+        " = " << outName << ";\n";
+    ss << "int ____tb_width = " << TEMPORAL_BLOCK_BYTES <<
+        " / (2 * (int)sizeof(____tb_out[0])";
+    if (cols != NULL) {
+        // Tiles are counted in rows of the flattened array
+        ss << " * (" << cols->getNameAsString() << " > 1 ? " <<
+            cols->getNameAsString() << " : 1)";
+    }
+    ss << ");\n";
+    ss << "if (____tb_width > ____tb_n / hclib_get_num_workers()) " <<
+        "____tb_width = ____tb_n / hclib_get_num_workers();\n";
+    ss << "if (____tb_width < 1) ____tb_width = 1;\n";
+    ss << "const int ____tb_ntiles = (____tb_n > ____tb_width ? ____tb_n / " <<
+        "____tb_width : 1);\n";
+    ss << "int ____tb_block = " << TEMPORAL_BLOCK_STEPS << ";\n";
+    if (radius > 0) {
+        ss << "if (____tb_block > ____tb_width / (2 * " << radius << ")) " <<
+            "____tb_block = ____tb_width / (2 * " << radius << ");\n";
+    }
+    ss << "if (____tb_block < 1) ____tb_block = 1;\n";
+    ss << "int ____tb_t;\n";
+    ss << "for (____tb_t = 0; ____tb_t < ____tb_steps; ____tb_t += " <<
+        "____tb_block) {\n";
+    ss << "const int ____tb_nsteps = (____tb_steps - ____tb_t < " <<
+        "____tb_block ? ____tb_steps - ____tb_t : ____tb_block);\n";
+
+    ss << "hclib_pragma_marker(\"omp\", \"" << tileArgs << "\", \"" <<
+        node->getLbl() << "_tb_shrink\");\n";
+    ss << "for (int ____tb_tile = 0; ____tb_tile < ____tb_ntiles; " <<
+        "____tb_tile++) {\n";
+    ss << "int ____tb_s;\n";
+    ss << "for (____tb_s = 0; ____tb_s < ____tb_nsteps; ____tb_s++) {\n";
+    ss << "const int ____tb_from = ____tb_low + ____tb_tile * ____tb_width + " <<
+        "(____tb_tile == 0 ? 0 : ____tb_s * " << radius << ");\n";
+    ss << "const int ____tb_to = (____tb_tile == ____tb_ntiles - 1 ? " <<
+        "____tb_low + ____tb_n : ____tb_low + (____tb_tile + 1) * " <<
+        "____tb_width - ____tb_s * " << radius << ");\n";
+    ss << step.str();
+    ss << "}\n";
+    ss << "}\n";
+
+    if (radius > 0) {
+        ss << "hclib_pragma_marker(\"omp\", \"" << tileArgs << "\", \"" <<
+            node->getLbl() << "_tb_grow\");\n";
+        ss << "for (int ____tb_tile = 1; ____tb_tile < ____tb_ntiles; " <<
+            "____tb_tile++) {\n";
+        ss << "int ____tb_s;\n";
+        ss << "for (____tb_s = 1; ____tb_s < ____tb_nsteps; ____tb_s++) {\n";
+        ss << "const int ____tb_from = ____tb_low + ____tb_tile * " <<
+            "____tb_width - ____tb_s * " << radius << ";\n";
+        ss << "const int ____tb_to = ____tb_low + ____tb_tile * " <<
+            "____tb_width + ____tb_s * " << radius << ";\n";
+        ss << step.str();
+        ss << "}\n";
+        ss << "}\n";
+    }
+    ss << "}\n";
+
+    ss << "if (____tb_steps > 0) {\n";
+    ss << "if (____tb_steps % 2 == 0) " << swap.str();
+    ss << swap.str();
+    ss << "}\n";
+    if (!clang::isa<clang::DeclStmt>(forStmt->getInit())) {
+        ss << timeVar->getNameAsString() << " += ____tb_steps;\n";
+    }
+    ss << "}\n";
+    return ss.str();
+}
+
+/*
+ * A sequential loop over diagonals is a block wavefront if:
+ *
+ *   1. It is a for loop stepping an int diagonal index d upwards by one
+ *      towards a bound that its body does not write, and its body is only a
+ *      parallel for, with only private, firstprivate, shared, default,
+ *      schedule and num_threads clauses.
+ *   2. The parallel for steps an int block column x upwards by one between
+ *      bounds that the body of the diagonal loop does not write.
+ *   3. The body of the parallel for starts by declaring the block row as
+ *      d - x plus terms that depend on neither, so that the blocks of each
+ *      diagonal lie on an anti-diagonal and the diagonal before holds the
+ *      blocks to their north and west.
+ *
+ * As for the blocked loops of nw, each block is then assumed to depend only
+ * on the blocks to its north, west and north-west, which is what the
+ * wavefront feature asks the translator to take for granted.
+ */
+bool OMPToHClib::isDiagonalSweep(PragmaNode *node,
+        const clang::Stmt *timeLoop) {
+    PragmaNode *parent = node->getParent();
+    const clang::ForStmt *forStmt = clang::dyn_cast<clang::ForStmt>(timeLoop);
+    if (forStmt == NULL || parent == NULL || (parent->getPragmaName() ==
+                "omp" && parent->getPragmaCmd() == "parallel") ||
+            node->nchildren() > 0 || node->getBody() == NULL ||
+            !clang::isa<clang::ForStmt>(node->getBody())) {
+        return false;
+    }
+
+    OMPClauses *clauses = getOMPClausesForMarker(node->getMarker());
+    for (std::map<std::string, std::vector<SingleClauseArgs *> *>::iterator i =
+            clauses->begin(), e = clauses->end(); i != e; i++) {
+        if (i->first != "for" && i->first != "private" &&
+                i->first != "firstprivate" && i->first != "shared" &&
+                i->first != "default" && i->first != "schedule" &&
+                i->first != "num_threads") {
+            return false;
+        }
+    }
+
+    const clang::CompoundStmt *body = getLoopBody(timeLoop);
+    if (body == NULL || body->size() != 2 ||
+            *body->body_begin() != node->getMarker()) {
+        return false;
+    }
+
+    const clang::ValueDecl *diagVar = getIntInductionVar(forStmt->getInit(),
+            Context);
+    if (diagVar == NULL || !isUnitStepLoopControl(forStmt->getCond(),
+                forStmt->getInc(), diagVar)) {
+        return false;
+    }
+    std::set<const clang::ValueDecl *> bodyWritten;
+    collectWrittenDecls(body, NULL, &bodyWritten);
+    std::vector<const clang::ValueDecl *> written(bodyWritten.begin(),
+            bodyWritten.end());
+    if (bodyWritten.find(diagVar) != bodyWritten.end() || referencesAnyDecl(
+                clang::dyn_cast<clang::BinaryOperator>(
+                    forStmt->getCond())->getRHS(), &written)) {
+        return false;
+    }
+
+    const clang::ForStmt *loop = clang::dyn_cast<clang::ForStmt>(
+            node->getBody());
+    const clang::ValueDecl *colVar = getIntInductionVar(loop->getInit(),
+            Context);
+    if (colVar == NULL || !isUnitStepLoopControl(loop->getCond(),
+                loop->getInc(), colVar)) {
+        return false;
+    }
+    const clang::Expr *low = NULL;
+    if (const clang::DeclStmt *declStmt = clang::dyn_cast<clang::DeclStmt>(
+                loop->getInit())) {
+        low = clang::dyn_cast<clang::VarDecl>(
+                declStmt->getSingleDecl())->getInit();
+    } else {
+        low = clang::dyn_cast<clang::BinaryOperator>(
+                loop->getInit())->getRHS();
+    }
+    if (referencesAnyDecl(low, &written) || referencesAnyDecl(
+                clang::dyn_cast<clang::BinaryOperator>(
+                    loop->getCond())->getRHS(), &written)) {
+        return false;
+    }
+
+    const clang::CompoundStmt *loopBody =
+        clang::dyn_cast<clang::CompoundStmt>(loop->getBody());
+    if (loopBody == NULL || loopBody->size() == 0) {
+        return false;
+    }
+    const clang::DeclStmt *rowDecl = clang::dyn_cast<clang::DeclStmt>(
+            *loopBody->body_begin());
+    const clang::VarDecl *rowVar = NULL;
+    if (rowDecl != NULL && rowDecl->isSingleDecl()) {
+        rowVar = clang::dyn_cast<clang::VarDecl>(rowDecl->getSingleDecl());
+    }
+    if (rowVar == NULL || !rowVar->hasInit()) {
+        return false;
+    }
+
+    std::vector<std::pair<const clang::Expr *, int> > terms;
+    collectLinearTerms(rowVar->getInit(), 1, &terms);
+    std::vector<const clang::ValueDecl *> indices;
+    indices.push_back(diagVar);
+    indices.push_back(colVar);
+    int nDiag = 0;
+    int nCol = 0;
+    for (unsigned t = 0; t < terms.size(); t++) {
+        if (isReferenceTo(terms[t].first, diagVar) && terms[t].second == 1) {
+            nDiag++;
+        } else if (isReferenceTo(terms[t].first, colVar) &&
+                terms[t].second == -1) {
+            nCol++;
+        } else if (referencesAnyDecl(terms[t].first, &indices) ||
+                referencesAnyDecl(terms[t].first, &written)) {
+            return false;
+        }
+    }
+    return nDiag == 1 && nCol == 1 && !canJumpOut(loop->getBody(), false,
+            false);
+}
+
+/*
+ * Run the blocks of a diagonal sweep as a dataflow graph instead of one
+ * parallel for per diagonal. Each block becomes a task that depends on the
+ * promises of the blocks to its north and west, if the sweep computes them,
+ * and fulfills its own once it is done. The block to its north-west is done
+ * before either of those starts, so it only needs waiting on when neither is
+ * computed. The task is spawned on the first of these futures, like a task
+ * whose dependencies were resolved statically, and waits on the second one,
+ * if any, before running. The sweep as a whole still completes before the
+ * code that follows it, but blocks of successive diagonals overlap instead of
+ * every diagonal ending in a barrier.
+ *
+ * Promises are indexed by the step of the diagonal loop and the block column,
+ * whose range over the sweep is found by running the loop control ahead of
+ * time.
+ */
+std::string OMPToHClib::getWavefrontStr(PragmaNode *node,
+        const clang::Stmt *timeLoop) {
+    const clang::ForStmt *forStmt = clang::dyn_cast<clang::ForStmt>(timeLoop);
+    const clang::ForStmt *loop = clang::dyn_cast<clang::ForStmt>(
+            node->getBody());
+    OMPClauses *clauses = getOMPClausesForMarker(node->getMarker());
+
+    const clang::ValueDecl *diagVar = NULL;
+    getCondVarAndLowerBoundFromInit(forStmt->getInit(), &diagVar);
+    const clang::ValueDecl *colVar = NULL;
+    const std::string lowStr = getCondVarAndLowerBoundFromInit(
+            loop->getInit(), &colVar);
+    const std::string highStr = getUpperBoundFromCond(loop->getCond(),
+            colVar);
+    const std::string col = colVar->getNameAsString();
+
+    // Up to and including the opening brace of the body
+    const std::string header = rewriter->getRewrittenText(clang::SourceRange(
+                forStmt->getLocStart(), getLoopBody(timeLoop)->getLBracLoc()));
+
+    std::string loopHeader = "for (";
+    if (clang::isa<clang::DeclStmt>(loop->getInit())) {
+        loopHeader += getDeclarationTypeStr(colVar->getType(), col, "", "");
+    } else {
+        loopHeader += col;
+    }
+    loopHeader += " = ____wf_lo[____wf_step]; " + col +
+        " < ____wf_hi[____wf_step]; " + col + "++)";
+
+    std::string taskArgs = "task";
+    std::vector<std::string> clauseStrs = OMPClauses::splitClauses(
+            node->getPragmaArguments());
+    for (std::vector<std::string>::iterator i = clauseStrs.begin(),
+            e = clauseStrs.end(); i != e; i++) {
+        std::string clauseName = getClauseName(*i);
+        if (clauseName == "private" || clauseName == "firstprivate" ||
+                clauseName == "shared" || clauseName == "default") {
+            taskArgs += " " + *i;
+        }
+    }
+    taskArgs += " firstprivate(" + diagVar->getNameAsString() + ", " + col +
+        ", ____wf_step, ____wf_lo, ____wf_hi, ____wf_done, ____wf_xmin, " +
+        "____wf_width, ____wf_second)";
+
+    std::stringstream ss;
+    ss << "{\n";
+    ss << "int ____wf_nsteps = 0;\n";
+    ss << "{ " << header << " ____wf_nsteps++; } }\n";
+    ss << "int *____wf_lo = (int *)malloc((____wf_nsteps + 1) * " <<
+        "sizeof(int));\n";
+    ss << "int *____wf_hi = (int *)malloc((____wf_nsteps + 1) * " <<
+        "sizeof(int));\n";
+    ss << "int ____wf_step = 0;\n";
+    ss << "int ____wf_xmin = 0;\n";
+    ss << "int ____wf_xmax = 0;\n";
+    ss << "int ____wf_any = 0;\n";
+    ss << "{ " << header << "\n";
+    ss << "____wf_lo[____wf_step] = " << lowStr << ";\n";
+    ss << "____wf_hi[____wf_step] = " << highStr << ";\n";
+    ss << "if (____wf_lo[____wf_step] < ____wf_hi[____wf_step]) {\n";
+    ss << "if (!____wf_any || ____wf_lo[____wf_step] < ____wf_xmin) " <<
+        "____wf_xmin = ____wf_lo[____wf_step];\n";
+    ss << "if (!____wf_any || ____wf_hi[____wf_step] > ____wf_xmax) " <<
+        "____wf_xmax = ____wf_hi[____wf_step];\n";
+    ss << "____wf_any = 1;\n";
+    ss << "}\n";
+    ss << "____wf_step++;\n";
+    ss << "} }\n";
+    // Not const, as the task contexts keep a copy of it
+    ss << "int ____wf_width = ____wf_xmax - ____wf_xmin;\n";
+    ss << "hclib_promise_t *____wf_done = (hclib_promise_t *)malloc(" <<
+        "((size_t)____wf_nsteps * ____wf_width + 1) * " <<
+        "sizeof(hclib_promise_t));\n";
+    ss << "size_t ____wf_b;\n";
+    ss << "for (____wf_b = 0; ____wf_b < (size_t)____wf_nsteps * " <<
+        "____wf_width; ____wf_b++) hclib_promise_init(&____wf_done[" <<
+        "____wf_b]);\n";
+
+    ss << "hclib_start_finish();\n";
+    ss << "____wf_step = 0;\n";
+    ss << header << "\n";
+    ss << loopHeader << " {\n";
+    std::stringstream north, west, northWest;
+    north << "&____wf_done[(size_t)(____wf_step - 1) * ____wf_width + " <<
+        col << " - ____wf_xmin]";
+    west << "&____wf_done[(size_t)(____wf_step - 1) * ____wf_width + " <<
+        col << " - 1 - ____wf_xmin]";
+    northWest << "&____wf_done[(size_t)(____wf_step - 2) * ____wf_width + " <<
+        col << " - 1 - ____wf_xmin]";
+    ss << "hclib_future_t *" << WAVEFRONT_FIRST_VAR << " = NULL;\n";
+    ss << "hclib_future_t *____wf_second = NULL;\n";
+    // North and west are on the diagonal before, north-west two before
+    ss << "if (____wf_step > 0 && " << col << " >= ____wf_lo[____wf_step - " <<
+        "1] && " << col << " < ____wf_hi[____wf_step - 1]) " <<
+        WAVEFRONT_FIRST_VAR << " = hclib_get_future_for_promise(" <<
+        north.str() << ");\n";
+    ss << "if (____wf_step > 0 && " << col << " - 1 >= ____wf_lo[" <<
+        "____wf_step - 1] && " << col << " - 1 < ____wf_hi[____wf_step - " <<
+        "1]) { if (" << WAVEFRONT_FIRST_VAR << " == NULL) " <<
+        WAVEFRONT_FIRST_VAR << " = hclib_get_future_for_promise(" <<
+        west.str() << "); else ____wf_second = " <<
+        "hclib_get_future_for_promise(" << west.str() << "); }\n";
+    ss << "if (" << WAVEFRONT_FIRST_VAR << " == NULL && ____wf_step > 1 && " <<
+        col << " - 1 >= ____wf_lo[____wf_step - 2] && " << col << " - 1 < " <<
+        "____wf_hi[____wf_step - 2]) " << WAVEFRONT_FIRST_VAR << " = " <<
+        "hclib_get_future_for_promise(" << northWest.str() << ");\n";
+    ss << "hclib_pragma_marker(\"omp\", \"" << taskArgs << "\", \"" <<
+        node->getLbl() << WAVEFRONT_SUFFIX << "\");\n";
+    ss << "{\n";
+    ss << "if (____wf_second != NULL) hclib_future_wait(____wf_second);\n";
+    ss << stmtToString(loop->getBody()) << " ;\n";
+    ss << "hclib_promise_put(&____wf_done[(size_t)____wf_step * " <<
+        "____wf_width + " << col << " - ____wf_xmin], NULL);\n";
+    ss << "}\n";
+    ss << "}\n";
+    ss << "____wf_step++;\n";
+    ss << "}\n";
+    ss << "hclib_end_finish();\n";
+
+    ss << "free(____wf_done);\n";
+    ss << "free(____wf_lo);\n";
+    ss << "free(____wf_hi);\n";
+    ss << "}\n";
+    return ss.str();
+}
+
+/*
+ * Whether a task is one of the blocks of a wavefront spawned by
+ * getWavefrontStr.
+ */
+static bool isWavefrontBlock(PragmaNode *node) {
+    const std::string lbl = node->getLbl();
+    const std::string suffix = WAVEFRONT_SUFFIX;
+    return isFeatureEnabled("wavefront") && lbl.size() > suffix.size() &&
+        lbl.compare(lbl.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/*
+ * Collect the arrays that stmt indexes with var, along with the size of their
+ * elements. Elements reached through anything but a named variable count as
+ * an array of their own.
+ */
+static void collectContiguousAccesses(const clang::Stmt *stmt,
+        const clang::ValueDecl *var,
+        std::map<const clang::ValueDecl *, int64_t> *arrays,
+        int64_t &unnamedBytes, clang::ASTContext *Context) {
+    if (const clang::ArraySubscriptExpr *subscript =
+            clang::dyn_cast<clang::ArraySubscriptExpr>(stmt)) {
+        std::vector<const clang::ValueDecl *> decl(1, var);
+        clang::QualType type = subscript->getType();
+        if (referencesAnyDecl(subscript->getIdx(), &decl) &&
+                !type->isIncompleteType() && type->isConstantSizeType()) {
+            const int64_t size = Context->getTypeSizeInChars(
+                    type).getQuantity();
+            std::vector<const clang::Expr *> indices;
+            const clang::DeclRefExpr *ref =
+                clang::dyn_cast<clang::DeclRefExpr>(getSubscriptRoot(
+                            subscript, &indices));
+            if (ref != NULL) {
+                (*arrays)[ref->getDecl()] = std::max((*arrays)[ref->getDecl()],
+                        size);
+            } else {
+                unnamedBytes += size;
+            }
+        }
+    }
+
+    for (clang::Stmt::const_child_iterator i = stmt->child_begin(),
+            e = stmt->child_end(); i != e; i++) {
+        if (*i != NULL) {
+            collectContiguousAccesses(*i, var, arrays, unnamedBytes, Context);
+        }
+    }
+}
+
+/*
+ * Whether the iterations of a parallel loop are left for the translator to
+ * split up, rather than by a chunk size, grainsize or num_tasks, or a
+ * schedule that hands out iterations on demand.
+ */
+static bool hasDefaultTiling(OMPClauses *clauses) {
+    const std::string kind = clauses->getScheduleKind();
+    return clauses->getScheduleChunk().size() == 0 &&
+        !clauses->hasClause("grainsize") && !clauses->hasClause("num_tasks") &&
+        (kind == "" || kind == "static" || kind == "auto");
+}
+
+/*
+ * A parallel loop whose body is another loop can be collapsed with it if both
+ * step an int upwards by one and the bounds of the inner loop are the same
+ * for every iteration of the outer one. Once collapsed, each iteration of the
+ * inner body runs on its own, so control must not leave it early and it must
+ * not move either induction variable.
+ */
+bool OMPToHClib::canCollapseNest(const clang::ForStmt *loop,
+        OMPClauses *clauses) {
+    if (clauses->getNumCollapsedLoops() != 1 || !hasDefaultTiling(clauses) ||
+            clauses->hasClause("lastprivate") || clauses->hasClause("ordered")) {
+        return false;
+    }
+    const clang::ForStmt *inner = getNestedLoop(loop->getBody());
+    if (inner == NULL) {
+        return false;
+    }
+
+    const clang::ValueDecl *outerVar = getIntInductionVar(loop->getInit(),
+            Context);
+    const clang::ValueDecl *innerVar = getIntInductionVar(inner->getInit(),
+            Context);
+    if (outerVar == NULL || innerVar == NULL ||
+            !isUnitStepLoopControl(loop->getCond(), loop->getInc(),
+                outerVar) ||
+            !isUnitStepLoopControl(inner->getCond(), inner->getInc(),
+                innerVar)) {
+        return false;
+    }
+
+    if (canJumpOut(inner->getBody(), false, false)) {
+        return false;
+    }
+
+    std::set<const clang::ValueDecl *> bodyWritten;
+    collectWrittenDecls(loop->getBody(), NULL, &bodyWritten);
+    std::set<const clang::ValueDecl *> innerWritten;
+    collectWrittenDecls(inner->getBody(), NULL, &innerWritten);
+    if (bodyWritten.find(outerVar) != bodyWritten.end() ||
+            innerWritten.find(innerVar) != innerWritten.end()) {
+        return false;
+    }
+    std::vector<const clang::ValueDecl *> written(bodyWritten.begin(),
+            bodyWritten.end());
+    written.push_back(outerVar);
+    const clang::Expr *low = NULL;
+    if (const clang::DeclStmt *declStmt = clang::dyn_cast<clang::DeclStmt>(
+                inner->getInit())) {
+        low = clang::dyn_cast<clang::VarDecl>(
+                declStmt->getSingleDecl())->getInit();
+    } else {
+        low = clang::dyn_cast<clang::BinaryOperator>(
+                inner->getInit())->getRHS();
+    }
+    return !referencesAnyDecl(low, &written) && !referencesAnyDecl(
+            clang::dyn_cast<clang::BinaryOperator>(inner->getCond())->getRHS(),
+            &written);
+}
+
+/*
+ * Pick the tiles of collapsed loops so that a tile touches about
+ * CACHE_TILE_BYTES of data, going by the arrays that the innermost loop
+ * steps through contiguously. The innermost dimension gets the longest tiles
+ * the budget allows, so that each tile streams along rows, and every outer
+ * dimension is blocked with what remains of it. The outermost dimension is
+ * split further if that leaves fewer tiles than workers.
+ */
+std::string OMPToHClib::getCacheTileStr(int nLoops, const clang::Stmt *body,
+        const clang::ValueDecl *innerVar) {
+    std::map<const clang::ValueDecl *, int64_t> arrays;
+    int64_t bytesPerIter = 0;
+    collectContiguousAccesses(body, innerVar, &arrays, bytesPerIter, Context);
+    for (std::map<const clang::ValueDecl *, int64_t>::iterator i =
+            arrays.begin(), e = arrays.end(); i != e; i++) {
+        bytesPerIter += i->second;
+    }
+    if (bytesPerIter == 0) {
+        bytesPerIter = 8;
+    }
+
+    std::stringstream ss;
+    ss << "{\n";
+    ss << "long ____budget = " << CACHE_TILE_BYTES << " / " << bytesPerIter <<
+        ";\n";
+    ss << "long ____tile_iters;\n";
+    for (int l = nLoops - 1; l >= 0; l--) {
+        std::stringstream dom;
+        dom << "domain[" << l << "]";
+        ss << "____tile_iters = (" << dom.str() << ".high - " << dom.str() <<
+            ".low + " << dom.str() << ".stride - 1) / " << dom.str() <<
+            ".stride;\n";
+        if (l == 0) {
+            ss << "if (____tile_iters > 0) ____tile_iters = 1 + " <<
+                "(____tile_iters - 1) / hclib_get_num_workers();\n";
+        }
+        ss << "if (____tile_iters > ____budget) ____tile_iters = " <<
+            "____budget;\n";
+        ss << "if (____tile_iters < 1) ____tile_iters = 1;\n";
+        ss << dom.str() << ".tile = ____tile_iters * " << dom.str() <<
+            ".stride;\n";
+        if (l > 0) {
+            ss << "____budget /= ____tile_iters;\n";
+        }
+    }
+    ss << "}\n";
+    return ss.str();
+}
+
+/*
+ * A rough estimate of the time one execution of stmt takes, as the number of
+ * nodes in its AST. Loops are assumed to run their body a few times, and
+ * calls to anything but leaf functions to cost as much as a small loop.
+ */
+static int getIterationCost(const clang::Stmt *stmt) {
+    int cost = 0;
+    for (clang::Stmt::const_child_iterator i = stmt->child_begin(),
+            e = stmt->child_end(); i != e; i++) {
+        if (*i != NULL) {
+            cost += getIterationCost(*i);
+        }
+    }
+
+    if (clang::isa<clang::ForStmt>(stmt) || clang::isa<clang::WhileStmt>(stmt) ||
+            clang::isa<clang::DoStmt>(stmt)) {
+        cost *= 8;
+    } else if (const clang::CallExpr *call =
+            clang::dyn_cast<clang::CallExpr>(stmt)) {
+        const clang::FunctionDecl *callee = call->getDirectCallee();
+        if (callee == NULL || !isLeafFunction(callee)) {
+            cost += 64;
+        }
+    }
+    return cost + 1;
+}
+
+/*
+ * The trip count of a parallel loop below which it runs sequentially, as the
+ * launch cost over the estimated cost of an iteration of body. It can be set
+ * for a region at compile time by defining <lbl>_SEQ_TRIPS, or at run time
+ * through the OMP_TO_HCLIB_SEQ_TRIPS_<lbl> environment variable, which is read
+ * on the first execution of the region.
+ */
+std::string OMPToHClib::getSeqTripsDef(std::string lbl,
+        const clang::Stmt *body) {
+    std::stringstream ss;
+    ss << "#ifndef ____omp_seq_trips_DEFINED\n";
+    ss << "#define ____omp_seq_trips_DEFINED\n";
+    ss << "static inline long ____omp_seq_trips(const char *name, " <<
+        "long estimate, long *cached) {\n";
+    ss << "    long trips = __atomic_load_n(cached, __ATOMIC_RELAXED);\n";
+    ss << "    if (trips < 0) {\n";
+    ss << "        const char *env = getenv(name);\n";
+    ss << "        trips = (env != NULL ? atol(env) : estimate);\n";
+    ss << "        __atomic_store_n(cached, trips, __ATOMIC_RELAXED);\n";
+    ss << "    }\n";
+    ss << "    return trips;\n";
+    ss << "}\n";
+    ss << "#endif\n";
+    ss << "#ifndef " << lbl << "_SEQ_TRIPS\n";
+    ss << "#define " << lbl << "_SEQ_TRIPS " << std::max(1,
+            SEQ_FALLBACK_COST / getIterationCost(body)) << "\n";
+    ss << "#endif\n";
+    ss << "static long " << lbl << "_seq_trips = -1;\n";
+    return ss.str();
+}
+
+/*
+ * Choose at run time between launching a parallel loop and running it in
+ * place, by comparing its trip count to the threshold of its region.
+ */
+std::string OMPToHClib::getSeqFallbackStr(std::string lbl,
+        std::vector<std::string> *lows, std::vector<std::string> *highs,
+        std::vector<std::string> *strides, std::string seqStr,
+        std::string launchStr) {
+    std::stringstream ss;
+    ss << "const double ____seq_iters = ";
+    for (unsigned l = 0; l < lows->size(); l++) {
+        std::string low = "(" + lows->at(l) + ")";
+        std::string high = "(" + highs->at(l) + ")";
+        std::string stride = "(" + strides->at(l) + ")";
+        ss << (l == 0 ? "" : " * ") << "(double)(" << high << " > " << low <<
+            " ? (" << high << " - " << low << " + " << stride << " - 1) / " <<
+            stride << " : 0)";
+    }
+    ss << ";\n";
+    ss << "if (____seq_iters < ____omp_seq_trips(\"" << SEQ_TRIPS_ENV_PREFIX <<
+        lbl << "\", " << lbl << "_SEQ_TRIPS, &" << lbl << "_seq_trips)) {\n";
+    ss << seqStr;
+    ss << "} else {\n";
+    ss << launchStr;
+    ss << "}\n";
+    return ss.str();
+}
+
+/*
+ * The value the sequential loop leaves induction variable d of a forasync
+ * closure with, given name holds its value in the last iteration. The outer
+ * variable of a linearized nest is computed from its own bounds, since its
+ * last iterations need not run any inner ones.
+ */
+static std::string getInductionExitStr(std::string name, int d,
+        bool wideIters, bool linearized) {
+    std::stringstream ss;
+    if (linearized && d == 0) {
+        ss << "ctx->____outer_low + ctx->____outer_n * ctx->____outer_step";
+    } else if (linearized) {
+        ss << name << " + ctx->____inner_step[___outer]";
+    } else if (wideIters) {
+        ss << name << " + ctx->____step" << d;
+    } else {
+        ss << name << " + ctx->____range[" << d << "].stride";
+    }
+    return ss.str();
+}
+
+std::string OMPToHClib::getClosureDef(std::string closureName,
+        bool isForasyncClosure, bool isAsyncClosure,
+        std::string contextName, std::vector<clang::ValueDecl *> *captured,
+        std::string bodyStr, bool isFuture, OMPClauses *clauses,
+        bool wrapBodyInFinish, bool waitAtEnd,
+        std::vector<const clang::ValueDecl *> *condVars, bool rangeClosure,
+        bool pooledContext, std::string pendingCounter,
+        std::string readOnlyUnpackStr, bool freeContext, bool wideIters,
+        bool linearized) {
+    assert(!(isForasyncClosure && isAsyncClosure));
+    assert(isForasyncClosure || !rangeClosure);
+    assert(!(rangeClosure && wideIters));
+    assert(!linearized || (isForasyncClosure && !rangeClosure && !wideIters));
+    std::vector<OMPReductionVar> *reductions = clauses->getReductions();
+    std::vector<OMPVarInfo> *vars = clauses->getVarInfo(captured);
+
+    std::stringstream ss;
+
+    ss << "\nstatic ";
+    if (isFuture) {
+        ss << "void *";
+    } else {
+        ss << "void ";
+    }
+    ss << closureName << "(void *____arg";
+    if (linearized) {
+        ss << ", const int ___tile0";
+    } else if (isForasyncClosure) {
+        for (int i = 0; i < condVars->size(); i++) {
+            if (rangeClosure) {
+                ss << ", const int ___tile" << i;
+            } else {
+                ss << ", const int ___iter" << i;
+            }
+        }
+    }
+    ss << ") {\n";
+
+    ss << "    " << contextName << " *ctx = (" << contextName <<
+        " *)____arg;\n";
+    
+    for (std::vector<OMPVarInfo>::iterator i = vars->begin(), e = vars->end();
+            i != e; i++) {
+        OMPVarInfo var = *i;
+        clang::ValueDecl *decl = var.getDecl();
+
+        switch (var.getType()) {
+            case (CAPTURE_TYPE::SHARED):
+                // Do nothing, should refer to the captured address in the body
+                break;
+            case (CAPTURE_TYPE::PRIVATE):
+            case (CAPTURE_TYPE::FIRSTPRIVATE):
+                ss << "    " << getUnpackStr(decl) << std::endl;
+                break;
+            case (CAPTURE_TYPE::LASTPRIVATE):
+                // Uninitialized on entry, like a private variable
+                ss << "    " << getDeclarationTypeStr(decl->getType(),
+                        decl->getNameAsString(), "", "") << ";" << std::endl;
+                break;
+            default:
+                std::cerr << "Unsupported capture type" << std::endl;
+                exit(1);
+        }
+    }
+    ss << readOnlyUnpackStr;
+
+    if (wrapBodyInFinish) {
+        /*
          * In OMP's task model you can use taskwait to wait on all previously
          * created child tasks of the currently executing task. To model this in
          * HClib, we wrap the body of each async in a finish scope and on
@@ -1341,6 +5602,64 @@ std::string OMPToHClib::getClosureDef(std::string closureName,
         ss << "    hclib_start_finish();\n";
     }
 
+    if (rangeClosure) {
+        /*
+         * Each call receives the index of one tile per dimension. Compute the
+         * [low, high) bounds of that tile in the original iteration space and
+         * run the body over it in plain loops, so that the captured variables
+         * above are only unpacked once per tile and the compiler sees a simple
+         * counted inner loop.
+         */
+        for (int i = 0; i < condVars->size(); i++) {
+            std::stringstream range;
+            range << "ctx->____range[" << i << "]";
+            ss << "    const int ___low" << i << " = " << range.str() <<
+                ".low + ___tile" << i << " * " << range.str() << ".tile;\n";
+            ss << "    const int ___high" << i << " = (___low" << i << " + " <<
+                range.str() << ".tile < " << range.str() << ".high ? ___low" <<
+                i << " + " << range.str() << ".tile : " << range.str() <<
+                ".high);\n";
+            ss << "    const int ___stride" << i << " = " << range.str() <<
+                ".stride;\n";
+        }
+        for (int i = 0; i < condVars->size(); i++) {
+            ss << "    int ___iter" << i << ";\n";
+        }
+        for (int i = 0; i < condVars->size(); i++) {
+            ss << "    for (___iter" << i << " = ___low" << i << "; ___iter" <<
+                i << " < ___high" << i << "; ___iter" << i << " += ___stride" <<
+                i << ") {\n";
+        }
+    }
+
+    if (linearized) {
+        /*
+         * Each call receives the index of one tile of the linearized nest.
+         * Locate the outer iteration that the tile starts in with a binary
+         * search over the per outer iteration offsets, and from there step
+         * through the tile moving on to the next outer iteration whenever the
+         * current one runs out.
+         */
+        ss << "    const long ___total = ctx->____offsets[ctx->____outer_n];\n";
+        ss << "    const long ___low = ___tile0 * ctx->____tile;\n";
+        ss << "    const long ___high = (___low + ctx->____tile < ___total ? " <<
+            "___low + ctx->____tile : ___total);\n";
+        ss << "    int ___outer = 0;\n";
+        ss << "    int ___last = ctx->____outer_n;\n";
+        ss << "    while (___last - ___outer > 1) {\n";
+        ss << "        const int ___mid = ___outer + (___last - ___outer) / 2;\n";
+        ss << "        if (ctx->____offsets[___mid] <= ___low) ___outer = ___mid;\n";
+        ss << "        else ___last = ___mid;\n";
+        ss << "    }\n";
+        ss << "    int ___inner = ___low - ctx->____offsets[___outer];\n";
+        ss << "    long ___lin;\n";
+        ss << "    for (___lin = ___low; ___lin < ___high; ___lin++) {\n";
+        ss << "    while (ctx->____offsets[___outer + 1] <= ___lin) {\n";
+        ss << "        ___outer++;\n";
+        ss << "        ___inner = 0;\n";
+        ss << "    }\n";
+    }
+
     if (isForasyncClosure) {
         /*
          * Insert a one iteration do-loop around the original body so that
@@ -1367,8 +5686,21 @@ std::string OMPToHClib::getClosureDef(std::string closureName,
         for (std::vector<const clang::ValueDecl *>::iterator i =
                 condVars->begin(), e = condVars->end(); i != e; i++) {
             const clang::ValueDecl *condVar = *i;
-            ss << "    " << condVar->getNameAsString() << " = ___iter" <<
-                iterCount << ";\n";
+            if (linearized && iterCount == 0) {
+                ss << "    " << condVar->getNameAsString() << " = ctx->" <<
+                    "____outer_low + ___outer * ctx->____outer_step;\n";
+            } else if (linearized) {
+                ss << "    " << condVar->getNameAsString() << " = ctx->" <<
+                    "____inner_low[___outer] + ___inner * " <<
+                    "ctx->____inner_step[___outer];\n";
+            } else if (wideIters) {
+                ss << "    " << condVar->getNameAsString() << " = ctx->" <<
+                    "____base" << iterCount << " + ___iter" << iterCount <<
+                    " * ctx->____step" << iterCount << ";\n";
+            } else {
+                ss << "    " << condVar->getNameAsString() << " = ___iter" <<
+                    iterCount << ";\n";
+            }
             iterCount++;
         }
     }
@@ -1377,21 +5709,34 @@ std::string OMPToHClib::getClosureDef(std::string closureName,
 
     if (isForasyncClosure) {
         ss << "    } while (0);\n";
+        if (linearized) {
+            ss << "    ___inner++;\n";
+            ss << "    }\n";
+        }
+        if (rangeClosure) {
+            for (int i = 0; i < condVars->size(); i++) {
+                ss << "    }\n";
+            }
+        }
         if (!reductions->empty()) {
-            ss << "    const int lock_err = pthread_mutex_lock(&ctx->reduction_mutex);\n";
-            ss << "    assert(lock_err == 0);\n";
+            /*
+             * Fold this iteration's (or, for range closures, this tile's)
+             * contribution into the executing worker's private accumulator.
+             * No other worker touches it until the combine step following the
+             * forasync, so no locking is needed.
+             */
+            ss << "    const int ____worker = hclib_get_current_worker();\n";
 
             for (std::vector<OMPReductionVar>::iterator i = reductions->begin(),
                     e = reductions->end(); i != e; i++) {
                 OMPReductionVar red = *i;
                 std::string varname = red.getVar();
 
-                ss << "    ctx->" << varname << " " << red.getOp() << "= " <<
-                    varname << ";\n";
+                ss << "    " << red.getCombineStr(
+                        "ctx->per_worker_reductions[____worker]." + varname,
+                        varname, getReductionDecl(red, vars)->getType()) <<
+                    "\n";
             }
-
-            ss << "    const int unlock_err = pthread_mutex_unlock(&ctx->reduction_mutex);\n";
-            ss << "    assert(unlock_err == 0);\n";
         }
     }
 
@@ -1411,6 +5756,14 @@ std::string OMPToHClib::getClosureDef(std::string closureName,
         }
     }
 
+    /*
+     * Only the call that executes the sequentially last iteration writes
+     * lastprivate variables back. The context holds the iteration space: a
+     * range closure runs the last iteration if its tile ends the space in every
+     * dimension, as does a linearized closure if its tile ends the whole nest,
+     * otherwise this call's own iteration must be the last one.
+     */
+    std::string isLastIter = "";
     for (std::vector<OMPVarInfo>::iterator i = vars->begin(), e = vars->end();
             i != e; i++) {
         OMPVarInfo var = *i;
@@ -1422,22 +5775,62 @@ std::string OMPToHClib::getClosureDef(std::string closureName,
             case (CAPTURE_TYPE::FIRSTPRIVATE):
                 break;
             case (CAPTURE_TYPE::LASTPRIVATE):
-                /*
-                 * Unsupported at the moment, would need to check if this is the
-                 * last iteration.
-                 */
-                assert(false);
                 assert(isForasyncClosure);
-                ss << "    *(ctx->" << decl->getNameAsString() << "_ptr) = " <<
-                    decl->getNameAsString() << ";" << std::endl;
+                if (isLastIter.size() == 0) {
+                    std::stringstream cond;
+                    if (linearized) {
+                        cond << "___high == ___total";
+                    }
+                    for (int d = 0; d < condVars->size() && !linearized;
+                            d++) {
+                        std::stringstream range;
+                        range << "ctx->____range[" << d << "]";
+                        if (d > 0) cond << " && ";
+                        if (rangeClosure) {
+                            cond << "___high" << d << " == " << range.str() <<
+                                ".high";
+                        } else if (wideIters) {
+                            cond << "___iter" << d << " + 1 == ctx->____left" <<
+                                d;
+                        } else {
+                            cond << "___iter" << d << " + " << range.str() <<
+                                ".stride >= " << range.str() << ".high";
+                        }
+                    }
+                    isLastIter = cond.str();
+                    ss << "    if (" << isLastIter << ") {\n";
+                }
+                ss << "        *(ctx->" << decl->getNameAsString() << "_ptr) = ";
+                if (std::find(condVars->begin(), condVars->end(), decl) !=
+                        condVars->end()) {
+                    // An induction variable is left one step past the end
+                    ss << getInductionExitStr(decl->getNameAsString(),
+                            std::find(condVars->begin(), condVars->end(),
+                                decl) - condVars->begin(), wideIters,
+                            linearized);
+                } else {
+                    ss << decl->getNameAsString();
+                }
+                ss << ";" << std::endl;
                 break;
             default:
                 std::cerr << "Unsupported capture type" << std::endl;
                 exit(1);
         }
     }
+    if (isLastIter.size() > 0) {
+        ss << "    }\n";
+    }
 
-    if (!isForasyncClosure) {
+    if (pendingCounter.size() > 0) {
+        // Signal completion to a parent task blocked in a taskwait
+        ss << "    __atomic_fetch_sub(ctx->" << pendingCounter << "_ptr, 1, " <<
+            "__ATOMIC_RELEASE);\n";
+    }
+
+    if (pooledContext) {
+        ss << "    " << contextName << "_free(ctx);\n";
+    } else if (!isForasyncClosure && freeContext) {
         ss << "    free(____arg);\n";
     }
 
@@ -1469,31 +5862,506 @@ enum CAPTURE_TYPE OMPToHClib::getParentCaptureType(PragmaNode *curr,
     return getParentCaptureType(curr->getParentAccountForFusing(), varname);
 }
 
-std::string OMPToHClib::getCriticalSectionLockStr(int criticalSectionId) {
+/*
+ * Two expressions refer to the same storage location if they are spelled the
+ * same way, ignoring whitespace, parentheses and implicit casts.
+ */
+bool OMPToHClib::sameAtomicLocation(const clang::Expr *a,
+        const clang::Expr *b) {
+    std::string aStr = stmtToString(a->IgnoreParenImpCasts());
+    std::string bStr = stmtToString(b->IgnoreParenImpCasts());
+    aStr.erase(std::remove_if(aStr.begin(), aStr.end(), ::isspace), aStr.end());
+    bStr.erase(std::remove_if(bStr.begin(), bStr.end(), ::isspace), bStr.end());
+    return aStr == bStr;
+}
+
+bool OMPToHClib::mentionsAtomicLocation(const clang::Stmt *stmt,
+        const clang::Expr *x) {
+    const clang::Expr *expr = clang::dyn_cast<clang::Expr>(stmt);
+    if (expr != NULL && sameAtomicLocation(expr, x)) {
+        return true;
+    }
+    for (clang::Stmt::const_child_iterator i = stmt->child_begin(),
+            e = stmt->child_end(); i != e; i++) {
+        if (*i != NULL && mentionsAtomicLocation(*i, x)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string OMPToHClib::getAtomicOperandStr(const clang::Expr *expr,
+        const clang::Expr *x) {
+    if (sameAtomicLocation(expr, x)) {
+        return "____atomic_old";
+    }
+    return "(" + stmtToString(expr) + ")";
+}
+
+std::string OMPToHClib::getAtomicConditionStr(const clang::Expr *cond,
+        const clang::Expr *x) {
+    const clang::BinaryOperator *bin = clang::dyn_cast<clang::BinaryOperator>(
+            cond->IgnoreParenImpCasts());
+    if (bin == NULL || !bin->isComparisonOp()) {
+        std::cerr << "Unsupported condition in atomic: " <<
+            stmtToString(cond) << std::endl;
+        exit(1);
+    }
+    return getAtomicOperandStr(bin->getLHS(), x) + " " +
+        clang::BinaryOperator::getOpcodeStr(bin->getOpcode()).str() + " " +
+        getAtomicOperandStr(bin->getRHS(), x);
+}
+
+static std::string getAtomicFetchOp(clang::BinaryOperatorKind opcode) {
+    switch (opcode) {
+        case (clang::BO_Add):
+            return "add";
+        case (clang::BO_Sub):
+            return "sub";
+        case (clang::BO_And):
+            return "and";
+        case (clang::BO_Or):
+            return "or";
+        case (clang::BO_Xor):
+            return "xor";
+        default:
+            return "";
+    }
+}
+
+/*
+ * Recognize the statement forms OpenMP allows in an atomic update or compare:
+ *
+ *   x++; x--; ++x; --x;
+ *   x binop= expr;
+ *   x = x binop expr; x = expr binop x;
+ *   x = cond ? expr : x;
+ *   if (cond) { x = expr; }
+ *
+ * With allowExchange, plain assignments of an expression that does not
+ * involve x are treated as an exchange, for the capture forms
+ * { v = x; x = expr; } and { x = expr; v = x; }.
+ */
+bool OMPToHClib::parseAtomicUpdate(const clang::Stmt *stmt,
+        AtomicUpdate &update, bool allowExchange) {
+    update.x = NULL;
+    update.operand = NULL;
+    update.fetchOp = "";
+    update.newValue = "";
+    update.guard = "";
+    update.isPostfix = false;
+    update.isExchange = false;
+
+    if (const clang::IfStmt *ifStmt = clang::dyn_cast<clang::IfStmt>(stmt)) {
+        const clang::Stmt *then = ifStmt->getThen();
+        if (const clang::CompoundStmt *compound =
+                clang::dyn_cast<clang::CompoundStmt>(then)) {
+            if (compound->size() != 1) return false;
+            then = compound->body_front();
+        }
+        const clang::BinaryOperator *assign =
+            clang::dyn_cast<clang::BinaryOperator>(then);
+        if (ifStmt->getElse() || assign == NULL ||
+                assign->getOpcode() != clang::BO_Assign) {
+            return false;
+        }
+        update.x = assign->getLHS();
+        update.guard = getAtomicConditionStr(ifStmt->getCond(), update.x);
+        update.newValue = getAtomicOperandStr(assign->getRHS(), update.x);
+        return true;
+    }
+
+    const clang::Expr *expr = clang::dyn_cast<clang::Expr>(stmt);
+    if (expr == NULL) return false;
+    expr = expr->IgnoreParens();
+
+    if (const clang::UnaryOperator *unary =
+            clang::dyn_cast<clang::UnaryOperator>(expr)) {
+        if (!unary->isIncrementDecrementOp()) return false;
+        update.x = unary->getSubExpr();
+        update.fetchOp = unary->isIncrementOp() ? "add" : "sub";
+        update.newValue = std::string("____atomic_old ") +
+            (unary->isIncrementOp() ? "+" : "-") + " 1";
+        update.isPostfix = unary->isPostfix();
+        return true;
+    }
+
+    const clang::BinaryOperator *bin = clang::dyn_cast<clang::BinaryOperator>(
+            expr);
+    if (bin == NULL) return false;
+
+    if (bin->isCompoundAssignmentOp()) {
+        clang::BinaryOperatorKind op =
+            clang::BinaryOperator::getOpForCompoundAssignment(bin->getOpcode());
+        update.x = bin->getLHS();
+        update.operand = bin->getRHS();
+        update.fetchOp = getAtomicFetchOp(op);
+        update.newValue = "____atomic_old " +
+            clang::BinaryOperator::getOpcodeStr(op).str() + " ____atomic_val";
+        return true;
+    }
+
+    if (bin->getOpcode() != clang::BO_Assign) return false;
+
+    update.x = bin->getLHS();
+    const clang::Expr *rhs = bin->getRHS()->IgnoreParenImpCasts();
+
+    if (const clang::BinaryOperator *rhsBin =
+            clang::dyn_cast<clang::BinaryOperator>(rhs)) {
+        std::string opStr = clang::BinaryOperator::getOpcodeStr(
+                rhsBin->getOpcode()).str();
+        if (sameAtomicLocation(rhsBin->getLHS(), update.x)) {
+            update.operand = rhsBin->getRHS();
+            update.fetchOp = getAtomicFetchOp(rhsBin->getOpcode());
+            update.newValue = "____atomic_old " + opStr + " ____atomic_val";
+            return true;
+        } else if (sameAtomicLocation(rhsBin->getRHS(), update.x)) {
+            update.operand = rhsBin->getLHS();
+            if (rhsBin->getOpcode() != clang::BO_Sub) {
+                // Only the commutative operators have a fetch builtin
+                update.fetchOp = getAtomicFetchOp(rhsBin->getOpcode());
+            }
+            update.newValue = "____atomic_val " + opStr + " ____atomic_old";
+            return true;
+        }
+    } else if (const clang::ConditionalOperator *cond =
+            clang::dyn_cast<clang::ConditionalOperator>(rhs)) {
+        std::string condStr = getAtomicConditionStr(cond->getCond(), update.x);
+        if (sameAtomicLocation(cond->getFalseExpr(), update.x)) {
+            update.guard = condStr;
+            update.newValue = getAtomicOperandStr(cond->getTrueExpr(),
+                    update.x);
+        } else {
+            update.newValue = "(" + condStr + ") ? " +
+                getAtomicOperandStr(cond->getTrueExpr(), update.x) + " : " +
+                getAtomicOperandStr(cond->getFalseExpr(), update.x);
+        }
+        return true;
+    }
+
+    if (!allowExchange || mentionsAtomicLocation(rhs, update.x)) {
+        return false;
+    }
+    update.operand = bin->getRHS();
+    update.newValue = "____atomic_val";
+    update.isExchange = true;
+    return true;
+}
+
+/*
+ * Recognize the capture forms:
+ *
+ *   v = <update>;
+ *   { v = x; <update>; }
+ *   { <update>; v = x; }
+ */
+bool OMPToHClib::parseAtomicCapture(const clang::Stmt *stmt,
+        AtomicUpdate &update, const clang::Expr **v, bool &captureOld) {
+    if (const clang::CompoundStmt *compound =
+            clang::dyn_cast<clang::CompoundStmt>(stmt)) {
+        if (compound->size() != 2) return false;
+        const clang::Stmt *first = compound->body_front();
+        const clang::Stmt *second = compound->body_back();
+
+        for (int order = 0; order < 2; order++) {
+            const clang::Stmt *read = (order == 0 ? first : second);
+            const clang::BinaryOperator *assign =
+                clang::dyn_cast<clang::BinaryOperator>(read);
+            if (assign == NULL || assign->getOpcode() != clang::BO_Assign) {
+                continue;
+            }
+            if (parseAtomicUpdate(order == 0 ? second : first, update,
+                        true) &&
+                    sameAtomicLocation(assign->getRHS(), update.x)) {
+                *v = assign->getLHS();
+                captureOld = (order == 0);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const clang::BinaryOperator *assign =
+        clang::dyn_cast<clang::BinaryOperator>(stmt);
+    if (assign == NULL || assign->getOpcode() != clang::BO_Assign ||
+            !parseAtomicUpdate(assign->getRHS()->IgnoreParenImpCasts(),
+                update)) {
+        return false;
+    }
+    *v = assign->getLHS();
+    captureOld = update.isPostfix;
+    return true;
+}
+
+/*
+ * Without a memory order clause OpenMP atomics are relaxed. acq_rel maps to
+ * the strongest ordering that is valid for the kind of access.
+ */
+std::string OMPToHClib::getAtomicMemoryOrder(OMPClauses *clauses, bool isLoad,
+        bool isStore) {
+    if (clauses->hasClause("seq_cst")) {
+        return "__ATOMIC_SEQ_CST";
+    } else if (clauses->hasClause("acq_rel")) {
+        if (isLoad) return "__ATOMIC_ACQUIRE";
+        else if (isStore) return "__ATOMIC_RELEASE";
+        else return "__ATOMIC_ACQ_REL";
+    } else if (clauses->hasClause("acquire") && !isStore) {
+        return "__ATOMIC_ACQUIRE";
+    } else if (clauses->hasClause("release") && !isLoad) {
+        return "__ATOMIC_RELEASE";
+    } else if (clauses->hasClause("acquire") || clauses->hasClause("release")) {
+        return "__ATOMIC_SEQ_CST";
+    } else {
+        return "__ATOMIC_RELAXED";
+    }
+}
+
+/*
+ * Integer updates with a matching builtin become a single __atomic_fetch_*.
+ * Everything else, including floating-point types, is a compare-and-swap
+ * loop on a local copy of x typed from the left hand side.
+ */
+std::string OMPToHClib::getAtomicUpdateStr(AtomicUpdate &update,
+        std::string order, const clang::Expr *v, bool captureOld) {
+    const std::string xStr = stmtToString(update.x);
+    const clang::QualType type = update.x->getType();
+    const bool isInteger = type->isIntegerType() &&
+        !type->isBooleanType() && !type->isEnumeralType();
+    const std::string captureStr = (v ? stmtToString(v) + " = " : "");
+
+    std::stringstream ss;
+    if (update.fetchOp.size() > 0 && update.guard.size() == 0 && isInteger &&
+            (update.operand == NULL ||
+             update.operand->getType()->isIntegerType())) {
+        std::string builtin = "__atomic_fetch_" + update.fetchOp;
+        if (v && !captureOld) {
+            builtin = "__atomic_" + update.fetchOp + "_fetch";
+        }
+        ss << captureStr << builtin << "(&(" << xStr << "), " <<
+            (update.operand ? stmtToString(update.operand) : "1") << ", " <<
+            order << "); ";
+    } else if (update.isExchange && (isInteger || type->isPointerType()) &&
+            captureOld) {
+        ss << captureStr << "__atomic_exchange_n(&(" << xStr << "), " <<
+            stmtToString(update.operand) << ", " << order << "); ";
+    } else {
+        // Also { x = expr; v = x; }, which captures the value stored below
+        ss << "{ " << getDeclarationTypeStr(type.getUnqualifiedType(),
+                "____atomic_old", "", "") << "; " <<
+            getDeclarationTypeStr(type.getUnqualifiedType(), "____atomic_new",
+                    "", "") << "; ";
+        if (update.operand) {
+            ss << getDeclarationTypeStr(
+                    update.operand->getType().getUnqualifiedType(),
+                    "____atomic_val", "", "") << " = " <<
+                stmtToString(update.operand) << "; ";
+        }
+        ss << "__atomic_load(&(" << xStr << "), &____atomic_old, " <<
+            "__ATOMIC_RELAXED); do { ";
+        if (update.guard.size() > 0) {
+            ss << "if (!(" << update.guard << ")) { ____atomic_new = " <<
+                "____atomic_old; break; } ";
+        }
+        ss << "____atomic_new = " << update.newValue << "; } while " <<
+            "(!__atomic_compare_exchange(&(" << xStr << "), &____atomic_old, " <<
+            "&____atomic_new, 0, " << order << ", __ATOMIC_RELAXED)); ";
+        if (v) {
+            ss << captureStr << (captureOld ? "____atomic_old" :
+                    "____atomic_new") << "; ";
+        }
+        ss << "} ";
+    }
+    return ss.str();
+}
+
+std::string OMPToHClib::getAtomicStr(const clang::Stmt *body,
+        OMPClauses *clauses) {
+    const bool isRead = clauses->hasClause("read");
+    const bool isWrite = clauses->hasClause("write");
+    const bool isCapture = clauses->hasClause("capture");
+    std::string order = getAtomicMemoryOrder(clauses, isRead, isWrite);
+
+    AtomicUpdate update;
+    std::stringstream ss;
+    if (isRead || isWrite) {
+        const clang::BinaryOperator *assign =
+            clang::dyn_cast<clang::BinaryOperator>(body);
+        if (assign == NULL || assign->getOpcode() != clang::BO_Assign) {
+            std::cerr << "Unsupported atomic " << (isRead ? "read" : "write") <<
+                ": " << stmtToString(body) << std::endl;
+            exit(1);
+        }
+
+        const clang::Expr *x = (isRead ?
+                assign->getRHS()->IgnoreParenImpCasts() : assign->getLHS());
+        const clang::QualType type = x->getType();
+        const std::string xStr = stmtToString(x);
+        const bool isScalar = type->isIntegralOrEnumerationType() ||
+            type->isPointerType();
+
+        if (isRead && isScalar) {
+            ss << stmtToString(assign->getLHS()) << " = __atomic_load_n(&(" <<
+                xStr << "), " << order << "); ";
+        } else if (isRead) {
+            ss << "{ " << getDeclarationTypeStr(type.getUnqualifiedType(),
+                    "____atomic_old", "", "") << "; __atomic_load(&(" <<
+                xStr << "), &____atomic_old, " << order << "); " <<
+                stmtToString(assign->getLHS()) << " = ____atomic_old; } ";
+        } else if (isScalar) {
+            ss << "__atomic_store_n(&(" << xStr << "), " <<
+                stmtToString(assign->getRHS()) << ", " << order << "); ";
+        } else {
+            ss << "{ " << getDeclarationTypeStr(type.getUnqualifiedType(),
+                    "____atomic_new", "", "") << " = " <<
+                stmtToString(assign->getRHS()) << "; __atomic_store(&(" <<
+                xStr << "), &____atomic_new, " << order << "); } ";
+        }
+    } else if (isCapture) {
+        const clang::Expr *v = NULL;
+        bool captureOld = false;
+        if (!parseAtomicCapture(body, update, &v, captureOld)) {
+            std::cerr << "Unsupported atomic capture: " << stmtToString(body) <<
+                std::endl;
+            exit(1);
+        }
+        ss << getAtomicUpdateStr(update, order, v, captureOld);
+    } else {
+        // update and compare
+        if (!parseAtomicUpdate(body, update)) {
+            std::cerr << "Unsupported atomic update: " << stmtToString(body) <<
+                std::endl;
+            exit(1);
+        }
+        ss << getAtomicUpdateStr(update, order, NULL, false);
+    }
+    return ss.str();
+}
+
+/*
+ * All critical sections with the same name share one lock, and all unnamed
+ * critical sections share another. The locks and the functions that operate
+ * on them are declared by insert_critical_locks.py.
+ */
+std::string OMPToHClib::getCriticalSectionLockName(OMPClauses *clauses) {
+    if (clauses->hasClause("name")) {
+        return "____critical_" + clauses->getSingleArg("name") + "_lock";
+    } else {
+        return "____critical_lock";
+    }
+}
+
+std::string OMPToHClib::getCriticalSectionLockStr(OMPClauses *clauses) {
     std::stringstream lock_ss;
-    lock_ss << " { const int ____lock_" << criticalSectionId <<
-        "_err = pthread_mutex_lock(&critical_" <<
-        criticalSectionId << "_lock); assert(____lock_" <<
-        criticalSectionId << "_err == 0); ";
+    lock_ss << " { ____critical_acquire(&" <<
+        getCriticalSectionLockName(clauses) << "); ";
     return lock_ss.str();
 }
 
-std::string OMPToHClib::getCriticalSectionUnlockStr(int criticalSectionId) {
+std::string OMPToHClib::getCriticalSectionUnlockStr(OMPClauses *clauses) {
     std::stringstream unlock_ss;
-    unlock_ss << "; const int ____unlock_" <<
-        criticalSectionId << "_err = " <<
-        "pthread_mutex_unlock(&critical_" <<
-        criticalSectionId << "_lock); assert(____unlock_" <<
-        criticalSectionId << "_err == 0); } ";
+    unlock_ss << "; ____critical_release(&" <<
+        getCriticalSectionLockName(clauses) << "); } ";
     return unlock_ss.str();
 }
 
+/*
+ * Emit a freelist allocator specialized for one task context struct. Each
+ * worker keeps a private list of free slots that it pops and pushes without
+ * synchronization. A context freed by a worker other than the one that
+ * allocated it, e.g. because the task was stolen, is pushed onto the owner's
+ * remote list with a CAS. The owner takes the whole remote list in one atomic
+ * exchange when its private list runs dry, so the remote list never sees a
+ * concurrent pop. Slots are never returned to the system allocator.
+ */
+std::string OMPToHClib::getContextPoolDef(std::string structName) {
+    std::stringstream ss;
+    ss << "typedef struct _" << structName << "_slot {" << std::endl;
+    // ctx must stay first so a context pointer can be cast back to its slot
+    ss << "    " << structName << " ctx;" << std::endl;
+    ss << "    struct _" << structName << "_slot *next;" << std::endl;
+    ss << "    int owner;" << std::endl;
+    ss << " } " << structName << "_slot;" << std::endl << std::endl;
+
+    ss << "typedef struct _" << structName << "_pool {" << std::endl;
+    ss << "    " << structName << "_slot *local;" << std::endl;
+    ss << "    " << structName << "_slot *remote;" << std::endl;
+    ss << "    char ____pad[64];" << std::endl;
+    ss << " } " << structName << "_pool;" << std::endl << std::endl;
+
+    ss << "static " << structName << "_pool *" << structName <<
+        "_pools = NULL;" << std::endl << std::endl;
+
+    ss << "static " << structName << "_pool *" << structName <<
+        "_get_pools() {" << std::endl;
+    ss << "    " << structName << "_pool *pools = __atomic_load_n(&" <<
+        structName << "_pools, __ATOMIC_ACQUIRE);" << std::endl;
+    ss << "    if (pools == NULL) {" << std::endl;
+    ss << "        " << structName << "_pool *fresh = (" << structName <<
+        "_pool *)calloc(hclib_get_num_workers(), sizeof(" << structName <<
+        "_pool));" << std::endl;
+    ss << "        if (__atomic_compare_exchange_n(&" << structName <<
+        "_pools, &pools, fresh, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {" <<
+        std::endl;
+    ss << "            pools = fresh;" << std::endl;
+    ss << "        } else {" << std::endl;
+    ss << "            free(fresh);" << std::endl;
+    ss << "        }" << std::endl;
+    ss << "    }" << std::endl;
+    ss << "    return pools;" << std::endl;
+    ss << "}" << std::endl << std::endl;
+
+    ss << "static " << structName << " *" << structName << "_alloc() {" <<
+        std::endl;
+    ss << "    const int worker = hclib_get_current_worker();" << std::endl;
+    ss << "    " << structName << "_pool *pool = " << structName <<
+        "_get_pools() + worker;" << std::endl;
+    ss << "    " << structName << "_slot *slot = pool->local;" << std::endl;
+    ss << "    if (slot == NULL) {" << std::endl;
+    ss << "        slot = __atomic_exchange_n(&pool->remote, NULL, " <<
+        "__ATOMIC_ACQUIRE);" << std::endl;
+    ss << "    }" << std::endl;
+    ss << "    if (slot == NULL) {" << std::endl;
+    ss << "        slot = (" << structName << "_slot *)malloc(sizeof(" <<
+        structName << "_slot));" << std::endl;
+    ss << "        slot->owner = worker;" << std::endl;
+    ss << "    } else {" << std::endl;
+    ss << "        pool->local = slot->next;" << std::endl;
+    ss << "    }" << std::endl;
+    ss << "    return &slot->ctx;" << std::endl;
+    ss << "}" << std::endl << std::endl;
+
+    ss << "static void " << structName << "_free(" << structName <<
+        " *ctx) {" << std::endl;
+    ss << "    " << structName << "_slot *slot = (" << structName <<
+        "_slot *)ctx;" << std::endl;
+    ss << "    " << structName << "_pool *pool = " << structName <<
+        "_get_pools() + slot->owner;" << std::endl;
+    ss << "    if (slot->owner == hclib_get_current_worker()) {" << std::endl;
+    ss << "        slot->next = pool->local;" << std::endl;
+    ss << "        pool->local = slot;" << std::endl;
+    ss << "    } else {" << std::endl;
+    ss << "        " << structName << "_slot *head = __atomic_load_n(" <<
+        "&pool->remote, __ATOMIC_RELAXED);" << std::endl;
+    ss << "        do {" << std::endl;
+    ss << "            slot->next = head;" << std::endl;
+    ss << "        } while (!__atomic_compare_exchange_n(&pool->remote, " <<
+        "&head, slot, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));" << std::endl;
+    ss << "    }" << std::endl;
+    ss << "}" << std::endl << std::endl;
+
+    return ss.str();
+}
+
 std::string OMPToHClib::getContextSetup(PragmaNode *node,
         std::string structName, std::vector<clang::ValueDecl *> *captured,
-        OMPClauses *clauses) {
+        OMPClauses *clauses, bool pooledContext) {
     std::stringstream ss;
-    ss << structName << " *new_ctx = (" << structName << " *)malloc(sizeof(" <<
-        structName << "));\n";
+    if (pooledContext) {
+        ss << structName << " *new_ctx = " << structName << "_alloc();\n";
+    } else {
+        ss << structName << " *new_ctx = (" << structName <<
+            " *)malloc(sizeof(" << structName << "));\n";
+    }
     std::vector<OMPVarInfo> *vars = clauses->getVarInfo(captured);
 
     for (std::vector<OMPVarInfo>::iterator i = vars->begin(), e = vars->end();
@@ -1528,7 +6396,22 @@ std::string OMPToHClib::getContextSetup(PragmaNode *node,
                 }
                 break;
             case (CAPTURE_TYPE::LASTPRIVATE):
-                assert(false);
+                if (decl->getType()->isArrayType()) {
+                    std::cerr << "Array \"" << decl->getNameAsString() <<
+                        "\" in the lastprivate clause at line " <<
+                        node->getStartLine() << " is unsupported" << std::endl;
+                    exit(1);
+                }
+                // Only the address is needed, for the final write back
+                if (parentType == CAPTURE_TYPE::SHARED) {
+                    ss << "new_ctx->" << decl->getNameAsString() <<
+                        "_ptr = ctx->" << decl->getNameAsString() << "_ptr;" <<
+                        std::endl;
+                } else {
+                    ss << "new_ctx->" << decl->getNameAsString() <<
+                        "_ptr = &(" << decl->getNameAsString() << ");" <<
+                        std::endl;
+                }
                 break;
             default:
                 std::cerr << "Unsupported capture type" << std::endl;
@@ -1542,14 +6425,125 @@ std::string OMPToHClib::getContextSetup(PragmaNode *node,
                 e = reductions->end(); i != e; i++) {
             OMPReductionVar red = *i;
             // Initialize the reduction target based on the reduction op
-            ss << "new_ctx->" << red.getVar() << " = " << red.getInitialValue() <<
-                ";\n";
+            ss << "new_ctx->" << red.getVar() << " = " << red.getInitialValue(
+                    getReductionDecl(red, vars)->getType()) << ";\n";
+        }
+
+        ss << "new_ctx->per_worker_reductions = (" << structName <<
+            "_reduction *)malloc(hclib_get_num_workers() * sizeof(" <<
+            structName << "_reduction));\n";
+        ss << "int ____worker;\n";
+        ss << "for (____worker = 0; ____worker < hclib_get_num_workers(); " <<
+            "____worker++) {\n";
+        for (std::vector<OMPReductionVar>::iterator i = reductions->begin(),
+                e = reductions->end(); i != e; i++) {
+            OMPReductionVar red = *i;
+            ss << "    new_ctx->per_worker_reductions[____worker]." <<
+                red.getVar() << " = " << red.getInitialValue(
+                        getReductionDecl(red, vars)->getType()) << ";\n";
+        }
+        ss << "}\n";
+    }
+
+    return ss.str();
+}
+
+/*
+ * Lower an omp simd pragma to a vectorization directive in front of its loop.
+ * OpenMP-SIMD support (-fopenmp-simd or equivalent) is available in all major
+ * compilers without pulling in the OpenMP runtime, so by default the pragma is
+ * kept as-is along with its clauses. Plain GCC ignores it without that flag, so
+ * there we fall back to ivdep, which promises the same lack of loop-carried
+ * dependencies as long as the pragma does not bound the safe vector length.
+ */
+std::string OMPToHClib::getSimdDirectiveStr(std::string pragmaArgs,
+        OMPClauses *clauses) {
+    std::string ompDirective = "#pragma omp " + pragmaArgs + "\n";
+    if (clauses->hasClause("safelen") || clauses->hasClause("simdlen")) {
+        return ompDirective;
+    }
+
+    return std::string("#if defined(__GNUC__) && !defined(__clang__) && ") +
+        "!defined(_OPENMP) && !defined(OMP_TO_HCLIB_OPENMP_SIMD)\n" +
+        "#pragma GCC ivdep\n" +
+        "#else\n" + ompDirective + "#endif\n";
+}
+
+/*
+ * The simd clauses name variables, which stay as they are once the enclosing
+ * closure rewrites the uses of its shared captures in the loop into
+ * dereferences of the context. Such variables are shadowed around the loop
+ * by locals of the same name that hold copies of them, and those that the
+ * loop writes are copied back once it is done.
+ */
+void OMPToHClib::getSimdShadowStrs(PragmaNode *node, OMPClauses *clauses,
+        std::string &before, std::string &after) {
+    static const char *varClauses[] = {"private", "lastprivate", "reduction",
+        "linear", "aligned", "nontemporal", NULL};
+    std::stringstream temps;
+    std::stringstream shadows;
+    std::stringstream writeBacks;
+    std::stringstream restores;
+    std::vector<std::string> shadowed;
+    std::vector<clang::ValueDecl *> *captures = node->getCaptures();
+
+    for (int c = 0; varClauses[c] != NULL; c++) {
+        const std::string clause = varClauses[c];
+        if (!clauses->hasClause(clause)) {
+            continue;
+        }
+        std::vector<std::string> *args = clauses->getFlattenedArgsList(clause);
+        for (std::vector<std::string>::iterator i = args->begin(),
+                e = args->end(); i != e; i++) {
+            const std::string varname = *i;
+            clang::ValueDecl *decl = NULL;
+            for (std::vector<clang::ValueDecl *>::iterator ii =
+                    captures->begin(), ee = captures->end(); ii != ee; ii++) {
+                if (decl == NULL && (*ii)->getNameAsString() == varname) {
+                    decl = *ii;
+                }
+            }
+            // Reduction operators, alignments, steps and globals are skipped
+            if (decl == NULL || std::find(shadowed.begin(), shadowed.end(),
+                        varname) != shadowed.end() ||
+                    getParentCaptureType(node->getParentAccountForFusing(),
+                        varname) != CAPTURE_TYPE::SHARED) {
+                continue;
+            }
+
+            clang::QualType type = decl->getType();
+            if (type->isArrayType() || type->isReferenceType()) {
+                std::cerr << "Array or reference \"" << varname << "\" in " <<
+                    "the " << clause << " clause of the simd pragma at line " <<
+                    node->getStartLine() << " is unsupported" << std::endl;
+                exit(1);
+            }
+            shadowed.push_back(varname);
+
+            const std::string temp = "____simd_" + varname;
+            if (clause == "private") {
+                shadows << getDeclarationTypeStr(type, varname, "", "") << "; ";
+                continue;
+            }
+            temps << getDeclarationTypeStr(type, temp, "", "") << " = " <<
+                varname << "; ";
+            shadows << getDeclarationTypeStr(type, varname, "", "") << " = " <<
+                temp << "; ";
+            if (clause == "lastprivate" || clause == "reduction" ||
+                    clause == "linear") {
+                writeBacks << temp << " = " << varname << "; ";
+                restores << varname << " = " << temp << "; ";
+            }
         }
-        ss << "const int init_err = pthread_mutex_init(&new_ctx->reduction_mutex, NULL);\n";
-        ss << "assert(init_err == 0);\n";
     }
 
-    return ss.str();
+    if (shadowed.empty()) {
+        before = "";
+        after = "";
+    } else {
+        before = " { " + temps.str() + "{ " + shadows.str() + "\n";
+        after = " ; " + writeBacks.str() + "} " + restores.str() + "} ";
+    }
 }
 
 void OMPToHClib::removePragma(PragmaNode *node) {
@@ -1577,11 +6571,38 @@ void OMPToHClib::postFunctionVisit(clang::FunctionDecl *func) {
 
         pragmaTree->print();
 
+        const bool taskCutoff = isFeatureEnabled("task_cutoff") &&
+            target == HCLIB;
+        const bool inSequentialClone = taskCutoff && isSequentialClone(func);
+        if (taskCutoff && !inSequentialClone && definedFunctions.find(fname +
+                    SEQ_CLONE_SUFFIX) == definedFunctions.end()) {
+            int nTasks = 0;
+            if (canCloneSequentially(func, pragmaTree, nTasks) && nTasks > 0) {
+                /*
+                 * Copy the function before converting anything in it. Its
+                 * pragmas are converted starting with the next iteration.
+                 */
+                createSequentialClone(func);
+                return;
+            }
+        }
+        if (inSequentialClone) {
+            redirectCallsToClones(func->getBody());
+        }
+
         std::string accumulatedStructDefs = "";
         std::string accumulatedKernelDecls = "";
         std::string accumulatedKernelDefs = "";
 
         std::vector<PragmaNode *> *leaves = pragmaTree->getLeaves();
+        std::set<const clang::CompoundStmt *> regionsWithCounters;
+        std::set<const clang::Stmt *> hoistedTimeLoops;
+
+        const bool staticDepends = target == HCLIB &&
+            isFeatureEnabled("static_depends") && !inSequentialClone &&
+            canResolveDependsStatically(func, taskCutoff);
+        // Set once a task is registered with the tile graph in this pass
+        bool convertedTileDeps = false;
 
         for (std::vector<PragmaNode *>::iterator i = leaves->begin(),
                 e = leaves->end(); i != e; i++) {
@@ -1637,9 +6658,8 @@ void OMPToHClib::postFunctionVisit(clang::FunctionDecl *func) {
                     if (target == HCLIB) {
                         const clang::Stmt *body = node->getBody();
 
-                        std::string lock = getCriticalSectionLockStr(criticalSectionId);
-                        std::string unlock = getCriticalSectionUnlockStr(criticalSectionId);
-                        criticalSectionId++;
+                        std::string lock = getCriticalSectionLockStr(clauses);
+                        std::string unlock = getCriticalSectionUnlockStr(clauses);
 
                         const bool failed = rewriter->ReplaceText(
                                 clang::SourceRange(node->getStartLoc(), node->getEndLoc()),
@@ -1649,48 +6669,67 @@ void OMPToHClib::postFunctionVisit(clang::FunctionDecl *func) {
                         removePragma(node);
                     }
                 } else if (ompCmd == "atomic") {
-                    // For now we implement atomic with rather heavyweight locks
-                    // TODO, use actual atomic instructions
-                    const clang::Stmt *body = node->getBody();
-                    const clang::BinaryOperator *bin = clang::dyn_cast<clang::BinaryOperator>(body);
-                    assert(bin);
-                    clang::Expr *rhs = bin->getRHS();
-
-                    std::stringstream tmp_varname;
-                    tmp_varname << "____critical_section_tmp_" << criticalSectionId;
-
-                    clang::Expr *lhs = bin->getLHS();
-                    clang::DeclRefExpr *declRef = clang::dyn_cast<clang::DeclRefExpr>(lhs);
-                    assert(declRef);
-                    clang::ValueDecl *decl = declRef->getDecl();
-                    std::string typeStr = decl->getType().getAsString();
-
-                    // std::string lock = getCriticalSectionLockStr(criticalSectionId);
-                    // std::string unlock = getCriticalSectionUnlockStr(criticalSectionId);
-                    // std::stringstream ss;
-                    // ss << "const " << typeStr << " " << tmp_varname.str() << " = " << stmtToString(rhs) <<
-                    //     ";" << std::endl;
-                    // criticalSectionId++;
-
-                    if (bin->getOpcode() == clang::BO_AddAssign) {
-                        std::stringstream ss;
-                        ss << "__sync_fetch_and_add(&(" << stmtToString(lhs) << "), " << stmtToString(rhs) << "); ";
-                        const bool failed = rewriter->ReplaceText(clang::SourceRange(node->getStartLoc(), node->getEndLoc()),
-                                ss.str());
-                        // const bool failed = rewriter->ReplaceText(
-                        //         clang::SourceRange(node->getStartLoc(), node->getEndLoc()),
-                        //         ss.str() + lock + stmtToString(lhs) + " += " + tmp_varname.str() + " " + unlock);
-                        assert(!failed);
-                    } else {
-                        std::cerr << "Unsupported binary operator in atomic: " << bin->getOpcode() << std::endl;
-                        exit(1);
-                    }
+                    const bool failed = rewriter->ReplaceText(
+                            clang::SourceRange(node->getStartLoc(),
+                                node->getEndLoc()),
+                            getAtomicStr(node->getBody(), clauses));
+                    assert(!failed);
                 } else if (ompCmd == "taskwait") {
-                    if (target == HCLIB) {
+                    PragmaNode *owner = NULL;
+                    const clang::CompoundStmt *region = NULL;
+
+                    if (inSequentialClone) {
+                        /*
+                         * Once all tasks in the clone run in place, there is
+                         * nothing to wait for unless it calls a function that
+                         * still spawns tasks.
+                         */
+                        if (containsPragmaCmd(pragmaTree, "task")) {
+                            continue;
+                        } else if (!canLaunchTasks(func->getBody())) {
+                            removePragma(node);
+                            continue;
+                        }
+                    }
+
+                    if (target == HCLIB && isFeatureEnabled("taskwait_counters") &&
+                            getTaskRegion(node, func, &owner, &region) &&
+                            !stmtSatisfies(region, LAUNCHES_TASKS, true) &&
+                            regionAwaitsAllTasks(node->getParent())) {
+                        /*
+                         * Every task that can be spawned in this region
+                         * appears directly inside it and is waited on before
+                         * the region exits, so each one can increment a
+                         * counter local to the region when it is created and
+                         * decrement it when it completes. The taskwait
+                         * executes other tasks until the counter drops to
+                         * zero.
+                         */
+                        std::string counter = getPendingChildrenCounter(owner);
+                        if (regionsWithCounters.find(region) ==
+                                regionsWithCounters.end()) {
+                            const bool failed = rewriter->InsertTextAfterToken(
+                                    region->getLBracLoc(),
+                                    " int " + counter + " = 0; ");
+                            assert(!failed);
+                            regionsWithCounters.insert(region);
+                        }
+
+                        const bool failed = rewriter->ReplaceText(
+                                clang::SourceRange(node->getStartLoc(),
+                                    node->getEndLoc()),
+                                getTaskwaitStr(" while (__atomic_load_n(&" +
+                                    counter + ", __ATOMIC_ACQUIRE) > 0) { " +
+                                    "hclib_yield(NULL); } ", taskCutoff,
+                                    accumulatedStructDefs));
+                        assert(!failed);
+                    } else if (target == HCLIB) {
                         const bool failed = rewriter->ReplaceText(
                                 clang::SourceRange(node->getStartLoc(),
                                     node->getEndLoc()),
-                                " hclib_end_finish(); hclib_start_finish(); ");
+                                getTaskwaitStr(
+                                    " hclib_end_finish(); hclib_start_finish(); ",
+                                    taskCutoff, accumulatedStructDefs));
                         assert(!failed);
                     } else {
                         removePragma(node);
@@ -1712,10 +6751,32 @@ void OMPToHClib::postFunctionVisit(clang::FunctionDecl *func) {
                         exit(1);
                     }
 
-                    if (target == HCLIB) {
-                        const clang::CompoundStmt *parentCmpd =
-                            clang::dyn_cast<clang::CompoundStmt>(
-                                    node->getParent()->getBody());
+                    const clang::CompoundStmt *parentCmpd =
+                        clang::dyn_cast<clang::CompoundStmt>(
+                                node->getParent()->getBody());
+                    if (target == HCLIB && parentCmpd &&
+                            parentCmpd->size() > 2 &&
+                            getEnclosingTeam(node) != NULL) {
+                        /*
+                         * Alongside other code in a parallel region, the body
+                         * is executed by the first thread of the team. Other
+                         * threads wait for a single to complete unless it is
+                         * nowait.
+                         */
+                        declareTeamVars(node->getParent(),
+                                accumulatedStructDefs);
+                        std::string str = std::string(" if (") +
+                            THREAD_NUM_VAR + " == 0) { " +
+                            stmtToString(node->getBody()) + " ; } ";
+                        if (ompCmd == "single" && !clauses->hasClause("nowait")) {
+                            str += std::string("____omp_team_barrier(") +
+                                TEAM_VAR + "); ";
+                        }
+                        const bool failed = rewriter->ReplaceText(
+                                clang::SourceRange(node->getStartLoc(),
+                                    node->getEndLoc()), str);
+                        assert(!failed);
+                    } else if (target == HCLIB) {
                         assert(parentCmpd);
                         assert(parentCmpd->size() == 2);
                         clang::CompoundStmt::const_body_iterator bodyIter = parentCmpd->body_begin();
@@ -1782,41 +6843,254 @@ void OMPToHClib::postFunctionVisit(clang::FunctionDecl *func) {
                 } else if (ompCmd == "task") {
                     switch (target) {
                         case (HCLIB): {
+                            if (inSequentialClone) {
+                                std::string inlineStr;
+                                const bool canInline = getInlineTaskStr(node,
+                                        getOMPClausesForMarker(node->getMarker()),
+                                        inlineStr);
+                                assert(canInline);
+                                const bool failed = rewriter->ReplaceText(
+                                        clang::SourceRange(node->getStartLoc(),
+                                            node->getEndLoc()),
+                                        " { " + inlineStr + " } ");
+                                assert(!failed);
+                                break;
+                            }
+
+                            const bool taskwaitCounters = isFeatureEnabled(
+                                    "taskwait_counters");
+                            if (taskwaitCounters && pendingTaskwaits) {
+                                /*
+                                 * Wait for all taskwaits to be lowered first,
+                                 * so that this task can find the counter of
+                                 * the region it is spawned in and tell whether
+                                 * its body still waits on a finish scope.
+                                 */
+                                break;
+                            }
+
                             const clang::Stmt *body = node->getBody();
                             OMPClauses *clauses = getOMPClausesForMarker(
                                     node->getMarker());
+
+                            std::string pendingCounter = "";
+                            PragmaNode *owner = NULL;
+                            const clang::CompoundStmt *region = NULL;
+                            if (taskwaitCounters &&
+                                    getTaskRegion(node, func, &owner, &region)) {
+                                std::string counter =
+                                    getPendingChildrenCounter(owner);
+                                std::vector<clang::ValueDecl *> *captures =
+                                    node->getCaptures();
+                                for (std::vector<clang::ValueDecl *>::iterator i =
+                                        captures->begin(), e = captures->end();
+                                        i != e; i++) {
+                                    if ((*i)->getNameAsString() == counter) {
+                                        pendingCounter = counter;
+                                    }
+                                }
+                            }
+                            if (pendingCounter.size() > 0) {
+                                /*
+                                 * The closure decrements its parent's counter
+                                 * through this pointer once it completes.
+                                 */
+                                clauses->addClauseArg("shared", pendingCounter);
+                            }
+
+                            /*
+                             * Conditions under which the task is undeferred or
+                             * included, and so can run in place. Inside a
+                             * final task every descendant task is included.
+                             */
+                            std::vector<std::string> inlineConds;
+                            if (clauses->hasClause("if")) {
+                                // We have already asserted there is only one if arg
+                                inlineConds.push_back("!(" +
+                                        clauses->getSingleArg("if") + ")");
+                            }
+                            if (clauses->hasClause("final")) {
+                                inlineConds.push_back("____omp_final");
+                            }
+                            if (anyFinalTasks) {
+                                inlineConds.push_back(std::string(
+                                            FINAL_DEPTH_VAR) + " > 0");
+                                std::string def = getWorkerLocalDef(
+                                        FINAL_DEPTH_VAR);
+                                if (accumulatedStructDefs.find(def) ==
+                                        std::string::npos) {
+                                    accumulatedStructDefs += def;
+                                }
+                            }
+                            if (taskCutoff) {
+                                inlineConds.push_back(node->getLbl() + "_CUTOFF");
+                                std::string def = getTaskDepthDef();
+                                if (accumulatedStructDefs.find(def) ==
+                                        std::string::npos) {
+                                    accumulatedStructDefs += def;
+                                }
+                                accumulatedStructDefs += getCutoffDef(
+                                        node->getLbl());
+                            }
+
+                            /*
+                             * The blocks of a wavefront may only start once
+                             * the first block they depend on is done, which
+                             * is left to the runtime, so they are never run
+                             * in place.
+                             */
+                            const bool wavefrontBlock = isWavefrontBlock(
+                                    node);
+                            if (wavefrontBlock) {
+                                inlineConds.clear();
+                            }
+
+                            /*
+                             * Tasks with dependencies still go through their
+                             * closure so that the runtime sees them.
+                             */
+                            std::string inlineStr;
+                            const bool runInPlace = inlineConds.size() > 0 &&
+                                !clauses->hasClause("depend") &&
+                                getInlineTaskStr(node, clauses, inlineStr,
+                                        taskCutoff);
+
+                            // Must precede the shared variable rewriting below
                             std::string bodyStr = stmtToStringWithSharedVars(body,
                                     clauses->getSharedVarInfo(node->getCaptures()));
+                            if (taskCutoff) {
+                                /*
+                                 * Tasks spawned by the body are one level
+                                 * deeper. The body may resume on another
+                                 * worker after a taskwait, so the sites in it
+                                 * read the depth from a local copy of the
+                                 * context's, which shadows the worker-local
+                                 * one. The worker-local depth is set for the
+                                 * functions the body calls, and restored on
+                                 * exit for the code that the worker was
+                                 * running when it picked up the task, e.g. a
+                                 * blocking wait outside of any task body.
+                                 */
+                                bodyStr = "{ const int ____entry_depth = " +
+                                    std::string(TASK_DEPTH_VAR) + "; " +
+                                    TASK_DEPTH_VAR + " = ctx->____depth; " +
+                                    "{ const int " + TASK_DEPTH_VAR +
+                                    " = ctx->____depth; " + bodyStr + " ; } " +
+                                    TASK_DEPTH_VAR + " = ____entry_depth; }";
+                            }
+
+                            /*
+                             * With taskwait counters, a task body only needs
+                             * its own finish scope if something inside it
+                             * still lowers taskwait to hclib_end_finish.
+                             */
+                            bool wrapBodyInFinish = canLaunchTasks(body);
+                            if (taskwaitCounters) {
+                                wrapBodyInFinish = wrapBodyInFinish &&
+                                    stmtSatisfies(body, WAITS_ON_FINISH, false);
+                            }
+
+                            /*
+                             * A task whose dependencies are wired statically
+                             * completes its promise once its body, and any
+                             * tasks the body spawned, are done.
+                             */
+                            const bool tileDeps = staticDepends &&
+                                clauses->hasClause("depend");
+                            if (tileDeps) {
+                                convertedTileDeps = true;
+                                if (wrapBodyInFinish) {
+                                    bodyStr = "hclib_start_finish(); " +
+                                        bodyStr + " ; hclib_end_finish();";
+                                    wrapBodyInFinish = false;
+                                }
+                                bodyStr = "{ ____omp_tile_task_wait(" +
+                                    std::string("ctx->____deps); ") + bodyStr +
+                                    " ; ____omp_tile_task_done(ctx->____deps); }";
+                            }
+                            const bool emulatedDeps = !tileDeps &&
+                                clauses->hasClause("depend");
 
                             bool isAcceleratable = false;
                             accumulatedKernelDecls += getClosureDecl(
                                     node->getLbl() + ASYNC_SUFFIX, false, -1,
-                                    clauses->hasClause("depend"), isAcceleratable);
+                                    emulatedDeps, isAcceleratable);
+
+                            const bool pooledContext = isFeatureEnabled(
+                                    "task_ctx_pool");
 
                             accumulatedKernelDefs += getClosureDef(
                                     node->getLbl() + ASYNC_SUFFIX, false, true,
                                     node->getLbl(), node->getCaptures(),
-                                    bodyStr, clauses->hasClause("depend"),
-                                    clauses, canLaunchTasks(body), false);
+                                    bodyStr, emulatedDeps,
+                                    clauses, wrapBodyInFinish, false, NULL,
+                                    false, pooledContext, pendingCounter);
 
                             const std::string structDef = getStructDef(
-                                    node->getLbl(), node->getCaptures(), clauses);
+                                    node->getLbl(), node->getCaptures(), clauses,
+                                    0, taskCutoff, false, tileDeps);
                             accumulatedStructDefs += structDef;
+                            if (pooledContext) {
+                                accumulatedStructDefs += getContextPoolDef(
+                                        node->getLbl());
+                            }
 
                             std::stringstream contextCreation;
+                            std::string finalDepthInc = "";
+                            std::string finalDepthDec = "";
+                            std::string inlineCond = "";
+                            for (std::vector<std::string>::iterator i =
+                                    inlineConds.begin(), e = inlineConds.end();
+                                    i != e; i++) {
+                                if (inlineCond.size() > 0) inlineCond += " || ";
+                                inlineCond += *i;
+                            }
+                            if (clauses->hasClause("final")) {
+                                contextCreation << "\nconst int ____omp_final = (" <<
+                                    clauses->getSingleArg("final") << ");";
+                                finalDepthInc = std::string("if (____omp_final) ") +
+                                    FINAL_DEPTH_VAR + "++;\n";
+                                finalDepthDec = std::string("if (____omp_final) ") +
+                                    FINAL_DEPTH_VAR + "--;\n";
+                            }
+
+                            if (runInPlace) {
+                                // No context, no allocation and no finish scope
+                                contextCreation << "\nif (" << inlineCond << ") {\n";
+                                contextCreation << finalDepthInc << inlineStr <<
+                                    finalDepthDec;
+                                contextCreation << "} else {";
+                            }
+
                             contextCreation << "\n" << getContextSetup(node,
-                                    node->getLbl(), node->getCaptures(), clauses);
+                                    node->getLbl(), node->getCaptures(), clauses,
+                                    pooledContext);
+                            if (taskCutoff) {
+                                contextCreation << "new_ctx->____depth = " <<
+                                    TASK_DEPTH_VAR << " + 1;\n";
+                            }
+                            if (pendingCounter.size() > 0) {
+                                contextCreation << "__atomic_fetch_add(&" <<
+                                    pendingCounter << ", 1, __ATOMIC_RELAXED);\n";
+                            }
 
-                            if (clauses->hasClause("if")) {
-                                // We have already asserted there is only one if arg
-                                std::string ifArg = clauses->getSingleArg("if");
-                                // If the if condition is false, just call the task body sequentially
-                                contextCreation << "if (!(" << ifArg << ")) {\n";
+                            if (!runInPlace && inlineCond.size() > 0) {
+                                // Call the task body sequentially
+                                contextCreation << "if (" << inlineCond << ") {\n";
+                                contextCreation << finalDepthInc;
                                 contextCreation << "    " << node->getLbl() << ASYNC_SUFFIX << "(new_ctx);\n";
+                                contextCreation << finalDepthDec;
                                 contextCreation << "} else {\n";
                             }
 
-                            if (clauses->hasClause("depend")) {
+                            if (tileDeps) {
+                                contextCreation << getTileDepsSetup(node,
+                                        clauses);
+                                contextCreation << "hclib_async(" <<
+                                    node->getLbl() << ASYNC_SUFFIX <<
+                                    ", new_ctx, ____omp_tile_task_first(" <<
+                                    "____deps), ANY_PLACE);\n";
+                            } else if (clauses->hasClause("depend")) {
                                 OMPDependencies *depends = new OMPDependencies(
                                         clauses->getArgs("depend"));
                                 std::vector<OMPDependency> *in =
@@ -1842,12 +7116,17 @@ void OMPToHClib::postFunctionVisit(clang::FunctionDecl *func) {
                                 }
                                 contextCreation << ");\n";
 
+                            } else if (wavefrontBlock) {
+                                contextCreation << "hclib_async(" <<
+                                    node->getLbl() << ASYNC_SUFFIX <<
+                                    ", new_ctx, " << WAVEFRONT_FIRST_VAR <<
+                                    ", ANY_PLACE);\n";
                             } else {
                                 contextCreation << "hclib_async(" << node->getLbl() <<
                                     ASYNC_SUFFIX << ", new_ctx, NO_FUTURE, ANY_PLACE);\n";
                             }
 
-                            if (clauses->hasClause("if")) {
+                            if (inlineCond.size() > 0) {
                                 contextCreation << "}\n";
                             }
 
@@ -1867,10 +7146,114 @@ void OMPToHClib::postFunctionVisit(clang::FunctionDecl *func) {
                                 std::endl;
                             exit(1);
                     }
-                } else if (ompCmd == "parallel") {
+                } else if (ompCmd == "parallel" ||
+                        (ompCmd == "taskloop" && target == HCLIB)) {
                     OMPClauses *clauses = getOMPClausesForMarker(node->getMarker());
 
-                    if (clauses->hasClause("for")) {
+                    /*
+                     * A taskloop is lowered like a parallel loop, except that
+                     * its grainsize or num_tasks sets the tile size and with
+                     * nogroup the encountering task does not wait for it.
+                     */
+                    if (clauses->hasClause("for") || ompCmd == "taskloop") {
+
+                        /*
+                         * A loop over the diagonals of a blocked wavefront
+                         * around the loop becomes a graph of block tasks,
+                         * which are lowered in later passes.
+                         */
+                        if (target == HCLIB && ompCmd == "parallel" &&
+                                isFeatureEnabled("wavefront")) {
+                            const clang::Stmt *timeLoop = getTimeLoop(node);
+                            if (timeLoop != NULL && isDiagonalSweep(node,
+                                        timeLoop)) {
+                                const bool failed = rewriter->ReplaceText(
+                                        timeLoop->getSourceRange(),
+                                        getWavefrontStr(node, timeLoop));
+                                assert(!failed);
+                                continue;
+                            }
+                        }
+
+                        /*
+                         * A stencil time step loop around the loop is
+                         * rewritten to run blocks of steps tile by tile. Its
+                         * parallel loops are lowered in later passes.
+                         */
+                        if (target == HCLIB && ompCmd == "parallel" &&
+                                isFeatureEnabled("temporal_blocking")) {
+                            const clang::Stmt *timeLoop = getTimeLoop(node);
+                            const clang::ValueDecl *in = NULL;
+                            const clang::ValueDecl *out = NULL;
+                            const clang::ValueDecl *cols = NULL;
+                            int radius = 0;
+                            if (timeLoop != NULL && canBlockTemporally(node,
+                                        timeLoop, func->getBody(), &in, &out,
+                                        &cols, radius)) {
+                                const bool failed = rewriter->ReplaceText(
+                                        timeLoop->getSourceRange(),
+                                        getTemporalBlockingStr(node, timeLoop,
+                                            in, out, cols, radius));
+                                assert(!failed);
+                                continue;
+                            }
+                        }
+
+                        /*
+                         * Adjacent parallel loops become a single parallel
+                         * region of omp for loops, so that they are executed
+                         * by one team. The region is lowered in later passes.
+                         */
+                        if (target == HCLIB && ompCmd == "parallel" &&
+                                isFeatureEnabled("persistent_teams")) {
+                            const clang::Stmt *timeLoop = getTimeLoop(node);
+                            if (timeLoop != NULL && hoistedTimeLoops.find(
+                                        timeLoop) != hoistedTimeLoops.end()) {
+                                // Rewritten along with the whole time loop
+                                continue;
+                            }
+
+                            std::vector<PragmaNode *> loops;
+                            if (timeLoop != NULL && canHoistTeam(node,
+                                        timeLoop, &loops, func->getBody())) {
+                                hoistedTimeLoops.insert(timeLoop);
+                                const bool failed = rewriter->ReplaceText(
+                                        timeLoop->getSourceRange(),
+                                        getPersistentTeamStr(timeLoop, &loops));
+                                assert(!failed);
+                                continue;
+                            }
+                        }
+
+                        if (target == HCLIB && ompCmd == "parallel" &&
+                                isFeatureEnabled("fuse_loops")) {
+                            PragmaNode *previous = getAdjacentParallelFor(node,
+                                    false);
+                            if (previous != NULL &&
+                                    canFuseParallelFors(previous, node)) {
+                                // Rewritten along with the loops before it
+                                continue;
+                            }
+
+                            std::vector<PragmaNode *> fused;
+                            fused.push_back(node);
+                            PragmaNode *next = getAdjacentParallelFor(node, true);
+                            while (next != NULL &&
+                                    canFuseParallelFors(fused.back(), next)) {
+                                fused.push_back(next);
+                                next = getAdjacentParallelFor(next, true);
+                            }
+
+                            if (fused.size() > 1) {
+                                const bool failed = rewriter->ReplaceText(
+                                        clang::SourceRange(node->getStartLoc(),
+                                            fused.back()->getEndLoc()),
+                                        getFusedParallelForStr(&fused,
+                                            func->getBody()));
+                                assert(!failed);
+                                continue;
+                            }
+                        }
 
                         const clang::ForStmt *forLoop =
                             clang::dyn_cast<clang::ForStmt>(node->getBody());
@@ -1884,12 +7267,28 @@ void OMPToHClib::postFunctionVisit(clang::FunctionDecl *func) {
                             exit(1);
                         }
 
+                        /*
+                         * A perfect nest of two loops is collapsed, so that
+                         * it can be tiled in both dimensions.
+                         */
+                        if (target == HCLIB && isFeatureEnabled("tile_nests") &&
+                                canCollapseNest(forLoop, clauses)) {
+                            clauses->addClauseArg("collapse", "2");
+                        }
+
+                        const bool nogroupByValue = (target == HCLIB &&
+                                ompCmd == "taskloop" &&
+                                clauses->hasClause("nogroup") &&
+                                privatizeNogroupCaptures(node, clauses));
+
                         std::vector<OMPReductionVar> *reductions =
                             clauses->getReductions();
 
                         std::string bodyStr;
                         std::vector<const clang::ValueDecl *> condVars;
                         const int nLoops = clauses->getNumCollapsedLoops();
+                        // Set if inner loop bounds use outer induction variables
+                        bool dependentBounds = false;
 
                         std::vector<std::string> accumulated_low;
                         std::vector<std::string> accumulated_high;
@@ -1903,6 +7302,33 @@ void OMPToHClib::postFunctionVisit(clang::FunctionDecl *func) {
                         std::string originalBodyStr;
                         const clang::Stmt *body = NULL;
 
+                        /*
+                         * Shared scalars and pointers that the loop never
+                         * writes are unpacked once per closure call rather
+                         * than dereferenced through the context on every use.
+                         */
+                        std::vector<OMPVarInfo> *readOnlyVars =
+                            new std::vector<OMPVarInfo>();
+                        if (target == HCLIB &&
+                                isFeatureEnabled("readonly_captures")) {
+                            readOnlyVars = getReadOnlySharedVars(forLoop,
+                                    clauses->getSharedVarInfo(
+                                        node->getCaptures()));
+                        }
+
+                        /*
+                         * The copy of the loop that runs in place when it has
+                         * too few iterations must precede the shared variable
+                         * rewriting below. Its induction variables are not
+                         * private yet, so it updates them as the sequential
+                         * loop would.
+                         */
+                        std::string seqStr;
+                        const bool seqInlinable = (target == HCLIB &&
+                                ompCmd == "parallel" &&
+                                isFeatureEnabled("seq_fallback") &&
+                                getInlineTaskStr(node, clauses, seqStr));
+
                         for (int l = 0; l < nLoops; l++) {
                             const clang::Stmt *init = currLoop->getInit();
                             const clang::Stmt *cond = currLoop->getCond();
@@ -1913,6 +7339,11 @@ void OMPToHClib::postFunctionVisit(clang::FunctionDecl *func) {
                                 getCondVarAndLowerBoundFromInit(init,
                                         &condVar);
                             assert(condVar);
+                            if (referencesAnyDecl(init, &condVars) ||
+                                    referencesAnyDecl(cond, &condVars) ||
+                                    referencesAnyDecl(inc, &condVars)) {
+                                dependentBounds = true;
+                            }
                             condVars.push_back(condVar);
                             std::string highStr = getUpperBoundFromCond(
                                     cond, condVar);
@@ -1924,15 +7355,43 @@ void OMPToHClib::postFunctionVisit(clang::FunctionDecl *func) {
                             accumulated_stride.push_back(strideStr);
                             accumulated_cond.push_back(condVar);
 
-                            clauses->addClauseArg("private",
-                                    condVar->getNameAsString());
+                            /*
+                             * A lastprivate induction variable keeps its
+                             * clause, so that its exit value is written back.
+                             */
+                            bool isLastprivate = false;
+                            if (clauses->hasClause("lastprivate")) {
+                                std::vector<std::string> *vars =
+                                    clauses->getFlattenedArgsList(
+                                            "lastprivate");
+                                isLastprivate = std::find(vars->begin(),
+                                        vars->end(), condVar->getNameAsString())
+                                    != vars->end();
+                            }
+                            if (target != HCLIB || !isLastprivate) {
+                                clauses->addClauseArg("private",
+                                        condVar->getNameAsString());
+                            }
 
                             originalBodyStr = stmtToString(currLoop->getBody());
                             body = currLoop->getBody();
                             if (target == HCLIB) {
+                                std::vector<OMPVarInfo> *sharedVars =
+                                    clauses->getSharedVarInfo(node->getCaptures());
+                                for (std::vector<OMPVarInfo>::iterator i =
+                                        readOnlyVars->begin(), e =
+                                        readOnlyVars->end(); i != e; i++) {
+                                    for (std::vector<OMPVarInfo>::iterator j =
+                                            sharedVars->begin(); j !=
+                                            sharedVars->end(); j++) {
+                                        if (j->getDecl() == i->getDecl()) {
+                                            sharedVars->erase(j);
+                                            break;
+                                        }
+                                    }
+                                }
                                 bodyStr = stmtToStringWithSharedVars(
-                                        currLoop->getBody(),
-                                        clauses->getSharedVarInfo(node->getCaptures()));
+                                        currLoop->getBody(), sharedVars);
                             }
 
                             loopConfiguration << "domain["  << l << "].low = " <<
@@ -1942,23 +7401,85 @@ void OMPToHClib::postFunctionVisit(clang::FunctionDecl *func) {
                             loopConfiguration << "domain["  << l <<
                                 "].stride = " << strideStr << ";\n";
                             loopConfiguration << "domain["  << l <<
-                                "].tile = -1;\n";
+                                "].tile = " << getTileStr(clauses, l, lowStr,
+                                        highStr, strideStr) << ";\n";
 
-                            currLoop = clang::dyn_cast<clang::ForStmt>(
-                                    currLoop->getBody());
+                            currLoop = getNestedLoop(currLoop->getBody());
                             assert(currLoop || l == nLoops - 1);
                         }
 
                         bool isAcceleratable = (nLoops == 1 &&
                                 accumulated_stride.at(0) == "1");
 
+                        /*
+                         * Range closures step through each tile with a
+                         * less-than test, so they are only used when every
+                         * loop counts upwards.
+                         */
+                        bool useRangeClosures = (target == HCLIB &&
+                                isFeatureEnabled("range_closures"));
+                        for (std::vector<std::string>::iterator i =
+                                accumulated_stride.begin(), e =
+                                accumulated_stride.end(); i != e; i++) {
+                            if ((*i).find("-") == 0) {
+                                useRangeClosures = false;
+                            }
+                        }
+
+                        bool wideIters = false;
+                        for (std::vector<const clang::ValueDecl *>::iterator i =
+                                condVars.begin(), e = condVars.end(); i != e;
+                                i++) {
+                            if (target == HCLIB &&
+                                    isWideInductionVar(*i, Context)) {
+                                wideIters = true;
+                                useRangeClosures = false;
+                            }
+                        }
+
+                        /*
+                         * Collapsed loops with dependent bounds have no
+                         * rectangular domain, so they are linearized.
+                         */
+                        const bool linearized = (target == HCLIB &&
+                                dependentBounds);
+                        if (linearized) {
+                            if (nLoops != 2 || wideIters) {
+                                std::cerr << "Collapsed loops at line " <<
+                                    node->getStartLine() << " have inner " <<
+                                    "bounds that depend on outer induction " <<
+                                    "variables, which is only supported " <<
+                                    "for two loops with int induction " <<
+                                    "variables" << std::endl;
+                                exit(1);
+                            }
+                            useRangeClosures = false;
+                        }
+
+                        bool cacheTiles = (target == HCLIB && nLoops > 1 &&
+                                isFeatureEnabled("cache_tiles") &&
+                                !linearized && !wideIters &&
+                                hasDefaultTiling(clauses));
+                        for (std::vector<std::string>::iterator i =
+                                accumulated_stride.begin(), e =
+                                accumulated_stride.end(); i != e; i++) {
+                            if ((*i).find("-") == 0) {
+                                cacheTiles = false;
+                            }
+                        }
+                        if (cacheTiles) {
+                            loopConfiguration << getCacheTileStr(nLoops, body,
+                                    condVars.back());
+                        }
+
                         CUDAFunctorParameters functor_parameters;
                         accumulatedKernelDecls += getClosureDecl(
-                                node->getLbl() + ASYNC_SUFFIX, true, nLoops,
-                                false, isAcceleratable,
+                                node->getLbl() + ASYNC_SUFFIX, true,
+                                linearized ? 1 : nLoops, false, isAcceleratable,
                                 accumulated_cond.at(0)->getNameAsString(),
                                 originalBodyStr, body, node->getCaptures(),
-                                clauses, &functor_parameters);
+                                clauses, &functor_parameters, useRangeClosures,
+                                linearized);
 
                         std::stringstream constructor_params;
                         for (std::vector<CUDAParameter>::iterator i =
@@ -1977,22 +7498,59 @@ void OMPToHClib::postFunctionVisit(clang::FunctionDecl *func) {
                             }
                         }
 
+                        std::stringstream readOnlyUnpackStr;
+                        for (std::vector<OMPVarInfo>::iterator i =
+                                readOnlyVars->begin(), e = readOnlyVars->end();
+                                i != e; i++) {
+                            readOnlyUnpackStr << "    " << getReadOnlyUnpackStr(
+                                    i->getDecl(), body) << std::endl;
+                        }
+
                         std::stringstream contextCreation;
                         if (target == HCLIB) {
                             contextCreation << "\n" <<
                                 getContextSetup(node, node->getLbl(),
                                         node->getCaptures(), clauses);
-                            contextCreation << loopConfiguration.str();
+                            const bool keepRange = useRangeClosures ||
+                                (clauses->hasClause("lastprivate") &&
+                                 !wideIters && !linearized);
+                            if (linearized) {
+                                contextCreation << getLinearizedSetupStr(
+                                        clauses, &condVars, &accumulated_low,
+                                        &accumulated_high, &accumulated_stride);
+                            } else if (wideIters) {
+                                contextCreation << "hclib_loop_domain_t " <<
+                                    "domain[" << nLoops << "];\n";
+                                contextCreation << getWideChunkSetupStr(
+                                        clauses, &condVars, &accumulated_low,
+                                        &accumulated_high, &accumulated_stride);
+                            } else {
+                                contextCreation << loopConfiguration.str();
+                            }
+                            if (useRangeClosures) {
+                                contextCreation << getRangeSetupStr(nLoops);
+                            } else if (keepRange) {
+                                // Lets the closure spot the last iteration
+                                for (int l = 0; l < nLoops; l++) {
+                                    contextCreation << "new_ctx->____range[" <<
+                                        l << "] = domain[" << l << "];\n";
+                                }
+                            }
 
                             const std::string structDef = getStructDef(
-                                    node->getLbl(), node->getCaptures(), clauses);
+                                    node->getLbl(), node->getCaptures(), clauses,
+                                    keepRange ? nLoops : 0, false, false, false,
+                                    wideIters ? &condVars : NULL, linearized);
                             accumulatedStructDefs += structDef;
 
                             accumulatedKernelDefs += getClosureDef(
                                     node->getLbl() + ASYNC_SUFFIX, true, false,
                                     node->getLbl(), node->getCaptures(),
                                     bodyStr, false, clauses,
-                                    canLaunchTasks(forLoop), false, &condVars);
+                                    canLaunchTasks(forLoop), false, &condVars,
+                                    useRangeClosures, false, "",
+                                    readOnlyUnpackStr.str(), true, wideIters,
+                                    linearized);
                         }
 
                         // For now only support offload of 1D parallel loops
@@ -2008,20 +7566,110 @@ void OMPToHClib::postFunctionVisit(clang::FunctionDecl *func) {
                                 "(" << constructor_params.str() <<
                                 "));" << std::endl;
                         } else if (target == HCLIB) {
-                            contextCreation << "hclib_future_t *fut = " <<
-                                "hclib_forasync_future((void *)" <<
-                                node->getLbl() << ASYNC_SUFFIX << ", new_ctx, " <<
-                                nLoops << ", domain, HCLIB_FORASYNC_MODE);\n";
-                            contextCreation << "hclib_future_wait(fut);\n";
-                            contextCreation << "free(new_ctx);\n";
+                            const bool asyncFree = nogroupByValue &&
+                                !wideIters && !linearized;
+                            if (wideIters) {
+                                /*
+                                 * The chunks share the context, so each one
+                                 * is done before the next is set up. A
+                                 * nogroup taskloop waits for its chunks too.
+                                 */
+                                contextCreation << "hclib_future_wait(" <<
+                                    "hclib_forasync_future((void *)" <<
+                                    node->getLbl() << ASYNC_SUFFIX <<
+                                    ", new_ctx, " << nLoops << ", domain, " <<
+                                    getForasyncModeStr(clauses) << "));\n";
+                                for (int l = 0; l < nLoops; l++) {
+                                    contextCreation << "}\n";
+                                }
+                            } else {
+                                contextCreation << "hclib_future_t *fut = " <<
+                                    "hclib_forasync_future((void *)" <<
+                                    node->getLbl() << ASYNC_SUFFIX << ", new_ctx, " <<
+                                    (linearized ? 1 : nLoops) << ", domain, " <<
+                                    getForasyncModeStr(clauses) << ");\n";
+                                if (asyncFree) {
+                                    if (!reductions->empty()) {
+                                        std::cerr << "Reductions on the nogroup " <<
+                                            "taskloop at line " <<
+                                            node->getStartLine() <<
+                                            " are unsupported" << std::endl;
+                                        exit(1);
+                                    }
+                                    /*
+                                     * The context is freed once the loop is
+                                     * done, by a task registered with the
+                                     * enclosing finish scope.
+                                     */
+                                    contextCreation << "hclib_async(free, " <<
+                                        "new_ctx, fut, ANY_PLACE);\n";
+                                } else {
+                                    contextCreation << "hclib_future_wait(fut);\n";
+                                }
+                            }
 
-                            for (std::vector<OMPReductionVar>::iterator i =
-                                    reductions->begin(), e = reductions->end();
-                                    i != e; i++) {
-                                OMPReductionVar var = *i;
-                                contextCreation << var.getVar() << " = " <<
-                                    "new_ctx->" << var.getVar() << ";\n";
+                            if (!reductions->empty()) {
+                                /*
+                                 * Combine the per-worker partial results into
+                                 * the original variables, reusing the
+                                 * ____worker counter declared by the context
+                                 * setup.
+                                 */
+                                std::vector<OMPVarInfo> *vars =
+                                    clauses->getVarInfo(node->getCaptures());
+                                contextCreation << "for (____worker = 0; " <<
+                                    "____worker < hclib_get_num_workers(); " <<
+                                    "____worker++) {\n";
+                                for (std::vector<OMPReductionVar>::iterator i =
+                                        reductions->begin(), e = reductions->end();
+                                        i != e; i++) {
+                                    OMPReductionVar var = *i;
+                                    contextCreation << "    " <<
+                                        var.getCombineStr(var.getVar(),
+                                                "new_ctx->per_worker_reductions" +
+                                                ("[____worker]." + var.getVar()),
+                                                getReductionDecl(var,
+                                                    vars)->getType()) << "\n";
+                                }
+                                contextCreation << "}\n";
+                                contextCreation <<
+                                    "free(new_ctx->per_worker_reductions);\n";
+                            }
+                            if (linearized) {
+                                contextCreation << "free(new_ctx->____offsets);\n";
+                                contextCreation <<
+                                    "free(new_ctx->____inner_low);\n";
+                                contextCreation <<
+                                    "free(new_ctx->____inner_step);\n";
+                            }
+                            if (!asyncFree) {
+                                contextCreation << "free(new_ctx);\n";
+                            }
+                        }
+
+                        /*
+                         * Loops with too few iterations to be worth a launch
+                         * run in place, like an undeferred task.
+                         */
+                        std::string launchStr = contextCreation.str();
+                        bool seqFallback = (seqInlinable && !linearized);
+                        for (std::vector<std::string>::iterator i =
+                                accumulated_stride.begin(), e =
+                                accumulated_stride.end(); i != e; i++) {
+                            if ((*i).find("-") == 0) {
+                                seqFallback = false;
+                            }
+                        }
+                        if (seqFallback) {
+                            if (canLaunchTasks(forLoop)) {
+                                seqStr = "hclib_start_finish();\n" + seqStr +
+                                    "hclib_end_finish();\n";
                             }
+                            accumulatedStructDefs += getSeqTripsDef(
+                                    node->getLbl(), body);
+                            launchStr = getSeqFallbackStr(node->getLbl(),
+                                    &accumulated_low, &accumulated_high,
+                                    &accumulated_stride, seqStr, launchStr);
                         }
 
                         if ((target == CUDA && isAcceleratable) ||
@@ -2030,7 +7678,7 @@ void OMPToHClib::postFunctionVisit(clang::FunctionDecl *func) {
                             const bool failed = rewriter->ReplaceText(
                                     clang::SourceRange(node->getStartLoc(),
                                         node->getEndLoc()),
-                                    " { " + contextCreation.str() + " } ");
+                                    " { " + launchStr + " } ");
                             assert(!failed);
                         } else {
                             /*
@@ -2039,14 +7687,158 @@ void OMPToHClib::postFunctionVisit(clang::FunctionDecl *func) {
                              */
                             removePragma(node);
                         }
+                    } else if (target == HCLIB) {
+                        /*
+                         * A bare parallel region runs its body once on each
+                         * thread of a team, as one task per thread sharing a
+                         * single context. The region ends once every task
+                         * and anything they spawned has completed.
+                         */
+                        const clang::CompoundStmt *region =
+                            clang::dyn_cast<clang::CompoundStmt>(
+                                    node->getBody());
+                        if (region == NULL) {
+                            std::cerr << "Expected a compound statement " <<
+                                "as the body of the parallel region at " <<
+                                "line " << node->getStartLine() << std::endl;
+                            exit(1);
+                        }
+                        if (!clauses->getReductions()->empty()) {
+                            std::cerr << "Reductions on the parallel region " <<
+                                "at line " << node->getStartLine() <<
+                                " are unsupported" << std::endl;
+                            exit(1);
+                        }
+
+                        // Replaced by the team variables declared below
+                        bool hasTeamVars = false;
+                        for (clang::CompoundStmt::const_body_iterator i =
+                                region->body_begin(), e = region->body_end();
+                                i != e; i++) {
+                            if (const clang::DeclStmt *teamVar =
+                                    getTeamVarDecl(*i)) {
+                                const bool failed = rewriter->RemoveText(
+                                        teamVar->getSourceRange());
+                                assert(!failed);
+                                hasTeamVars = true;
+                            }
+                        }
+
+                        replaceTeamQueries(region);
+                        std::string bodyStr = stmtToStringWithSharedVars(
+                                region, clauses->getSharedVarInfo(
+                                    node->getCaptures()));
+                        bodyStr = std::string("{ ____omp_team_t *") +
+                            TEAM_VAR + " = &(ctx->____team); const int " +
+                            THREAD_NUM_VAR + " = ____omp_team_join(" +
+                            TEAM_VAR + "); " + bodyStr + " ; }";
+
+                        bool isAcceleratable = false;
+                        accumulatedKernelDecls += getClosureDecl(
+                                node->getLbl() + ASYNC_SUFFIX, false, -1,
+                                false, isAcceleratable);
+
+                        // The context is freed once the whole team is done
+                        accumulatedKernelDefs += getClosureDef(
+                                node->getLbl() + ASYNC_SUFFIX, false, true,
+                                node->getLbl(), node->getCaptures(), bodyStr,
+                                false, clauses, canLaunchTasks(region), false,
+                                NULL, false, false, "", "", false);
+
+                        // Otherwise emitted along with the team variables
+                        std::string def = getTeamRuntimeDef();
+                        if (!hasTeamVars && accumulatedStructDefs.find(def) ==
+                                std::string::npos) {
+                            accumulatedStructDefs += def;
+                        }
+                        accumulatedStructDefs += getStructDef(node->getLbl(),
+                                node->getCaptures(), clauses, 0, false, true);
+
+                        std::string nthreads = "hclib_get_num_workers()";
+                        if (clauses->hasClause("num_threads")) {
+                            nthreads = "(" +
+                                clauses->getSingleArg("num_threads") + ")";
+                        }
+
+                        std::stringstream contextCreation;
+                        contextCreation << "\n" << getContextSetup(node,
+                                node->getLbl(), node->getCaptures(), clauses);
+                        contextCreation << "____omp_team_init(&new_ctx->" <<
+                            "____team, " << nthreads << ");\n";
+                        contextCreation << "hclib_start_finish();\n";
+                        contextCreation << "int ____thread;\n";
+                        contextCreation << "for (____thread = 0; ____thread " <<
+                            "< new_ctx->____team.nthreads; ____thread++) {\n";
+                        contextCreation << "    hclib_async(" <<
+                            node->getLbl() << ASYNC_SUFFIX << ", new_ctx, " <<
+                            "NO_FUTURE, ANY_PLACE);\n";
+                        contextCreation << "}\n";
+                        contextCreation << "hclib_end_finish();\n";
+                        contextCreation << "free(new_ctx);\n";
+
+                        // Add braces to ensure we don't change control flow
+                        const bool failed = rewriter->ReplaceText(
+                                clang::SourceRange(node->getStartLoc(),
+                                    node->getEndLoc()),
+                                " { " + contextCreation.str() + " } ");
+                        assert(!failed);
                     } else {
-                        std::cerr << "Parallel pragma without a for at line " <<
-                            node->getStartLine() << std::endl;
+                        removePragma(node);
+                    }
+                } else if (ompCmd == "for") {
+                    PragmaNode *team = getEnclosingTeam(node);
+                    if (team == NULL) {
+                        std::cerr << "The omp for at line " <<
+                            node->getStartLine() << " is not directly " <<
+                            "nested in a parallel region of the same " <<
+                            "function, which is unsupported" << std::endl;
                         exit(1);
                     }
-                } else if (ompCmd == "simd") {
-                    // Do nothing for now, just delete this pragma
+
+                    if (target == HCLIB) {
+                        declareTeamVars(team, accumulatedStructDefs);
+                        const bool failed = rewriter->ReplaceText(
+                                clang::SourceRange(node->getStartLoc(),
+                                    node->getEndLoc()),
+                                getTeamForStr(node, clauses));
+                        assert(!failed);
+                    } else {
+                        removePragma(node);
+                    }
+                } else if (ompCmd == "barrier") {
+                    PragmaNode *team = getEnclosingTeam(node);
+                    if (target == HCLIB && team != NULL) {
+                        declareTeamVars(team, accumulatedStructDefs);
+                        const bool failed = rewriter->ReplaceText(
+                                clang::SourceRange(node->getStartLoc(),
+                                    node->getEndLoc()),
+                                std::string(" ____omp_team_barrier(") +
+                                TEAM_VAR + "); ");
+                        assert(!failed);
+                    } else {
+                        // Outside of a team only the encountering thread waits
+                        removePragma(node);
+                    }
+                } else if (ompCmd == "taskloop") {
+                    // Executed sequentially by the encountering thread
                     removePragma(node);
+                } else if (ompCmd == "simd") {
+                    if (target == HCLIB) {
+                        // Validates the clauses, which are passed through as-is
+                        OMPClauses *clauses = getOMPClausesForMarker(
+                                node->getMarker());
+                        std::string before, after;
+                        getSimdShadowStrs(node, clauses, before, after);
+                        const bool failed = rewriter->ReplaceText(
+                                clang::SourceRange(node->getStartLoc(),
+                                    node->getEndLoc()),
+                                before + getSimdDirectiveStr(
+                                    node->getPragmaArguments(), clauses) +
+                                stmtToString(node->getBody()) + after);
+                        assert(!failed);
+                    } else {
+                        removePragma(node);
+                    }
                 } else {
                     std::cerr << "Unhandled OMP command \"" << ompCmd << "\"" <<
                         std::endl;
@@ -2061,6 +7853,29 @@ void OMPToHClib::postFunctionVisit(clang::FunctionDecl *func) {
             }
         }
 
+        /*
+         * The tile graph is declared by the first pass that registers tasks
+         * with it. Tasks may be converted over several passes, e.g. when some
+         * wait for taskwaits to be lowered first, and later passes find the
+         * graph already declared.
+         */
+        const clang::CompoundStmt *funcBody =
+            clang::dyn_cast<clang::CompoundStmt>(func->getBody());
+        const bool declareTileGraph = convertedTileDeps &&
+            !declaresTileGraph(funcBody);
+        if (declareTileGraph) {
+            std::stringstream prologue;
+            prologue << " ____omp_tile_graph_t " << TILE_GRAPH_VAR << "; " <<
+                "____omp_tile_graph_init(&" << TILE_GRAPH_VAR << ", " <<
+                tileGrids.size() << "); hclib_start_finish(); ";
+            // Ahead of anything else inserted after the opening brace
+            const bool failed = rewriter->InsertText(
+                    funcBody->getLBracLoc().getLocWithOffset(1),
+                    prologue.str(), false);
+            assert(!failed);
+            accumulatedStructDefs = getTileGraphDef() + accumulatedStructDefs;
+        }
+
         if (accumulatedStructDefs.length() > 0 ||
                 accumulatedKernelDefs.length() > 0 ||
                 accumulatedKernelDecls.length() > 0) {
@@ -2077,8 +7892,14 @@ void OMPToHClib::postFunctionVisit(clang::FunctionDecl *func) {
             bool failed = rewriter->InsertText(insertLocation,
                     accumulatedStructDefs + accumulatedKernelDecls, true, true);
             assert(!failed);
+            std::string epilogue = "";
+            if (declareTileGraph) {
+                // Wait for the tasks before their dependencies are freed
+                epilogue = std::string(" hclib_end_finish(); ") +
+                    "____omp_tile_graph_free(&" + TILE_GRAPH_VAR + "); ";
+            }
             failed = rewriter->ReplaceText(func->getLocEnd(), 1,
-                    "} " + accumulatedKernelDefs);
+                    epilogue + "} " + accumulatedKernelDefs);
             assert(!failed);
         }
     }
@@ -2198,12 +8019,13 @@ const clang::Stmt *OMPToHClib::getBodyForMarker(const clang::CallExpr *call) {
             ompPragma = pragmaArgs.substr(0, ompPragmaNameEnd);
         }
 
-        if (ompPragma == "taskwait") {
+        if (ompPragma == "taskwait" || ompPragma == "barrier") {
             return NULL;
         } else if (ompPragma == "task" || ompPragma == "critical" ||
                 ompPragma == "atomic" || ompPragma == "parallel" ||
                 ompPragma == "single" || ompPragma == "simd" ||
-                ompPragma == "master") {
+                ompPragma == "master" || ompPragma == "for" ||
+                ompPragma == "taskloop") {
             return getBodyFrom(call, ompPragma);
         } else {
             std::cerr << "Unhandled OMP pragma \"" << ompPragma << "\"" << std::endl;
@@ -2231,8 +8053,12 @@ OMPClauses *OMPToHClib::getOMPClausesForMarker(const clang::CallExpr *call) {
     if (ompPragmaNameEnd != std::string::npos) {
         // Some clauses, non-empty args
         std::string clauses = pragmaArgs.substr(ompPragmaNameEnd + 1);
-        parsed = new OMPClauses(clauses);
         ompPragma = pragmaArgs.substr(0, ompPragmaNameEnd);
+        if (ompPragma == "critical" && clauses[0] == '(') {
+            // Parse the name of a critical section as if it were a clause
+            clauses = "name" + clauses;
+        }
+        parsed = new OMPClauses(clauses);
     } else {
         parsed = new OMPClauses();
         ompPragma = pragmaArgs;
@@ -2256,6 +8082,7 @@ OMPClauses *OMPToHClib::getOMPClausesForMarker(const clang::CallExpr *call) {
             } else if (clauseName == "for" || clauseName == "private" ||
                     clauseName == "shared" || clauseName == "schedule" ||
                     clauseName == "reduction" || clauseName == "firstprivate" ||
+                    clauseName == "lastprivate" ||
                     clauseName == "num_threads" || clauseName == "default") {
                 // Do nothing
                 handledClause = true;
@@ -2263,13 +8090,56 @@ OMPClauses *OMPToHClib::getOMPClausesForMarker(const clang::CallExpr *call) {
         } else if (ompPragma == "task") {
             if (clauseName == "firstprivate" || clauseName == "private" ||
                     clauseName == "shared" || clauseName == "untied" ||
-                    clauseName == "default" || clauseName == "if") {
+                    clauseName == "default" || clauseName == "if" ||
+                    clauseName == "final" || clauseName == "mergeable") {
                 // Do nothing
                 handledClause = true;
             } else if (clauseName == "depend") {
                 // Handled during code generation.
                 handledClause = true;
             }
+        } else if (ompPragma == "critical") {
+            if (clauseName == "name" || clauseName == "hint") {
+                // Handled during code generation.
+                handledClause = true;
+            }
+        } else if (ompPragma == "atomic") {
+            if (clauseName == "read" || clauseName == "write" ||
+                    clauseName == "update" || clauseName == "capture" ||
+                    clauseName == "compare" || clauseName == "seq_cst" ||
+                    clauseName == "acq_rel" || clauseName == "acquire" ||
+                    clauseName == "release" || clauseName == "relaxed" ||
+                    clauseName == "hint") {
+                // Handled during code generation.
+                handledClause = true;
+            }
+        } else if (ompPragma == "simd") {
+            if (clauseName == "safelen" || clauseName == "simdlen" ||
+                    clauseName == "aligned" || clauseName == "linear" ||
+                    clauseName == "reduction" || clauseName == "private" ||
+                    clauseName == "lastprivate" || clauseName == "collapse" ||
+                    clauseName == "nontemporal" || clauseName == "order") {
+                // Passed through to the generated directive
+                handledClause = true;
+            }
+        } else if (ompPragma == "for") {
+            if (clauseName == "private" || clauseName == "firstprivate" ||
+                    clauseName == "lastprivate" ||
+                    clauseName == "reduction" || clauseName == "schedule" ||
+                    clauseName == "nowait" || clauseName == "collapse") {
+                // Handled during code generation.
+                handledClause = true;
+            }
+        } else if (ompPragma == "taskloop") {
+            if (clauseName == "private" || clauseName == "firstprivate" ||
+                    clauseName == "shared" || clauseName == "default" ||
+                    clauseName == "lastprivate" ||
+                    clauseName == "reduction" || clauseName == "collapse" ||
+                    clauseName == "grainsize" || clauseName == "num_tasks" ||
+                    clauseName == "nogroup" || clauseName == "untied") {
+                // Handled during code generation.
+                handledClause = true;
+            }
         } else if (ompPragma == "single") {
             if (clauseName == "private" || clauseName == "nowait") {
                 // Do nothing
@@ -2411,8 +8281,7 @@ void OMPToHClib::VisitStmt(const clang::Stmt *s) {
     assert(currentScope == getCurrentLexicalDepth());
 }
 
-OMPToHClib::OMPToHClib(const char *checkForPthreadStr,
-        const char *startCriticalSectionId) {
+OMPToHClib::OMPToHClib(const char *checkForPthreadStr) {
 
     if (strcmp(checkForPthreadStr, "true") == 0) {
         checkForPthread = true;
@@ -2424,8 +8293,6 @@ OMPToHClib::OMPToHClib(const char *checkForPthreadStr,
         exit(1);
     }
 
-    criticalSectionId = atoi(startCriticalSectionId);
-
     compatiblePthreadAPIs.push_back("pthread_mutex_init");
     compatiblePthreadAPIs.push_back("pthread_mutex_lock");
     compatiblePthreadAPIs.push_back("pthread_mutex_unlock");
@@ -27,8 +27,7 @@ enum TargetLang { HCLIB, CUDA };
 
 class OMPToHClib : public clang::ConstStmtVisitor<OMPToHClib> {
     public:
-        OMPToHClib(const char *checkForPthread,
-                const char *startCriticalSectionId);
+        OMPToHClib(const char *checkForPthread);
         ~OMPToHClib();
 
         void setRewriter(clang::Rewriter &R) {
@@ -45,9 +44,17 @@ class OMPToHClib : public clang::ConstStmtVisitor<OMPToHClib> {
         std::string stmtToStringWithSharedVars(const clang::Stmt *stmt,
                 std::vector<OMPVarInfo> *shared);
         void removePragma(PragmaNode *node);
+        std::string getSimdDirectiveStr(std::string pragmaArgs,
+                OMPClauses *clauses);
+        void getSimdShadowStrs(PragmaNode *node, OMPClauses *clauses,
+                std::string &before, std::string &after);
         void replaceAllReferencesTo(const clang::Stmt *stmt,
                 std::vector<OMPVarInfo> *shared);
         std::string stringForAST(const clang::Stmt *stmt);
+        std::vector<OMPVarInfo> *getReadOnlySharedVars(const clang::Stmt *body,
+                std::vector<OMPVarInfo> *shared);
+        std::string getReadOnlyUnpackStr(clang::ValueDecl *decl,
+                const clang::Stmt *body);
         void setParent(const clang::Stmt *child,
                 const clang::Stmt *parent);
         const clang::Stmt *getParent(const clang::Stmt *s);
@@ -62,7 +69,8 @@ class OMPToHClib : public clang::ConstStmtVisitor<OMPToHClib> {
                 const clang::Stmt *body = NULL,
                 std::vector<clang::ValueDecl *> *captured = NULL,
                 OMPClauses *clauses = NULL,
-                CUDAFunctorParameters *functor_params = NULL);
+                CUDAFunctorParameters *functor_params = NULL,
+                bool rangeClosure = false, bool linearized = false);
         void traverseFunctorBody(const clang::Stmt *curr,
                 ParallelRegionInfo &info, bool beneathFunctionCall);
         std::string getCUDAFunctorDef(std::string closureName,
@@ -81,11 +89,22 @@ class OMPToHClib : public clang::ConstStmtVisitor<OMPToHClib> {
                 std::vector<clang::ValueDecl *> *captured, std::string bodyStr,
                 bool isFuture, OMPClauses *clauses,
                 bool wrapBodyInFinish, bool waitAtEnd,
-                std::vector<const clang::ValueDecl *> *condVars = NULL);
+                std::vector<const clang::ValueDecl *> *condVars = NULL,
+                bool rangeClosure = false, bool pooledContext = false,
+                std::string pendingCounter = "",
+                std::string readOnlyUnpackStr = "",
+                bool freeContext = true, bool wideIters = false,
+                bool linearized = false);
         std::string getStructDef(std::string structName,
-                std::vector<clang::ValueDecl *> *captured, OMPClauses *clauses);
+                std::vector<clang::ValueDecl *> *captured, OMPClauses *clauses,
+                int nRangeDims = 0, bool taskDepth = false,
+                bool team = false, bool tileDeps = false,
+                std::vector<const clang::ValueDecl *> *wideCondVars = NULL,
+                bool linearized = false);
         std::string getContextSetup(PragmaNode *node, std::string structName,
-                std::vector<clang::ValueDecl *> *captured, OMPClauses *clauses);
+                std::vector<clang::ValueDecl *> *captured, OMPClauses *clauses,
+                bool pooledContext = false);
+        std::string getContextPoolDef(std::string structName);
 
         enum CAPTURE_TYPE getParentCaptureType(PragmaNode *curr,
                 std::string varname);
@@ -98,7 +117,11 @@ class OMPToHClib : public clang::ConstStmtVisitor<OMPToHClib> {
         OMPClauses *getOMPClausesForMarker(const clang::CallExpr *call);
         std::string getOMPPragmaNameForMarker(const clang::CallExpr *call);
 
-        int getCriticalSectionId() { return criticalSectionId; }
+        void scanFunctionBody(const clang::Stmt *stmt);
+        void addDefinedFunction(std::string fname) {
+            definedFunctions.insert(fname);
+        }
+
         bool hasShmemCalls() { return anyShmemCalls; }
 
     protected:
@@ -118,7 +141,25 @@ class OMPToHClib : public clang::ConstStmtVisitor<OMPToHClib> {
         std::string getArraySizeExpr(clang::QualType qualType);
         bool checkForPointersInRecord(const clang::RecordType *record);
 
+        /*
+         * Properties of a statement that are computed over the call graph of
+         * the translation unit.
+         */
+        enum CallAnalysis {
+            // May create tasks that outlive the statement
+            LAUNCHES_TASKS,
+            // May wait on the enclosing finish scope, e.g. in a taskwait
+            WAITS_ON_FINISH
+        };
+
         bool canLaunchTasks(const clang::Stmt *body);
+        bool stmtSatisfies(const clang::Stmt *body, CallAnalysis analysis,
+                bool skipTaskBodies);
+        bool functionSatisfies(const clang::FunctionDecl *fdecl,
+                CallAnalysis analysis);
+        void collectCalls(const clang::Stmt *stmt, CallAnalysis analysis,
+                bool &found, std::vector<const clang::FunctionDecl *> *callees,
+                bool skipTaskBodies = false);
 
         bool isScopeCreatingStmt(const clang::Stmt *s);
         int getCurrentLexicalDepth();
@@ -133,11 +174,130 @@ class OMPToHClib : public clang::ConstStmtVisitor<OMPToHClib> {
                 const clang::ValueDecl *condVar);
         std::string getStrideFromIncr(const clang::Stmt *inc,
                 const clang::ValueDecl *condVar);
+        std::string getTileStr(OMPClauses *clauses, int dim,
+                std::string lowStr, std::string highStr,
+                std::string strideStr);
+        std::string getForasyncModeStr(OMPClauses *clauses);
+        bool privatizeNogroupCaptures(PragmaNode *node, OMPClauses *clauses);
+        std::string getRangeSetupStr(int nLoops);
+        std::string getWideChunkSetupStr(OMPClauses *clauses,
+                std::vector<const clang::ValueDecl *> *condVars,
+                std::vector<std::string> *lows,
+                std::vector<std::string> *highs,
+                std::vector<std::string> *strides);
+        std::string getLinearizedSetupStr(OMPClauses *clauses,
+                std::vector<const clang::ValueDecl *> *condVars,
+                std::vector<std::string> *lows,
+                std::vector<std::string> *highs,
+                std::vector<std::string> *strides);
 
         clang::Expr *unwrapCasts(clang::Expr *expr);
 
-        std::string getCriticalSectionLockStr(int criticalSectionId);
-        std::string getCriticalSectionUnlockStr(int criticalSectionId);
+        bool getTaskRegion(PragmaNode *node, clang::FunctionDecl *func,
+                PragmaNode **owner, const clang::CompoundStmt **region);
+        bool regionAwaitsAllTasks(PragmaNode *regionNode);
+        std::string getPendingChildrenCounter(PragmaNode *owner);
+        std::string getTaskwaitStr(std::string waitStr, bool taskCutoff,
+                std::string &structDefs);
+        bool getInlineTaskStr(PragmaNode *node, OMPClauses *clauses,
+                std::string &inlineStr, bool redirectCalls = false);
+        std::string getWorkerLocalDef(std::string varname);
+        bool isSequentialClone(clang::FunctionDecl *func);
+        bool canCloneSequentially(clang::FunctionDecl *func, PragmaNode *node,
+                int &nTasks);
+        void createSequentialClone(clang::FunctionDecl *func);
+        void redirectCallsToClones(const clang::Stmt *stmt);
+        void collectCallsToClones(const clang::Stmt *stmt,
+                std::vector<const clang::DeclRefExpr *> *refs);
+        std::string getRedirectedBodyStr(PragmaNode *node);
+        std::string getTaskDepthDef();
+        std::string getCutoffDef(std::string lbl);
+        std::string getTileGraphDef();
+        bool getTileDependence(PragmaNode *node, std::string item,
+                std::string &grid, std::string &row, std::string &col);
+        bool canResolveDependsStatically(clang::FunctionDecl *func,
+                bool taskCutoff);
+        std::string getTileDepsSetup(PragmaNode *node, OMPClauses *clauses);
+        std::string getTeamRuntimeDef();
+        PragmaNode *getEnclosingTeam(PragmaNode *node);
+        void declareTeamVars(PragmaNode *team, std::string &structDefs);
+        const clang::DeclStmt *getTeamVarDecl(const clang::Stmt *stmt);
+        void replaceTeamQueries(const clang::Stmt *stmt);
+        std::string getTeamForStr(PragmaNode *node, OMPClauses *clauses);
+        bool isFusibleParallelFor(PragmaNode *node);
+        PragmaNode *getAdjacentParallelFor(PragmaNode *node, bool next);
+        bool canFuseParallelFors(PragmaNode *first, PragmaNode *second);
+        bool loopsAreIndependent(PragmaNode *first, PragmaNode *second,
+                std::set<const clang::ValueDecl *> *escaped);
+        std::string getTeamForArgs(PragmaNode *loop,
+                std::vector<std::string> *shared, std::string &numThreads);
+        const clang::Stmt *getTimeLoop(PragmaNode *node);
+        bool canHoistTeam(PragmaNode *node, const clang::Stmt *timeLoop,
+                std::vector<PragmaNode *> *loops, const clang::Stmt *funcBody);
+        std::string getPersistentTeamStr(const clang::Stmt *timeLoop,
+                std::vector<PragmaNode *> *loops);
+        bool canBlockTemporally(PragmaNode *node, const clang::Stmt *timeLoop,
+                const clang::Stmt *funcBody, const clang::ValueDecl **in,
+                const clang::ValueDecl **out, const clang::ValueDecl **cols,
+                int &radius);
+        std::string getTemporalBlockingStr(PragmaNode *node,
+                const clang::Stmt *timeLoop, const clang::ValueDecl *in,
+                const clang::ValueDecl *out, const clang::ValueDecl *cols,
+                int radius);
+        bool isDiagonalSweep(PragmaNode *node, const clang::Stmt *timeLoop);
+        std::string getWavefrontStr(PragmaNode *node,
+                const clang::Stmt *timeLoop);
+        bool canCollapseNest(const clang::ForStmt *loop, OMPClauses *clauses);
+        std::string getCacheTileStr(int nLoops, const clang::Stmt *body,
+                const clang::ValueDecl *innerVar);
+        std::string getSeqTripsDef(std::string lbl, const clang::Stmt *body);
+        std::string getSeqFallbackStr(std::string lbl,
+                std::vector<std::string> *lows,
+                std::vector<std::string> *highs,
+                std::vector<std::string> *strides, std::string seqStr,
+                std::string launchStr);
+        std::string getFusedParallelForStr(std::vector<PragmaNode *> *loops,
+                const clang::Stmt *funcBody);
+
+        /*
+         * The read-modify-write performed by an omp atomic update. newValue
+         * and guard are written in terms of ____atomic_old, the value of x
+         * before the update, and ____atomic_val, operand evaluated once.
+         */
+        struct AtomicUpdate {
+            const clang::Expr *x;
+            const clang::Expr *operand;
+            // Suffix of the __atomic_fetch_* builtin that performs the update
+            std::string fetchOp;
+            std::string newValue;
+            // If non-empty, x is only updated while this condition holds
+            std::string guard;
+            // x++ and x-- evaluate to the old value of x
+            bool isPostfix;
+            // x = operand, no dependence on the old value
+            bool isExchange;
+        };
+
+        bool sameAtomicLocation(const clang::Expr *a, const clang::Expr *b);
+        bool mentionsAtomicLocation(const clang::Stmt *stmt,
+                const clang::Expr *x);
+        std::string getAtomicOperandStr(const clang::Expr *expr,
+                const clang::Expr *x);
+        std::string getAtomicConditionStr(const clang::Expr *cond,
+                const clang::Expr *x);
+        bool parseAtomicUpdate(const clang::Stmt *stmt, AtomicUpdate &update,
+                bool allowExchange = false);
+        bool parseAtomicCapture(const clang::Stmt *stmt, AtomicUpdate &update,
+                const clang::Expr **v, bool &captureOld);
+        std::string getAtomicMemoryOrder(OMPClauses *clauses, bool isLoad,
+                bool isStore);
+        std::string getAtomicUpdateStr(AtomicUpdate &update, std::string order,
+                const clang::Expr *v, bool captureOld);
+        std::string getAtomicStr(const clang::Stmt *body, OMPClauses *clauses);
+
+        std::string getCriticalSectionLockName(OMPClauses *clauses);
+        std::string getCriticalSectionLockStr(OMPClauses *clauses);
+        std::string getCriticalSectionUnlockStr(OMPClauses *clauses);
 
         /*
          * Map from line containing a OMP pragma to its immediate predessor. It
@@ -152,15 +312,34 @@ class OMPToHClib : public clang::ConstStmtVisitor<OMPToHClib> {
 
         PragmaNode *pragmaTree;
 
-        int criticalSectionId;
 
         bool anyShmemCalls = false;
 
         bool foundOmpToHclibLaunch = false;
 
+        // Set if any omp taskwait in this translation unit is not lowered yet
+        bool pendingTaskwaits = false;
+        // Set if any task in this translation unit has a final clause
+        bool anyFinalTasks = false;
+
+        // The tiled matrices that tasks in the current function depend on
+        std::vector<std::string> tileGrids;
+        // Names of the functions defined in the main file
+        std::set<std::string> definedFunctions;
+
         std::vector<std::string> compatiblePthreadAPIs;
 
         std::set<const clang::DeclRefExpr *> sharedVarsReplaced;
+
+        // Parallel regions whose team variables were declared in this pass
+        std::set<const clang::CompoundStmt *> regionsWithTeamVars;
+
+        /*
+         * Cache of the result of each CallAnalysis for calls to functions
+         * defined in this translation unit.
+         */
+        std::map<CallAnalysis, std::map<const clang::FunctionDecl *, bool> >
+            analysisCache;
 };
 
 #endif
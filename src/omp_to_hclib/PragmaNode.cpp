@@ -86,6 +86,10 @@ PragmaNode *PragmaNode::getParentAccountForFusing() {
             (getPragmaCmd() == "single" || getPragmaCmd() == "master") &&
             getParent()->getPragmaCmd() == "parallel") {
         return getParent()->getParent();
+    } else if (getParent()->getPragmaName() == "omp" &&
+            getParent()->getPragmaCmd() == "for") {
+        // Worksharing loops are lowered in place, inside their team's closure
+        return getParent()->getParent();
     } else {
         return getParent();
     }
@@ -30,8 +30,35 @@ SingleClauseArgs::SingleClauseArgs(std::string setClause, std::string argsStr) {
 
     int index = skipWhiteSpace(argsStr, 0);
 
-    if (clause == "if") { // Single argument always
+    if (clause == "if" || clause == "grainsize" || clause == "num_tasks") {
+        // Single argument always
         args.push_back(argsStr);
+    } else if (clause == "schedule") {
+        /*
+         * schedule([modifier:]kind[, chunk]), where chunk is an arbitrary
+         * expression. Stored as the kind followed by the optional chunk, with
+         * any modifiers dropped.
+         */
+        std::string kind = argsStr;
+        std::string chunk = "";
+        size_t comma = argsStr.find(',');
+        if (comma != std::string::npos) {
+            kind = argsStr.substr(0, comma);
+            chunk = argsStr.substr(skipWhiteSpace(argsStr, comma + 1));
+        }
+        size_t colon = kind.rfind(':');
+        if (colon != std::string::npos) {
+            kind = kind.substr(colon + 1);
+        }
+        kind = kind.substr(skipWhiteSpace(kind, 0));
+        while (kind.size() > 0 && kind[kind.size() - 1] == ' ') {
+            kind = kind.substr(0, kind.size() - 1);
+        }
+
+        args.push_back(kind);
+        if (chunk.size() > 0) {
+            args.push_back(chunk);
+        }
     } else {
         while (index < argsStr.size()) {
             int start = index;
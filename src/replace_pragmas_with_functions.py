@@ -29,6 +29,14 @@ while len(line) > 0:
 
             tokens = acc.split()
 
+            # Separate a construct from its arguments, e.g. critical(name)
+            if len(tokens) > 2 and tokens[1] == 'omp' and '(' in tokens[2]:
+                paren = tokens[2].index('(')
+                if paren > 0:
+                    tokens = (tokens[0:2] +
+                              [tokens[2][0:paren], tokens[2][paren:]] +
+                              tokens[3:])
+
             pragma_lbl = 'pragma' + str(line_no) + '_' + tokens[1]
             if len(tokens) > 2:
                 pragma_lbl += '_' + tokens[2]
@@ -253,7 +253,11 @@ std::vector<OMPReductionVar> *OMPClauses::getReductions() {
             std::vector<std::string> *rawArgs = single_arg->getArgs();
 
             std::string op = rawArgs->at(0);
-            assert(op == "+");
+            if (!OMPReductionVar::isSupportedOp(op)) {
+                std::cerr << "Unsupported reduction op \"" << op << "\"" <<
+                    std::endl;
+                exit(1);
+            }
             for (int v = 1; v < rawArgs->size(); v++) {
                 reductions->push_back(OMPReductionVar(op, rawArgs->at(v)));
             }
@@ -10,6 +10,11 @@ std::string OMPReductionVar::getOp() { return op; }
 
 std::string OMPReductionVar::getVar() { return var; }
 
+bool OMPReductionVar::isSupportedOp(std::string op) {
+    return op == "+" || op == "-" || op == "*" || op == "&" || op == "|" ||
+        op == "^" || op == "&&" || op == "||" || op == "min" || op == "max";
+}
+
 std::string OMPReductionVar::getInitialValue() {
     if (op == "+") {
         return std::string("0");
@@ -16,6 +16,8 @@ class OMPReductionVar {
         std::string getVar();
 
         std::string getInitialValue();
+
+        static bool isSupportedOp(std::string op);
 };
 
 #endif
@@ -261,7 +261,7 @@ if (area < MIN_AREA) {
 
 /* if area is less than best area */
           } else if (area < MIN_AREA) {
-__sync_fetch_and_add(&(nnc), add_cell(cells[id].next, footprint, board,cells, 0)); ;
+__atomic_fetch_add(&(nnc), add_cell(cells[id].next, footprint, board,cells, 0), __ATOMIC_RELAXED); ;
 /* if area is greater than or equal to best area, prune search */
           } else {
 
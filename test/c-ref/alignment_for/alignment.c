@@ -520,8 +520,8 @@ hclib_loop_domain_t domain[1];
 domain[0].low = 0;
 domain[0].high = nseqs;
 domain[0].stride = 1;
-domain[0].tile = -1;
-hclib_future_t *fut = hclib_forasync_future((void *)pragma448_omp_parallel_hclib_async, new_ctx, 1, domain, HCLIB_FORASYNC_MODE);
+domain[0].tile = 1;
+hclib_future_t *fut = hclib_forasync_future((void *)pragma448_omp_parallel_hclib_async, new_ctx, 1, domain, FORASYNC_MODE_RECURSIVE);
 hclib_future_wait(fut);
 free(new_ctx);
  }  // end parallel for (i)
@@ -616,7 +616,6 @@ static void pragma463_omp_task_hclib_async(void *____arg) {
     int len2; len2 = ctx->len2;
     double gg; gg = ctx->gg;
     double mm_score; mm_score = ctx->mm_score;
-    hclib_start_finish();
 {
               int se1, se2, sb1, sb2, maxscore, seq1, seq2, g, gh;
               int displ[2*MAX_ALN_LENGTH+1];
@@ -652,9 +651,7 @@ static void pragma463_omp_task_hclib_async(void *____arg) {
               else                        mm_score /= (double) MIN(len1,len2);
 
               bench_output[si*nseqs+sj] = (int) mm_score;
-           } ;     ; hclib_end_finish_nonblocking();
-
-    free(____arg);
+           } ;     free(____arg);
 }
 
 
@@ -562,7 +562,6 @@ static void pragma465_omp_task_hclib_async(void *____arg) {
     int len2; len2 = ctx->len2;
     double gg; gg = ctx->gg;
     double mm_score; mm_score = ctx->mm_score;
-    hclib_start_finish();
 {
                   int se1, se2, sb1, sb2, maxscore, seq1, seq2, g, gh;
                   int displ[2*MAX_ALN_LENGTH+1];
@@ -597,9 +596,7 @@ static void pragma465_omp_task_hclib_async(void *____arg) {
                   else                        mm_score /= (double) MIN(len1,len2);
 
                   bench_output[si*nseqs+sj] = (int) mm_score;
-               } ;     ; hclib_end_finish_nonblocking();
-
-    free(____arg);
+               } ;     free(____arg);
 }
 
 
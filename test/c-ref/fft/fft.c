@@ -443,11 +443,8 @@ hclib_async(pragma213_omp_task_hclib_async, new_ctx, NO_FUTURE, ANY_PLACE);
 } 
 static void pragma205_omp_task_hclib_async(void *____arg) {
     pragma205_omp_task *ctx = (pragma205_omp_task *)____arg;
-    hclib_start_finish();
 fft_twiddle_gen1((*(ctx->in_ptr)) + (*(ctx->i_ptr)), (*(ctx->out_ptr)) + (*(ctx->i_ptr)), (*(ctx->W_ptr)),
-				 (*(ctx->r_ptr)), (*(ctx->m_ptr)), (*(ctx->nW_ptr)), (*(ctx->nWdn_ptr)) * (*(ctx->i_ptr)), (*(ctx->nWdn_ptr)) * (*(ctx->m_ptr))) ;     ; hclib_end_finish_nonblocking();
-
-    free(____arg);
+				 (*(ctx->r_ptr)), (*(ctx->m_ptr)), (*(ctx->nW_ptr)), (*(ctx->nWdn_ptr)) * (*(ctx->i_ptr)), (*(ctx->nWdn_ptr)) * (*(ctx->m_ptr))) ;     free(____arg);
 }
 
 
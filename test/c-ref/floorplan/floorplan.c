@@ -6,7 +6,25 @@
 #include "hclib_cuda.h"
 #endif
 #endif
-pthread_mutex_t critical_0_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+__attribute__((weak)) __thread int ____critical_held = 0;
+static inline void ____critical_acquire(int *lock) {
+    int spins = 0;
+    while (__atomic_load_n(lock, __ATOMIC_RELAXED) != 0 ||
+            __atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE) != 0) {
+        if (++spins == 64) {
+            if (____critical_held == 0) {
+                hclib_yield(NULL);
+            }
+            spins = 0;
+        }
+    }
+    ____critical_held++;
+}
+static inline void ____critical_release(int *lock) {
+    ____critical_held--;
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+__attribute__((weak)) int ____critical_lock = 0;
 /**********************************************************************************************/
 /*  This program is part of the Barcelona OpenMP Tasks Suite                                  */
 /*  Copyright (C) 2009 Barcelona Supercomputing Center - Centro Nacional de Supercomputacion  */
@@ -303,18 +321,18 @@ static void pragma220_omp_task_hclib_async(void *____arg) {
 
 /* if area is minimum, update global values */
 		  if (area < MIN_AREA) {
- { const int ____lock_0_err = pthread_mutex_lock(&critical_0_lock); assert(____lock_0_err == 0); if (area < MIN_AREA) {
+ { ____critical_acquire(&____critical_lock); if (area < MIN_AREA) {
 				  MIN_AREA         = area;
 				  MIN_FOOTPRINT[0] = footprint[0];
 				  MIN_FOOTPRINT[1] = footprint[1];
 				  memcpy(BEST_BOARD, board, sizeof(ibrd));
 				  bots_debug("N  %d\n", MIN_AREA);
-			  }; const int ____unlock_0_err = pthread_mutex_unlock(&critical_0_lock); assert(____unlock_0_err == 0); } 
+			  }; ____critical_release(&____critical_lock); } 
 		  }
 
 /* if area is less than best area */
           } else if (area < MIN_AREA) {
-__sync_fetch_and_add(&((*(ctx->nnc_ptr))), add_cell(cells[id].next, footprint, board,cells, 0)); ;
+__atomic_fetch_add(&((*(ctx->nnc_ptr))), add_cell(cells[id].next, footprint, board,cells, 0), __ATOMIC_RELAXED); ;
 /* if area is greater than or equal to best area, prune search */
           } else {
 
@@ -130,13 +130,10 @@ static void pragma21_omp_parallel_hclib_async(void *____arg, const int ___iter0,
     int it; it = ctx->it;
     int block_x; block_x = ctx->block_x;
     int block_y; block_y = ctx->block_y;
-    hclib_start_finish();
     do {
     block_x = ___iter0;
     block_y = ___iter1;
 copy_block((*(ctx->nx_ptr)), (*(ctx->ny_ptr)), block_x, block_y, (*(ctx->u__ptr)), (*(ctx->unew__ptr)), (*(ctx->block_size_ptr))) ;     } while (0);
-    ; hclib_end_finish_nonblocking();
-
 }
 
 
@@ -145,14 +142,11 @@ static void pragma28_omp_parallel_hclib_async(void *____arg, const int ___iter0,
     int it; it = ctx->it;
     int block_x; block_x = ctx->block_x;
     int block_y; block_y = ctx->block_y;
-    hclib_start_finish();
     do {
     block_x = ___iter0;
     block_y = ___iter1;
 compute_estimate(block_x, block_y, (*(ctx->u__ptr)), (*(ctx->unew__ptr)), (*(ctx->f__ptr)), (*(ctx->dx_ptr)), (*(ctx->dy_ptr)),
                                  (*(ctx->nx_ptr)), (*(ctx->ny_ptr)), (*(ctx->block_size_ptr))) ;     } while (0);
-    ; hclib_end_finish_nonblocking();
-
 }
 
 
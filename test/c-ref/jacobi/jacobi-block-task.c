@@ -111,10 +111,7 @@ static void pragma26_omp_task_hclib_async(void *____arg) {
     pragma26_omp_task *ctx = (pragma26_omp_task *)____arg;
     int block_x; block_x = ctx->block_x;
     int block_y; block_y = ctx->block_y;
-    hclib_start_finish();
-copy_block((*(ctx->nx_ptr)), (*(ctx->ny_ptr)), block_x, block_y, (*(ctx->u__ptr)), (*(ctx->unew__ptr)), (*(ctx->block_size_ptr))) ;     ; hclib_end_finish_nonblocking();
-
-    free(____arg);
+copy_block((*(ctx->nx_ptr)), (*(ctx->ny_ptr)), block_x, block_y, (*(ctx->u__ptr)), (*(ctx->unew__ptr)), (*(ctx->block_size_ptr))) ;     free(____arg);
 }
 
 
@@ -122,11 +119,8 @@ static void pragma36_omp_task_hclib_async(void *____arg) {
     pragma36_omp_task *ctx = (pragma36_omp_task *)____arg;
     int block_x; block_x = ctx->block_x;
     int block_y; block_y = ctx->block_y;
-    hclib_start_finish();
 compute_estimate(block_x, block_y, (*(ctx->u__ptr)), (*(ctx->unew__ptr)), (*(ctx->f__ptr)), (*(ctx->dx_ptr)), (*(ctx->dy_ptr)),
-                                     (*(ctx->nx_ptr)), (*(ctx->ny_ptr)), (*(ctx->block_size_ptr))) ;     ; hclib_end_finish_nonblocking();
-
-    free(____arg);
+                                     (*(ctx->nx_ptr)), (*(ctx->ny_ptr)), (*(ctx->block_size_ptr))) ;     free(____arg);
 }
 
 
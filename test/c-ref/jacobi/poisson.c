@@ -314,7 +314,6 @@ static void pragma228_omp_task_hclib_async(void *____arg) {
     int nx; nx = ctx->nx;
     int ny; ny = ctx->ny;
     int block_size; block_size = ctx->block_size;
-    hclib_start_finish();
 for (jj=j; jj<j+block_size; ++jj)
             {
                 y = (double) (jj) / (double) (ny - 1);
@@ -326,9 +325,7 @@ for (jj=j; jj<j+block_size; ++jj)
                     else
                         ((*(ctx->f_ptr)))[ii * ny + jj] = - uxxyy_exact(x, y);
                 }
-            } ;     ; hclib_end_finish_nonblocking();
-
-    free(____arg);
+            } ;     free(____arg);
 }
 
 
@@ -121,6 +121,11 @@ float euclid_dist_2(float *pt1,
 
 
 /*----< kmeans_clustering() >---------------------------------------------*/
+typedef struct _pragma173_omp_parallel_reduction {
+    float delta;
+    char ____pad[64];
+ } pragma173_omp_parallel_reduction;
+
 typedef struct _pragma173_omp_parallel {
     int i;
     int j;
@@ -142,7 +147,7 @@ typedef struct _pragma173_omp_parallel {
     int nclusters;
     float (*threshold_ptr);
     int (*(*membership_ptr));
-    pthread_mutex_t reduction_mutex;
+    pragma173_omp_parallel_reduction *per_worker_reductions;
  } pragma173_omp_parallel;
 
 static void pragma173_omp_parallel_hclib_async(void *____arg, const int ___iter0);
@@ -222,8 +227,11 @@ new_ctx->nclusters = nclusters;
 new_ctx->threshold_ptr = &(threshold);
 new_ctx->membership_ptr = &(membership);
 new_ctx->delta = 0;
-const int init_err = pthread_mutex_init(&new_ctx->reduction_mutex, NULL);
-assert(init_err == 0);
+new_ctx->per_worker_reductions = (pragma173_omp_parallel_reduction *)malloc(hclib_get_num_workers() * sizeof(pragma173_omp_parallel_reduction));
+int ____worker;
+for (____worker = 0; ____worker < hclib_get_num_workers(); ____worker++) {
+    new_ctx->per_worker_reductions[____worker].delta = 0;
+}
 hclib_loop_domain_t domain[1];
 domain[0].low = 0;
 domain[0].high = npoints;
@@ -231,8 +239,11 @@ domain[0].stride = 1;
 domain[0].tile = -1;
 hclib_future_t *fut = hclib_forasync_future((void *)pragma173_omp_parallel_hclib_async, new_ctx, 1, domain, HCLIB_FORASYNC_MODE);
 hclib_future_wait(fut);
+for (____worker = 0; ____worker < hclib_get_num_workers(); ____worker++) {
+    delta += new_ctx->per_worker_reductions[____worker].delta;
+}
+free(new_ctx->per_worker_reductions);
 free(new_ctx);
-delta = new_ctx->delta;
  } 
         } /* end of #pragma omp parallel */
 
@@ -276,7 +287,6 @@ static void pragma173_omp_parallel_hclib_async(void *____arg, const int ___iter0
     int nfeatures; nfeatures = ctx->nfeatures;
     int npoints; npoints = ctx->npoints;
     int nclusters; nclusters = ctx->nclusters;
-    hclib_start_finish();
     do {
     i = ___iter0;
 {
@@ -298,13 +308,8 @@ static void pragma173_omp_parallel_hclib_async(void *____arg, const int ___iter0
 	        for (j=0; j<nfeatures; j++)
 		       (*(ctx->partial_new_centers_ptr))[tid * nclusters * nfeatures + index * nfeatures + j] += (*(ctx->feature_ptr))[i * nfeatures + j];
             } ;     } while (0);
-    const int lock_err = pthread_mutex_lock(&ctx->reduction_mutex);
-    assert(lock_err == 0);
-    ctx->delta += delta;
-    const int unlock_err = pthread_mutex_unlock(&ctx->reduction_mutex);
-    assert(unlock_err == 0);
-    ; hclib_end_finish_nonblocking();
-
+    const int ____worker = hclib_get_current_worker();
+    ctx->per_worker_reductions[____worker].delta += delta;
 }
 
 
@@ -344,7 +344,6 @@ static void pragma117_omp_parallel_hclib_async(void *____arg, const int ___iter0
     double fyij; fyij = ctx->fyij;
     double fzij; fzij = ctx->fzij;
     THREE_VECTOR d; d = ctx->d;
-    hclib_start_finish();
     do {
     l = ___iter0;
 {
@@ -427,8 +426,6 @@ static void pragma117_omp_parallel_hclib_async(void *____arg, const int ___iter0
 		} // for k
 
 	} ;     } while (0);
-    ; hclib_end_finish_nonblocking();
-
 }
 
  // main
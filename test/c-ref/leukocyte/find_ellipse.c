@@ -165,7 +165,6 @@ free(new_ctx);
 static void pragma111_omp_parallel_hclib_async(void *____arg, const int ___iter0) {
     pragma111_omp_parallel *ctx = (pragma111_omp_parallel *)____arg;
     int i; i = ctx->i;
-    hclib_start_finish();
     do {
     i = ___iter0;
 {
@@ -209,8 +208,6 @@ static void pragma111_omp_parallel_hclib_async(void *____arg, const int ___iter0
 			}
 		}
 	} ;     } while (0);
-    ; hclib_end_finish_nonblocking();
-
 }
 
 
@@ -276,7 +273,6 @@ free(new_ctx);
 static void pragma186_omp_parallel_hclib_async(void *____arg, const int ___iter0) {
     pragma186_omp_parallel *ctx = (pragma186_omp_parallel *)____arg;
     int i; i = ctx->i;
-    hclib_start_finish();
     do {
     i = ___iter0;
 {
@@ -300,8 +296,6 @@ static void pragma186_omp_parallel_hclib_async(void *____arg, const int ___iter0
 			m_set_val((*(ctx->dilated_ptr)), i, j, max);
 		}
 	} ;     } while (0);
-    ; hclib_end_finish_nonblocking();
-
 }
 
 
@@ -156,7 +156,6 @@ static void pragma62_omp_parallel_hclib_async(void *____arg, const int ___iter0)
     pragma62_omp_parallel *ctx = (pragma62_omp_parallel *)____arg;
     int i; i = ctx->i;
     int j; j = ctx->j;
-    hclib_start_finish();
     do {
     i = ___iter0;
 {
@@ -173,8 +172,6 @@ static void pragma62_omp_parallel_hclib_async(void *____arg, const int ___iter0)
             }
         }
     } ;     } while (0);
-    ; hclib_end_finish_nonblocking();
-
 }
 
 
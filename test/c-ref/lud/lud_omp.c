@@ -150,6 +150,11 @@ static void pragma52_omp_parallel_hclib_async(void *____arg, const int ___iter0)
             float temp[BS*BS] __attribute__ ((aligned (64)));
 
             for (i = 0; i < BS; i++) {
+#if defined(__GNUC__) && !defined(__clang__) && !defined(_OPENMP) && !defined(OMP_TO_HCLIB_OPENMP_SIMD)
+#pragma GCC ivdep
+#else
+#pragma omp simd
+#endif
 for (j =0; j < BS; j++){
                     temp[i*BS + j] = a[size*(i + (*(ctx->offset_ptr))) + (*(ctx->offset_ptr)) + j ];
                 }
@@ -209,6 +214,11 @@ static void pragma106_omp_parallel_hclib_async(void *____arg, const int ___iter0
             j_global = (*(ctx->offset_ptr)) + BS * (1 + chunk_idx%(*(ctx->chunks_in_inter_row_ptr)));
 
             for (i = 0; i < BS; i++) {
+#if defined(__GNUC__) && !defined(__clang__) && !defined(_OPENMP) && !defined(OMP_TO_HCLIB_OPENMP_SIMD)
+#pragma GCC ivdep
+#else
+#pragma omp simd
+#endif
 for (j =0; j < BS; j++){
                     temp_top[i*BS + j]  = a[size*(i + (*(ctx->offset_ptr))) + j + j_global ];
                     temp_left[i*BS + j] = a[size*(i + i_global) + (*(ctx->offset_ptr)) + j];
@@ -218,10 +228,20 @@ for (j =0; j < BS; j++){
             for (i = 0; i < BS; i++)
             {
                 for (k=0; k < BS; k++) {
+#if defined(__GNUC__) && !defined(__clang__) && !defined(_OPENMP) && !defined(OMP_TO_HCLIB_OPENMP_SIMD)
+#pragma GCC ivdep
+#else
+#pragma omp simd
+#endif
 for (j = 0; j < BS; j++) {
                         sum[j] += temp_left[BS*i + k] * temp_top[BS*k + j];
                     }
                 }
+#if defined(__GNUC__) && !defined(__clang__) && !defined(_OPENMP) && !defined(OMP_TO_HCLIB_OPENMP_SIMD)
+#pragma GCC ivdep
+#else
+#pragma omp simd
+#endif
 for (j = 0; j < BS; j++) {
                     BB((i+i_global),(j+j_global)) -= sum[j];
                     sum[j] = 0.f;
@@ -296,7 +296,6 @@ static void pragma117_omp_parallel_hclib_async(void *____arg, const int ___iter0
     pragma117_omp_parallel *ctx = (pragma117_omp_parallel *)____arg;
     int i; i = ctx->i;
     char (*rec_iter); rec_iter = ctx->rec_iter;
-    hclib_start_finish();
     do {
     i = ___iter0;
 {
@@ -305,8 +304,6 @@ static void pragma117_omp_parallel_hclib_async(void *____arg, const int ___iter0
             float tmp_long = atof(rec_iter+5);
 			(*(ctx->z_ptr))[i] = sqrt(( (tmp_lat-(*(ctx->target_lat_ptr))) * (tmp_lat-(*(ctx->target_lat_ptr))) )+( (tmp_long-(*(ctx->target_long_ptr))) * (tmp_long-(*(ctx->target_long_ptr))) ));
         } ;     } while (0);
-    ; hclib_end_finish_nonblocking();
-
 }
 
 
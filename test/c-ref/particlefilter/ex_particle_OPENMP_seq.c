@@ -511,6 +511,11 @@ typedef struct _pragma433_omp_parallel {
     int (*Nparticles_ptr);
  } pragma433_omp_parallel;
 
+typedef struct _pragma440_omp_parallel_reduction {
+    double sumWeights;
+    char ____pad[64];
+ } pragma440_omp_parallel_reduction;
+
 typedef struct _pragma440_omp_parallel {
     long long (*set_arrays_ptr);
     long long (*error_ptr);
@@ -548,7 +553,7 @@ typedef struct _pragma440_omp_parallel {
     int (*Nfr_ptr);
     int (*(*seed_ptr));
     int (*Nparticles_ptr);
-    pthread_mutex_t reduction_mutex;
+    pragma440_omp_parallel_reduction *per_worker_reductions;
  } pragma440_omp_parallel;
 
 typedef struct _pragma446_omp_parallel {
@@ -591,6 +596,12 @@ typedef struct _pragma446_omp_parallel {
     int (*Nparticles_ptr);
  } pragma446_omp_parallel;
 
+typedef struct _pragma455_omp_parallel_reduction {
+    double xe;
+    double ye;
+    char ____pad[64];
+ } pragma455_omp_parallel_reduction;
+
 typedef struct _pragma455_omp_parallel {
     long long (*set_arrays_ptr);
     long long (*error_ptr);
@@ -630,7 +641,7 @@ typedef struct _pragma455_omp_parallel {
     int (*Nfr_ptr);
     int (*(*seed_ptr));
     int (*Nparticles_ptr);
-    pthread_mutex_t reduction_mutex;
+    pragma455_omp_parallel_reduction *per_worker_reductions;
  } pragma455_omp_parallel;
 
 typedef struct _pragma480_omp_parallel {
@@ -1034,8 +1045,11 @@ new_ctx->Nfr_ptr = &(Nfr);
 new_ctx->seed_ptr = &(seed);
 new_ctx->Nparticles_ptr = &(Nparticles);
 new_ctx->sumWeights = 0;
-const int init_err = pthread_mutex_init(&new_ctx->reduction_mutex, NULL);
-assert(init_err == 0);
+new_ctx->per_worker_reductions = (pragma440_omp_parallel_reduction *)malloc(hclib_get_num_workers() * sizeof(pragma440_omp_parallel_reduction));
+int ____worker;
+for (____worker = 0; ____worker < hclib_get_num_workers(); ____worker++) {
+    new_ctx->per_worker_reductions[____worker].sumWeights = 0;
+}
 hclib_loop_domain_t domain[1];
 domain[0].low = 0;
 domain[0].high = Nparticles;
@@ -1043,8 +1057,11 @@ domain[0].stride = 1;
 domain[0].tile = -1;
 hclib_future_t *fut = hclib_forasync_future((void *)pragma440_omp_parallel_hclib_async, new_ctx, 1, domain, HCLIB_FORASYNC_MODE);
 hclib_future_wait(fut);
+for (____worker = 0; ____worker < hclib_get_num_workers(); ____worker++) {
+    sumWeights += new_ctx->per_worker_reductions[____worker].sumWeights;
+}
+free(new_ctx->per_worker_reductions);
 free(new_ctx);
-sumWeights = new_ctx->sumWeights;
  } 
 		long long sum_time = get_time();
 		printf("TIME TO SUM WEIGHTS TOOK: %f\n", elapsed_time(exponential, sum_time));
@@ -1143,8 +1160,12 @@ new_ctx->seed_ptr = &(seed);
 new_ctx->Nparticles_ptr = &(Nparticles);
 new_ctx->xe = 0;
 new_ctx->ye = 0;
-const int init_err = pthread_mutex_init(&new_ctx->reduction_mutex, NULL);
-assert(init_err == 0);
+new_ctx->per_worker_reductions = (pragma455_omp_parallel_reduction *)malloc(hclib_get_num_workers() * sizeof(pragma455_omp_parallel_reduction));
+int ____worker;
+for (____worker = 0; ____worker < hclib_get_num_workers(); ____worker++) {
+    new_ctx->per_worker_reductions[____worker].xe = 0;
+    new_ctx->per_worker_reductions[____worker].ye = 0;
+}
 hclib_loop_domain_t domain[1];
 domain[0].low = 0;
 domain[0].high = Nparticles;
@@ -1152,9 +1173,12 @@ domain[0].stride = 1;
 domain[0].tile = -1;
 hclib_future_t *fut = hclib_forasync_future((void *)pragma455_omp_parallel_hclib_async, new_ctx, 1, domain, HCLIB_FORASYNC_MODE);
 hclib_future_wait(fut);
+for (____worker = 0; ____worker < hclib_get_num_workers(); ____worker++) {
+    xe += new_ctx->per_worker_reductions[____worker].xe;
+    ye += new_ctx->per_worker_reductions[____worker].ye;
+}
+free(new_ctx->per_worker_reductions);
 free(new_ctx);
-xe = new_ctx->xe;
-ye = new_ctx->ye;
  } 
 		long long move_time = get_time();
 		printf("TIME TO MOVE OBJECT TOOK: %f\n", elapsed_time(normalize, move_time));
@@ -1340,15 +1364,12 @@ static void pragma388_omp_parallel_hclib_async(void *____arg, const int ___iter0
 static void pragma402_omp_parallel_hclib_async(void *____arg, const int ___iter0) {
     pragma402_omp_parallel *ctx = (pragma402_omp_parallel *)____arg;
     int x; x = ctx->x;
-    hclib_start_finish();
     do {
     x = ___iter0;
 {
 			(*(ctx->arrayX_ptr))[x] += 1 + 5*randn((*(ctx->seed_ptr)), x);
 			(*(ctx->arrayY_ptr))[x] += -2 + 2*randn((*(ctx->seed_ptr)), x);
 		} ;     } while (0);
-    ; hclib_end_finish_nonblocking();
-
 }
 
 
@@ -1358,7 +1379,6 @@ static void pragma410_omp_parallel_hclib_async(void *____arg, const int ___iter0
     int y; y = ctx->y;
     int indX; indX = ctx->indX;
     int indY; indY = ctx->indY;
-    hclib_start_finish();
     do {
     x = ___iter0;
 {
@@ -1379,22 +1399,17 @@ static void pragma410_omp_parallel_hclib_async(void *____arg, const int ___iter0
 				(*(ctx->likelihood_ptr))[x] += (pow(((*(ctx->I_ptr))[(*(ctx->ind_ptr))[x*(*(ctx->countOnes_ptr)) + y]] - 100),2) - pow(((*(ctx->I_ptr))[(*(ctx->ind_ptr))[x*(*(ctx->countOnes_ptr)) + y]]-228),2))/50.0;
 			(*(ctx->likelihood_ptr))[x] = (*(ctx->likelihood_ptr))[x]/((double) (*(ctx->countOnes_ptr)));
 		} ;     } while (0);
-    ; hclib_end_finish_nonblocking();
-
 }
 
 
 static void pragma433_omp_parallel_hclib_async(void *____arg, const int ___iter0) {
     pragma433_omp_parallel *ctx = (pragma433_omp_parallel *)____arg;
     int x; x = ctx->x;
-    hclib_start_finish();
     do {
     x = ___iter0;
 {
 			(*(ctx->weights_ptr))[x] = (*(ctx->weights_ptr))[x] * exp((*(ctx->likelihood_ptr))[x]);
 		} ;     } while (0);
-    ; hclib_end_finish_nonblocking();
-
 }
 
 
@@ -1407,11 +1422,8 @@ static void pragma440_omp_parallel_hclib_async(void *____arg, const int ___iter0
 {
 			sumWeights += (*(ctx->weights_ptr))[x];
 		} ;     } while (0);
-    const int lock_err = pthread_mutex_lock(&ctx->reduction_mutex);
-    assert(lock_err == 0);
-    ctx->sumWeights += sumWeights;
-    const int unlock_err = pthread_mutex_unlock(&ctx->reduction_mutex);
-    assert(unlock_err == 0);
+    const int ____worker = hclib_get_current_worker();
+    ctx->per_worker_reductions[____worker].sumWeights += sumWeights;
 }
 
 
@@ -1437,12 +1449,9 @@ static void pragma455_omp_parallel_hclib_async(void *____arg, const int ___iter0
 			xe += (*(ctx->arrayX_ptr))[x] * (*(ctx->weights_ptr))[x];
 			ye += (*(ctx->arrayY_ptr))[x] * (*(ctx->weights_ptr))[x];
 		} ;     } while (0);
-    const int lock_err = pthread_mutex_lock(&ctx->reduction_mutex);
-    assert(lock_err == 0);
-    ctx->xe += xe;
-    ctx->ye += ye;
-    const int unlock_err = pthread_mutex_unlock(&ctx->reduction_mutex);
-    assert(unlock_err == 0);
+    const int ____worker = hclib_get_current_worker();
+    ctx->per_worker_reductions[____worker].xe += xe;
+    ctx->per_worker_reductions[____worker].ye += ye;
 }
 
 
@@ -1461,7 +1470,6 @@ static void pragma488_omp_parallel_hclib_async(void *____arg, const int ___iter0
     pragma488_omp_parallel *ctx = (pragma488_omp_parallel *)____arg;
     int j; j = ctx->j;
     int i; i = ctx->i;
-    hclib_start_finish();
     do {
     j = ___iter0;
 {
@@ -1472,8 +1480,6 @@ static void pragma488_omp_parallel_hclib_async(void *____arg, const int ___iter0
 			(*(ctx->yj_ptr))[j] = (*(ctx->arrayY_ptr))[i];
 			
 		} ;     } while (0);
-    ; hclib_end_finish_nonblocking();
-
 }
 
 
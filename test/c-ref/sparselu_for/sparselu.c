@@ -360,12 +360,9 @@ static void pragma266_omp_task_hclib_async(void *____arg) {
     pragma266_omp_task *ctx = (pragma266_omp_task *)____arg;
     int jj; jj = ctx->jj;
     int kk; kk = ctx->kk;
-    hclib_start_finish();
 {
             fwd((*(ctx->BENCH_ptr))[kk*bots_arg_size+kk], (*(ctx->BENCH_ptr))[kk*bots_arg_size+jj]);
-             } ;     ; hclib_end_finish_nonblocking();
-
-    free(____arg);
+             } ;     free(____arg);
 }
 
 
@@ -373,12 +370,9 @@ static void pragma274_omp_task_hclib_async(void *____arg) {
     pragma274_omp_task *ctx = (pragma274_omp_task *)____arg;
     int ii; ii = ctx->ii;
     int kk; kk = ctx->kk;
-    hclib_start_finish();
 {
             bdiv ((*(ctx->BENCH_ptr))[kk*bots_arg_size+kk], (*(ctx->BENCH_ptr))[ii*bots_arg_size+kk]);
-             } ;     ; hclib_end_finish_nonblocking();
-
-    free(____arg);
+             } ;     free(____arg);
 }
 
 
@@ -387,13 +381,10 @@ static void pragma285_omp_task_hclib_async(void *____arg) {
     int ii; ii = ctx->ii;
     int jj; jj = ctx->jj;
     int kk; kk = ctx->kk;
-    hclib_start_finish();
 {
                      if ((*(ctx->BENCH_ptr))[ii*bots_arg_size+jj]==NULL) (*(ctx->BENCH_ptr))[ii*bots_arg_size+jj] = allocate_clean_block();
                      bmod((*(ctx->BENCH_ptr))[ii*bots_arg_size+kk], (*(ctx->BENCH_ptr))[kk*bots_arg_size+jj], (*(ctx->BENCH_ptr))[ii*bots_arg_size+jj]);
-                   } ;     ; hclib_end_finish_nonblocking();
-
-    free(____arg);
+                   } ;     free(____arg);
 }
 
 
@@ -356,12 +356,9 @@ static void pragma234_omp_task_hclib_async(void *____arg) {
     pragma234_omp_task *ctx = (pragma234_omp_task *)____arg;
     int jj; jj = ctx->jj;
     int kk; kk = ctx->kk;
-    hclib_start_finish();
 {
                            fwd((*(ctx->BENCH_ptr))[kk*bots_arg_size+kk], (*(ctx->BENCH_ptr))[kk*bots_arg_size+jj]);
-                           } ;     ; hclib_end_finish_nonblocking();
-
-    free(____arg);
+                           } ;     free(____arg);
 }
 
 
@@ -369,12 +366,9 @@ static void pragma242_omp_task_hclib_async(void *____arg) {
     pragma242_omp_task *ctx = (pragma242_omp_task *)____arg;
     int ii; ii = ctx->ii;
     int kk; kk = ctx->kk;
-    hclib_start_finish();
 {
                            bdiv ((*(ctx->BENCH_ptr))[kk*bots_arg_size+kk], (*(ctx->BENCH_ptr))[ii*bots_arg_size+kk]);
-                           } ;     ; hclib_end_finish_nonblocking();
-
-    free(____arg);
+                           } ;     free(____arg);
 }
 
 
@@ -383,13 +377,10 @@ static void pragma255_omp_task_hclib_async(void *____arg) {
     int ii; ii = ctx->ii;
     int jj; jj = ctx->jj;
     int kk; kk = ctx->kk;
-    hclib_start_finish();
 {
                                    if ((*(ctx->BENCH_ptr))[ii*bots_arg_size+jj]==NULL) (*(ctx->BENCH_ptr))[ii*bots_arg_size+jj] = allocate_clean_block();
                                    bmod((*(ctx->BENCH_ptr))[ii*bots_arg_size+kk], (*(ctx->BENCH_ptr))[kk*bots_arg_size+jj], (*(ctx->BENCH_ptr))[ii*bots_arg_size+jj]);
-                                   } ;     ; hclib_end_finish_nonblocking();
-
-    free(____arg);
+                                   } ;     free(____arg);
 }
 
 
@@ -484,7 +484,7 @@ void genChildren(Node * parent, Node * child) {
   t_metadata[omp_get_thread_num()].ntasks += 1;
 #endif
 
-__sync_fetch_and_add(&(n_nodes), 1); ;
+__atomic_fetch_add(&(n_nodes), 1, __ATOMIC_RELAXED); ;
 
   numChildren = uts_numChildren(parent);
   childType   = uts_childType(parent);
@@ -528,7 +528,7 @@ __sync_fetch_and_add(&(n_nodes), 1); ;
       }
     }
   } else {
-__sync_fetch_and_add(&(n_leaves), 1); ;
+__atomic_fetch_add(&(n_leaves), 1, __ATOMIC_RELAXED); ;
   }
 }
 
@@ -74,8 +74,8 @@ hclib_loop_domain_t domain[1];
 domain[0].low = 0;
 domain[0].high = N;
 domain[0].stride = 1;
-domain[0].tile = -1;
-hclib_future_t *fut = hclib_forasync_future((void *)pragma53_omp_parallel_hclib_async, new_ctx, 1, domain, HCLIB_FORASYNC_MODE);
+domain[0].tile = (((N) - (0)) > 0 ? 1 + (((N) - (0)) - 1) / hclib_get_num_workers() : 1);
+hclib_future_t *fut = hclib_forasync_future((void *)pragma53_omp_parallel_hclib_async, new_ctx, 1, domain, FORASYNC_MODE_FLAT);
 hclib_future_wait(fut);
 free(new_ctx);
  } 
@@ -147,8 +147,8 @@ hclib_loop_domain_t domain[1];
 domain[0].low = 0;
 domain[0].high = nelr;
 domain[0].stride = 1;
-domain[0].tile = -1;
-hclib_future_t *fut = hclib_forasync_future((void *)pragma102_omp_parallel_hclib_async, new_ctx, 1, domain, HCLIB_FORASYNC_MODE);
+domain[0].tile = (((nelr) - (0)) > 0 ? 1 + (((nelr) - (0)) - 1) / hclib_get_num_workers() : 1);
+hclib_future_t *fut = hclib_forasync_future((void *)pragma102_omp_parallel_hclib_async, new_ctx, 1, domain, FORASYNC_MODE_FLAT);
 hclib_future_wait(fut);
 free(new_ctx);
  } 
@@ -228,15 +228,14 @@ hclib_loop_domain_t domain[1];
 domain[0].low = 0;
 domain[0].high = nelr;
 domain[0].stride = 1;
-domain[0].tile = -1;
-hclib_future_t *fut = hclib_forasync_future((void *)pragma155_omp_parallel_hclib_async, new_ctx, 1, domain, HCLIB_FORASYNC_MODE);
+domain[0].tile = (((nelr) - (0)) > 0 ? 1 + (((nelr) - (0)) - 1) / hclib_get_num_workers() : 1);
+hclib_future_t *fut = hclib_forasync_future((void *)pragma155_omp_parallel_hclib_async, new_ctx, 1, domain, FORASYNC_MODE_FLAT);
 hclib_future_wait(fut);
 free(new_ctx);
  } 
 } 
 static void pragma155_omp_parallel_hclib_async(void *____arg, const int ___iter0) {
     pragma155_omp_parallel *ctx = (pragma155_omp_parallel *)____arg;
-    hclib_start_finish();
     do {
     int i;     i = ___iter0;
 {
@@ -256,8 +255,6 @@ static void pragma155_omp_parallel_hclib_async(void *____arg, const int ___iter0
 		// dt = double(0.5) * std::sqrt(areas[i]) /  (||v|| + c).... but when we do time stepping, this later would need to be divided by the area, so we just do it all at once
 		(*(ctx->step_factors_ptr))[i] = double(0.5) / (std::sqrt((*(ctx->areas_ptr))[i]) * (std::sqrt(speed_sqd) + speed_of_sound));
 	} ;     } while (0);
-    ; hclib_end_finish_nonblocking();
-
 }
 
 
@@ -294,15 +291,14 @@ hclib_loop_domain_t domain[1];
 domain[0].low = 0;
 domain[0].high = nelr;
 domain[0].stride = 1;
-domain[0].tile = -1;
-hclib_future_t *fut = hclib_forasync_future((void *)pragma186_omp_parallel_hclib_async, new_ctx, 1, domain, HCLIB_FORASYNC_MODE);
+domain[0].tile = (((nelr) - (0)) > 0 ? 1 + (((nelr) - (0)) - 1) / hclib_get_num_workers() : 1);
+hclib_future_t *fut = hclib_forasync_future((void *)pragma186_omp_parallel_hclib_async, new_ctx, 1, domain, FORASYNC_MODE_FLAT);
 hclib_future_wait(fut);
 free(new_ctx);
  } 
 } 
 static void pragma186_omp_parallel_hclib_async(void *____arg, const int ___iter0) {
     pragma186_omp_parallel *ctx = (pragma186_omp_parallel *)____arg;
-    hclib_start_finish();
     do {
     int i;     i = ___iter0;
 {
@@ -430,8 +426,6 @@ static void pragma186_omp_parallel_hclib_async(void *____arg, const int ___iter0
 		(*(ctx->fluxes_ptr))[i*NVAR + (VAR_MOMENTUM+2)] = flux_i_momentum.z;
 		(*(ctx->fluxes_ptr))[i*NVAR + VAR_DENSITY_ENERGY] = flux_i_density_energy;
 	} ;     } while (0);
-    ; hclib_end_finish_nonblocking();
-
 }
 
 
@@ -460,8 +454,8 @@ hclib_loop_domain_t domain[1];
 domain[0].low = 0;
 domain[0].high = nelr;
 domain[0].stride = 1;
-domain[0].tile = -1;
-hclib_future_t *fut = hclib_forasync_future((void *)pragma317_omp_parallel_hclib_async, new_ctx, 1, domain, HCLIB_FORASYNC_MODE);
+domain[0].tile = (((nelr) - (0)) > 0 ? 1 + (((nelr) - (0)) - 1) / hclib_get_num_workers() : 1);
+hclib_future_t *fut = hclib_forasync_future((void *)pragma317_omp_parallel_hclib_async, new_ctx, 1, domain, FORASYNC_MODE_FLAT);
 hclib_future_wait(fut);
 free(new_ctx);
  } 
@@ -111,8 +111,8 @@ hclib_loop_domain_t domain[1];
 domain[0].low = 0;
 domain[0].high = num_chunk;
 domain[0].stride = 1;
-domain[0].tile = -1;
-hclib_future_t *fut = hclib_forasync_future((void *)pragma62_omp_parallel_hclib_async, new_ctx, 1, domain, HCLIB_FORASYNC_MODE);
+domain[0].tile = (((num_chunk) - (0)) > 0 ? 1 + (((num_chunk) - (0)) - 1) / hclib_get_num_workers() : 1);
+hclib_future_t *fut = hclib_forasync_future((void *)pragma62_omp_parallel_hclib_async, new_ctx, 1, domain, FORASYNC_MODE_FLAT);
 hclib_future_wait(fut);
 free(new_ctx);
  } 
@@ -195,6 +195,11 @@ static void pragma62_omp_parallel_hclib_async(void *____arg, const int ___iter0)
         }
 
         for ( r = r_start; r < r_start + BLOCK_SIZE_R; ++r ) {
+#if defined(__GNUC__) && !defined(__clang__) && !defined(_OPENMP) && !defined(OMP_TO_HCLIB_OPENMP_SIMD)
+#pragma GCC ivdep
+#else
+#pragma omp simd
+#endif
 for ( c = c_start; c < c_start + BLOCK_SIZE_C; ++c ) {
             /* Update Temperatures */
                 (*(ctx->result_ptr))[r*col+c] =(*(ctx->temp_ptr))[r*col+c]+ 
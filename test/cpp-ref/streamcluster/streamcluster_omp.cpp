@@ -309,6 +309,11 @@ float pspeedy(Points *points, float z, long *kcenter, int pid)
 /* z is the facility cost, x is the number of this point in the array 
    points */
 
+typedef struct _pragma389_omp_parallel_reduction {
+    double cost_of_opening_x;
+    char ____pad[64];
+ } pragma389_omp_parallel_reduction;
+
 typedef struct _pragma389_omp_parallel {
     double (*t0_ptr);
     long (*bsize_ptr);
@@ -332,7 +337,7 @@ typedef struct _pragma389_omp_parallel {
     double (*z_ptr);
     long (*(*numcenters_ptr));
     int (*pid_ptr);
-    pthread_mutex_t reduction_mutex;
+    pragma389_omp_parallel_reduction *per_worker_reductions;
  } pragma389_omp_parallel;
 
 typedef struct _pragma465_omp_parallel {
@@ -473,8 +478,11 @@ new_ctx->z_ptr = &(z);
 new_ctx->numcenters_ptr = &(numcenters);
 new_ctx->pid_ptr = &(pid);
 new_ctx->cost_of_opening_x = 0;
-const int init_err = pthread_mutex_init(&new_ctx->reduction_mutex, NULL);
-assert(init_err == 0);
+new_ctx->per_worker_reductions = (pragma389_omp_parallel_reduction *)malloc(hclib_get_num_workers() * sizeof(pragma389_omp_parallel_reduction));
+int ____worker;
+for (____worker = 0; ____worker < hclib_get_num_workers(); ____worker++) {
+    new_ctx->per_worker_reductions[____worker].cost_of_opening_x = 0;
+}
 hclib_loop_domain_t domain[1];
 domain[0].low = k1;
 domain[0].high = k2;
@@ -482,8 +490,11 @@ domain[0].stride = 1;
 domain[0].tile = -1;
 hclib_future_t *fut = hclib_forasync_future((void *)pragma389_omp_parallel_hclib_async, new_ctx, 1, domain, HCLIB_FORASYNC_MODE);
 hclib_future_wait(fut);
+for (____worker = 0; ____worker < hclib_get_num_workers(); ____worker++) {
+    cost_of_opening_x += new_ctx->per_worker_reductions[____worker].cost_of_opening_x;
+}
+free(new_ctx->per_worker_reductions);
 free(new_ctx);
-cost_of_opening_x = new_ctx->cost_of_opening_x;
  } 
 
 #ifdef PROFILE
@@ -607,7 +618,6 @@ static void pragma389_omp_parallel_hclib_async(void *____arg, const int ___iter0
     pragma389_omp_parallel *ctx = (pragma389_omp_parallel *)____arg;
     int i; i = ctx->i;
     double cost_of_opening_x; cost_of_opening_x = ctx->cost_of_opening_x;
-    hclib_start_finish();
     do {
     i = ___iter0;
 {
@@ -635,20 +645,14 @@ static void pragma389_omp_parallel_hclib_async(void *____arg, const int ___iter0
       (*(ctx->lower_ptr))[center_table[assign]] += current_cost - x_cost;			
     }
   } ;     } while (0);
-    const int lock_err = pthread_mutex_lock(&ctx->reduction_mutex);
-    assert(lock_err == 0);
-    ctx->cost_of_opening_x += cost_of_opening_x;
-    const int unlock_err = pthread_mutex_unlock(&ctx->reduction_mutex);
-    assert(unlock_err == 0);
-    ; hclib_end_finish_nonblocking();
-
+    const int ____worker = hclib_get_current_worker();
+    ctx->per_worker_reductions[____worker].cost_of_opening_x += cost_of_opening_x;
 }
 
 
 static void pragma465_omp_parallel_hclib_async(void *____arg, const int ___iter0) {
     pragma465_omp_parallel *ctx = (pragma465_omp_parallel *)____arg;
     int i; i = ctx->i;
-    hclib_start_finish();
     do {
     int i;     i = ___iter0;
 {
@@ -661,8 +665,6 @@ static void pragma465_omp_parallel_hclib_async(void *____arg, const int ___iter0
 				(*(ctx->points_ptr))->p[i].assign = (*(ctx->x_ptr));
       }
     } ;     } while (0);
-    ; hclib_end_finish_nonblocking();
-
 }
 
 
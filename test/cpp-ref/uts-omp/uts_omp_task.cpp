@@ -497,7 +497,7 @@ void genChildren(Node * parent, Node * child) {
   t_metadata[omp_get_thread_num()].ntasks += 1;
 #endif
 
-__sync_fetch_and_add(&(n_nodes), 1); ;
+__atomic_fetch_add(&(n_nodes), 1, __ATOMIC_RELAXED); ;
 
   numChildren = uts_numChildren(parent);
   childType   = uts_childType(parent);
@@ -532,6 +532,19 @@ __sync_fetch_and_add(&(n_nodes), 1); ;
       Node parent = *child;
 
  { 
+if (!(parent.height < 9)) {
+Node ____inline_parent = parent;
+{ Node parent = ____inline_parent; 
+{
+          Node child;
+          initNode(&child);
+
+          if (parent.numChildren < 0) {
+              genChildren(&parent, &child);
+          }
+      }
+}
+} else {
 pragma514_omp_task *new_ctx = (pragma514_omp_task *)malloc(sizeof(pragma514_omp_task));
 new_ctx->parent = parent;
 new_ctx->i_ptr = &(i);
@@ -542,15 +555,12 @@ new_ctx->parentHeight_ptr = &(parentHeight);
 new_ctx->numChildren_ptr = &(numChildren);
 new_ctx->childType_ptr = &(childType);
 new_ctx->child_ptr = &(child);
-if (!(parent.height < 9)) {
-    pragma514_omp_task_hclib_async(new_ctx);
-} else {
 hclib_async(pragma514_omp_task_hclib_async, new_ctx, NO_FUTURE, ANY_PLACE);
 }
  } 
     }
   } else {
-__sync_fetch_and_add(&(n_leaves), 1); ;
+__atomic_fetch_add(&(n_leaves), 1, __ATOMIC_RELAXED); ;
   }
 } 
 static void pragma514_omp_task_hclib_async(void *____arg) {
@@ -0,0 +1,70 @@
+#include "hclib.h"
+#ifdef __cplusplus
+#include "hclib_cpp.h"
+#include "hclib_system.h"
+#ifdef __CUDACC__
+#include "hclib_cuda.h"
+#endif
+#endif
+typedef struct _pragma4_omp_parallel {
+    int i;
+    int j;
+    int (*n_ptr);
+    int (*m_ptr);
+    double (*(*out_ptr));
+    const double (*(*in_ptr));
+ } pragma4_omp_parallel;
+
+static void pragma4_omp_parallel_hclib_async(void *____arg, const int ___iter0, const int ___iter1);
+void transpose(int n, int m, double *out, const double *in) {
+    int i;
+    int j;
+ { 
+pragma4_omp_parallel *new_ctx = (pragma4_omp_parallel *)malloc(sizeof(pragma4_omp_parallel));
+new_ctx->i = i;
+new_ctx->j = j;
+new_ctx->n_ptr = &(n);
+new_ctx->m_ptr = &(m);
+new_ctx->out_ptr = &(out);
+new_ctx->in_ptr = &(in);
+hclib_loop_domain_t domain[2];
+domain[0].low = 0;
+domain[0].high = n;
+domain[0].stride = 1;
+domain[0].tile = -1;
+domain[1].low = 0;
+domain[1].high = m;
+domain[1].stride = 1;
+domain[1].tile = -1;
+{
+long ____budget = (256 * 1024) / 16;
+long ____tile_iters;
+____tile_iters = (domain[1].high - domain[1].low + domain[1].stride - 1) / domain[1].stride;
+if (____tile_iters > ____budget) ____tile_iters = ____budget;
+if (____tile_iters < 1) ____tile_iters = 1;
+domain[1].tile = ____tile_iters * domain[1].stride;
+____budget /= ____tile_iters;
+____tile_iters = (domain[0].high - domain[0].low + domain[0].stride - 1) / domain[0].stride;
+if (____tile_iters > 0) ____tile_iters = 1 + (____tile_iters - 1) / hclib_get_num_workers();
+if (____tile_iters > ____budget) ____tile_iters = ____budget;
+if (____tile_iters < 1) ____tile_iters = 1;
+domain[0].tile = ____tile_iters * domain[0].stride;
+}
+hclib_future_t *fut = hclib_forasync_future((void *)pragma4_omp_parallel_hclib_async, new_ctx, 2, domain, HCLIB_FORASYNC_MODE);
+hclib_future_wait(fut);
+free(new_ctx);
+ } 
+} 
+static void pragma4_omp_parallel_hclib_async(void *____arg, const int ___iter0, const int ___iter1) {
+    pragma4_omp_parallel *ctx = (pragma4_omp_parallel *)____arg;
+    int i; i = ctx->i;
+    int j; j = ctx->j;
+    do {
+    i = ___iter0;
+    j = ___iter1;
+{
+            (*(ctx->out_ptr))[j * (*(ctx->n_ptr)) + i] = (*(ctx->in_ptr))[i * (*(ctx->m_ptr)) + j];
+        } ;     } while (0);
+}
+
+
@@ -0,0 +1,143 @@
+#include "hclib.h"
+#ifdef __cplusplus
+#include "hclib_cpp.h"
+#include "hclib_system.h"
+#ifdef __CUDACC__
+#include "hclib_cuda.h"
+#endif
+#endif
+typedef struct _pragma3_omp_parallel {
+    int (*i_ptr);
+    int (*n_ptr);
+    double (*(*a_ptr));
+    hclib_loop_domain_t ____range[1];
+ } pragma3_omp_parallel;
+
+static void pragma3_omp_parallel_hclib_async(void *____arg, const int ___iter0);
+int scale_all(int n, double *a) {
+    int i;
+ { 
+pragma3_omp_parallel *new_ctx = (pragma3_omp_parallel *)malloc(sizeof(pragma3_omp_parallel));
+new_ctx->i_ptr = &(i);
+new_ctx->n_ptr = &(n);
+new_ctx->a_ptr = &(a);
+hclib_loop_domain_t domain[1];
+domain[0].low = 0;
+domain[0].high = n;
+domain[0].stride = 1;
+domain[0].tile = -1;
+new_ctx->____range[0] = domain[0];
+hclib_future_t *fut = hclib_forasync_future((void *)pragma3_omp_parallel_hclib_async, new_ctx, 1, domain, HCLIB_FORASYNC_MODE);
+hclib_future_wait(fut);
+free(new_ctx);
+ } 
+    return i;
+} 
+static void pragma3_omp_parallel_hclib_async(void *____arg, const int ___iter0) {
+    pragma3_omp_parallel *ctx = (pragma3_omp_parallel *)____arg;
+    int i;
+    do {
+    i = ___iter0;
+{
+        (*(ctx->a_ptr))[i] = 2.0 * (*(ctx->a_ptr))[i];
+    } ;     } while (0);
+    if (___iter0 + ctx->____range[0].stride >= ctx->____range[0].high) {
+        *(ctx->i_ptr) = i + ctx->____range[0].stride;
+    }
+}
+
+
+
+#ifndef ____omp_team_DEFINED
+#define ____omp_team_DEFINED
+typedef struct ____omp_team_t {
+    int nthreads;
+    int next_thread_num;
+    int arrived;
+    int episode;
+    int lock;
+    hclib_promise_t release[2];
+} ____omp_team_t;
+static inline void ____omp_team_init(____omp_team_t *team, int nthreads) {
+    team->nthreads = (nthreads > 0 ? nthreads : 1);
+    team->next_thread_num = 0;
+    team->arrived = 0;
+    team->episode = 0;
+    team->lock = 0;
+    hclib_promise_init(&team->release[0]);
+}
+static inline int ____omp_team_join(____omp_team_t *team) {
+    return __atomic_fetch_add(&team->next_thread_num, 1, __ATOMIC_RELAXED);
+}
+static inline int ____omp_team_size(____omp_team_t *team) {
+    return (team == NULL ? 1 : team->nthreads);
+}
+static inline void ____omp_team_lock(____omp_team_t *team) {
+    if (team == NULL) return;
+    while (__atomic_exchange_n(&team->lock, 1, __ATOMIC_ACQUIRE)) { }
+}
+static inline void ____omp_team_unlock(____omp_team_t *team) {
+    if (team == NULL) return;
+    __atomic_store_n(&team->lock, 0, __ATOMIC_RELEASE);
+}
+static inline void ____omp_team_barrier(____omp_team_t *team) {
+    if (____omp_team_size(team) == 1) return;
+    const int episode = __atomic_load_n(&team->episode, __ATOMIC_ACQUIRE);
+    hclib_promise_t *release = &team->release[episode & 1];
+    if (__atomic_add_fetch(&team->arrived, 1, __ATOMIC_ACQ_REL) == team->nthreads) {
+        __atomic_store_n(&team->arrived, 0, __ATOMIC_RELAXED);
+        hclib_promise_init(&team->release[(episode + 1) & 1]);
+        __atomic_store_n(&team->episode, episode + 1, __ATOMIC_RELEASE);
+        hclib_promise_put(release, NULL);
+    } else {
+        hclib_future_wait(hclib_get_future_for_promise(release));
+    }
+}
+static inline int ____omp_team_static_chunk(____omp_team_t *team, long chunk, long niters, long chunk_size, long *begin, long *end) {
+    if (chunk_size <= 0) {
+        const long nthreads = ____omp_team_size(team);
+        chunk_size = (niters + nthreads - 1) / nthreads;
+    }
+    if (chunk_size <= 0 || chunk >= (niters + chunk_size - 1) / chunk_size) return 0;
+    *begin = chunk * chunk_size;
+    *end = (*begin + chunk_size < niters ? *begin + chunk_size : niters);
+    return 1;
+}
+#endif
+typedef struct _pragma12_omp_parallel {
+    int (*i_ptr);
+    int (*n_ptr);
+    double (*(*a_ptr));
+    ____omp_team_t ____team;
+ } pragma12_omp_parallel;
+
+static void pragma12_omp_parallel_hclib_async(void *____arg);
+int scale_team(int n, double *a) {
+    int i;
+ { 
+pragma12_omp_parallel *new_ctx = (pragma12_omp_parallel *)malloc(sizeof(pragma12_omp_parallel));
+new_ctx->i_ptr = &(i);
+new_ctx->n_ptr = &(n);
+new_ctx->a_ptr = &(a);
+____omp_team_init(&new_ctx->____team, hclib_get_num_workers());
+hclib_start_finish();
+int ____thread;
+for (____thread = 0; ____thread < new_ctx->____team.nthreads; ____thread++) {
+    hclib_async(pragma12_omp_parallel_hclib_async, new_ctx, NO_FUTURE, ANY_PLACE);
+}
+hclib_end_finish();
+free(new_ctx);
+ } 
+    return i;
+} 
+static void pragma12_omp_parallel_hclib_async(void *____arg) {
+    pragma12_omp_parallel *ctx = (pragma12_omp_parallel *)____arg;
+{ ____omp_team_t *____team = &(ctx->____team); const int ____thread_num = ____omp_team_join(____team); {   
+ { const int ____low = 0; const int ____high = (*(ctx->n_ptr)); const int ____stride = 1; const int ____niters = (____high > ____low ? (____high - ____low + ____stride - 1) / ____stride : 0); int (*____lastprivate_i) = &((*(ctx->i_ptr))); { int i; long ____chunk, ____begin, ____end, ____iter; for (____chunk = ____thread_num; ____omp_team_static_chunk(____team, ____chunk, ____niters, 0, &____begin, &____end); ____chunk += ____omp_team_size(____team)) { for (____iter = ____begin; ____iter < ____end; ____iter++) { i = ____low + ____iter * ____stride;
+{
+            (*(ctx->a_ptr))[i] = 2.0 * (*(ctx->a_ptr))[i];
+        }
+} if (____begin < ____end && ____end == ____niters) { *____lastprivate_i = ____low + ____niters * ____stride; } } } } ____omp_team_barrier(____team); 
+    } ; } ; }
+
+
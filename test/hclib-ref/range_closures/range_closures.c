@@ -0,0 +1,61 @@
+#include "hclib.h"
+#ifdef __cplusplus
+#include "hclib_cpp.h"
+#include "hclib_system.h"
+#ifdef __CUDACC__
+#include "hclib_cuda.h"
+#endif
+#endif
+typedef struct _pragma3_omp_parallel {
+    int i;
+    int (*n_ptr);
+    double (*(*a_ptr));
+    double (*s_ptr);
+    hclib_loop_domain_t ____range[1];
+ } pragma3_omp_parallel;
+
+static void pragma3_omp_parallel_hclib_async(void *____arg, const int ___tile0);
+void scale(int n, double *a, double s) {
+    int i;
+ { 
+pragma3_omp_parallel *new_ctx = (pragma3_omp_parallel *)malloc(sizeof(pragma3_omp_parallel));
+new_ctx->i = i;
+new_ctx->n_ptr = &(n);
+new_ctx->a_ptr = &(a);
+new_ctx->s_ptr = &(s);
+hclib_loop_domain_t domain[1];
+domain[0].low = 0;
+domain[0].high = n;
+domain[0].stride = 1;
+domain[0].tile = -1;
+new_ctx->____range[0] = domain[0];
+if (new_ctx->____range[0].tile <= 0) {
+    new_ctx->____range[0].tile = (1 + ((domain[0].high - domain[0].low + domain[0].stride - 1) / domain[0].stride - 1) / (4 * hclib_get_num_workers())) * domain[0].stride;
+    if (new_ctx->____range[0].tile <= 0) new_ctx->____range[0].tile = domain[0].stride;
+}
+domain[0].high = (domain[0].high - domain[0].low + new_ctx->____range[0].tile - 1) / new_ctx->____range[0].tile;
+domain[0].low = 0;
+domain[0].stride = 1;
+domain[0].tile = 1;
+hclib_future_t *fut = hclib_forasync_future((void *)pragma3_omp_parallel_hclib_async, new_ctx, 1, domain, HCLIB_FORASYNC_MODE);
+hclib_future_wait(fut);
+free(new_ctx);
+ } 
+} 
+static void pragma3_omp_parallel_hclib_async(void *____arg, const int ___tile0) {
+    pragma3_omp_parallel *ctx = (pragma3_omp_parallel *)____arg;
+    int i; i = ctx->i;
+    const int ___low0 = ctx->____range[0].low + ___tile0 * ctx->____range[0].tile;
+    const int ___high0 = (___low0 + ctx->____range[0].tile < ctx->____range[0].high ? ___low0 + ctx->____range[0].tile : ctx->____range[0].high);
+    const int ___stride0 = ctx->____range[0].stride;
+    int ___iter0;
+    for (___iter0 = ___low0; ___iter0 < ___high0; ___iter0 += ___stride0) {
+    do {
+    i = ___iter0;
+{
+        (*(ctx->a_ptr))[i] = (*(ctx->a_ptr))[i] * (*(ctx->s_ptr));
+    } ;     } while (0);
+    }
+}
+
+
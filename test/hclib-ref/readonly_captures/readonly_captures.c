@@ -0,0 +1,51 @@
+#include "hclib.h"
+#ifdef __cplusplus
+#include "hclib_cpp.h"
+#include "hclib_system.h"
+#ifdef __CUDACC__
+#include "hclib_cuda.h"
+#endif
+#endif
+typedef struct _pragma3_omp_parallel {
+    int i;
+    int (*n_ptr);
+    float (*(*out_ptr));
+    const double (*(*in_ptr));
+    double (*s_ptr);
+ } pragma3_omp_parallel;
+
+static void pragma3_omp_parallel_hclib_async(void *____arg, const int ___iter0);
+void scale(int n, float *out, const double *in, double s) {
+    int i;
+ { 
+pragma3_omp_parallel *new_ctx = (pragma3_omp_parallel *)malloc(sizeof(pragma3_omp_parallel));
+new_ctx->i = i;
+new_ctx->n_ptr = &(n);
+new_ctx->out_ptr = &(out);
+new_ctx->in_ptr = &(in);
+new_ctx->s_ptr = &(s);
+hclib_loop_domain_t domain[1];
+domain[0].low = 0;
+domain[0].high = n;
+domain[0].stride = 1;
+domain[0].tile = -1;
+hclib_future_t *fut = hclib_forasync_future((void *)pragma3_omp_parallel_hclib_async, new_ctx, 1, domain, HCLIB_FORASYNC_MODE);
+hclib_future_wait(fut);
+free(new_ctx);
+ } 
+} 
+static void pragma3_omp_parallel_hclib_async(void *____arg, const int ___iter0) {
+    pragma3_omp_parallel *ctx = (pragma3_omp_parallel *)____arg;
+    int i; i = ctx->i;
+    const int n = *(ctx->n_ptr);
+    float *const out = *(ctx->out_ptr);
+    const double *const __restrict in = *(ctx->in_ptr);
+    const double s = *(ctx->s_ptr);
+    do {
+    i = ___iter0;
+{
+        out[i] = in[i] * s;
+    } ;     } while (0);
+}
+
+
@@ -0,0 +1,66 @@
+#include "hclib.h"
+#ifdef __cplusplus
+#include "hclib_cpp.h"
+#include "hclib_system.h"
+#ifdef __CUDACC__
+#include "hclib_cuda.h"
+#endif
+#endif
+typedef struct _pragma3_omp_parallel {
+    int i;
+    int (*n_ptr);
+    double (*(*a_ptr));
+ } pragma3_omp_parallel;
+
+#ifndef ____omp_seq_trips_DEFINED
+#define ____omp_seq_trips_DEFINED
+static inline long ____omp_seq_trips(const char *name, long estimate, long *cached) {
+    long trips = __atomic_load_n(cached, __ATOMIC_RELAXED);
+    if (trips < 0) {
+        const char *env = getenv(name);
+        trips = (env != NULL ? atol(env) : estimate);
+        __atomic_store_n(cached, trips, __ATOMIC_RELAXED);
+    }
+    return trips;
+}
+#endif
+#ifndef pragma3_omp_parallel_SEQ_TRIPS
+#define pragma3_omp_parallel_SEQ_TRIPS 1333
+#endif
+static long pragma3_omp_parallel_seq_trips = -1;
+static void pragma3_omp_parallel_hclib_async(void *____arg, const int ___iter0);
+void scale(int n, double *a) {
+    int i;
+ { const double ____seq_iters = (double)((n) > (0) ? ((n) - (0) + (1) - 1) / (1) : 0);
+if (____seq_iters < ____omp_seq_trips("OMP_TO_HCLIB_SEQ_TRIPS_pragma3_omp_parallel", pragma3_omp_parallel_SEQ_TRIPS, &pragma3_omp_parallel_seq_trips)) {
+for (i = 0; i < n; i++) {
+        a[i] = 2.0 * a[i];
+    }
+} else {
+
+pragma3_omp_parallel *new_ctx = (pragma3_omp_parallel *)malloc(sizeof(pragma3_omp_parallel));
+new_ctx->i = i;
+new_ctx->n_ptr = &(n);
+new_ctx->a_ptr = &(a);
+hclib_loop_domain_t domain[1];
+domain[0].low = 0;
+domain[0].high = n;
+domain[0].stride = 1;
+domain[0].tile = -1;
+hclib_future_t *fut = hclib_forasync_future((void *)pragma3_omp_parallel_hclib_async, new_ctx, 1, domain, HCLIB_FORASYNC_MODE);
+hclib_future_wait(fut);
+free(new_ctx);
+}
+ } 
+} 
+static void pragma3_omp_parallel_hclib_async(void *____arg, const int ___iter0) {
+    pragma3_omp_parallel *ctx = (pragma3_omp_parallel *)____arg;
+    int i; i = ctx->i;
+    do {
+    i = ___iter0;
+{
+        (*(ctx->a_ptr))[i] = 2.0 * (*(ctx->a_ptr))[i];
+    } ;     } while (0);
+}
+
+
@@ -0,0 +1,45 @@
+#include "hclib.h"
+#ifdef __cplusplus
+#include "hclib_cpp.h"
+#include "hclib_system.h"
+#ifdef __CUDACC__
+#include "hclib_cuda.h"
+#endif
+#endif
+typedef struct _pragma3_omp_task {
+    double (*s_ptr);
+    int (*n_ptr);
+    double (*(*a_ptr));
+    double (*(*total_ptr));
+ } pragma3_omp_task;
+
+static void pragma3_omp_task_hclib_async(void *____arg);
+void accumulate(int n, double *a, double *total) {
+    double s = 0.0;
+ { 
+pragma3_omp_task *new_ctx = (pragma3_omp_task *)malloc(sizeof(pragma3_omp_task));
+new_ctx->s_ptr = &(s);
+new_ctx->n_ptr = &(n);
+new_ctx->a_ptr = &(a);
+new_ctx->total_ptr = &(total);
+hclib_async(pragma3_omp_task_hclib_async, new_ctx, NO_FUTURE, ANY_PLACE);
+ } 
+ hclib_end_finish(); hclib_start_finish(); ;
+    *total = s;
+} 
+static void pragma3_omp_task_hclib_async(void *____arg) {
+    pragma3_omp_task *ctx = (pragma3_omp_task *)____arg;
+{
+ { double ____simd_s = (*(ctx->s_ptr)); double (*____simd_a) = (*(ctx->a_ptr)); { double s = ____simd_s; double (*a) = ____simd_a; 
+#if defined(__GNUC__) && !defined(__clang__) && !defined(_OPENMP) && !defined(OMP_TO_HCLIB_OPENMP_SIMD)
+#pragma GCC ivdep
+#else
+#pragma omp simd reduction(+:s) aligned(a:64)
+#endif
+for (int j = 0; j < (*(ctx->n_ptr)); j++) {
+            s += a[j];
+        } ; ____simd_s = s; } (*(ctx->s_ptr)) = ____simd_s; } 
+    } ;     free(____arg);
+}
+
+
@@ -0,0 +1,194 @@
+#include "hclib.h"
+#ifdef __cplusplus
+#include "hclib_cpp.h"
+#include "hclib_system.h"
+#ifdef __CUDACC__
+#include "hclib_cuda.h"
+#endif
+#endif
+#define A(m, n) (tiles[(m) * nt + (n)])
+
+#ifndef ____omp_tile_graph_DEFINED
+#define ____omp_tile_graph_DEFINED
+typedef struct ____omp_task_deps_t {
+    hclib_promise_t done;
+    int npreds;
+    int max_preds;
+    hclib_future_t **preds;
+    struct ____omp_task_deps_t *next;
+} ____omp_task_deps_t;
+typedef struct ____omp_tile_t {
+    hclib_future_t *writer;
+    int nreaders;
+    int max_readers;
+    hclib_future_t **readers;
+} ____omp_tile_t;
+typedef struct ____omp_tile_grid_t {
+    int rows;
+    int cols;
+    ____omp_tile_t *tiles;
+} ____omp_tile_grid_t;
+typedef struct ____omp_tile_graph_t {
+    ____omp_tile_grid_t *grids;
+    int ngrids;
+    ____omp_task_deps_t *tasks;
+} ____omp_tile_graph_t;
+static inline void ____omp_tile_graph_init(____omp_tile_graph_t *graph, int ngrids) {
+    graph->grids = (____omp_tile_grid_t *)calloc(ngrids, sizeof(____omp_tile_grid_t));
+    graph->ngrids = ngrids;
+    graph->tasks = NULL;
+}
+static inline void ____omp_future_append(hclib_future_t ***list, int *n, int *max, hclib_future_t *future) {
+    if (*n == *max) {
+        *max = (*max == 0 ? 4 : 2 * *max);
+        *list = (hclib_future_t **)realloc(*list, *max * sizeof(hclib_future_t *));
+    }
+    (*list)[(*n)++] = future;
+}
+static inline ____omp_tile_t *____omp_tile_lookup(____omp_tile_graph_t *graph, int grid, int row, int col) {
+    ____omp_tile_grid_t *g = &graph->grids[grid];
+    if (row >= g->rows || col >= g->cols) {
+        const int rows = (row < g->rows ? g->rows : (row + 1 > 2 * g->rows ? row + 1 : 2 * g->rows));
+        const int cols = (col < g->cols ? g->cols : (col + 1 > 2 * g->cols ? col + 1 : 2 * g->cols));
+        ____omp_tile_t *tiles = (____omp_tile_t *)calloc((size_t)rows * cols, sizeof(____omp_tile_t));
+        int r;
+        for (r = 0; r < g->rows; r++) {
+            memcpy(tiles + (size_t)r * cols, g->tiles + (size_t)r * g->cols, g->cols * sizeof(____omp_tile_t));
+        }
+        free(g->tiles);
+        g->tiles = tiles;
+        g->rows = rows;
+        g->cols = cols;
+    }
+    return &g->tiles[(size_t)row * g->cols + col];
+}
+static inline ____omp_task_deps_t *____omp_tile_task_create(____omp_tile_graph_t *graph) {
+    ____omp_task_deps_t *deps = (____omp_task_deps_t *)malloc(sizeof(____omp_task_deps_t));
+    hclib_promise_init(&deps->done);
+    deps->npreds = 0;
+    deps->max_preds = 0;
+    deps->preds = NULL;
+    deps->next = graph->tasks;
+    graph->tasks = deps;
+    return deps;
+}
+static inline void ____omp_tile_in(____omp_tile_graph_t *graph, int grid, int row, int col, ____omp_task_deps_t *deps) {
+    ____omp_tile_t *tile = ____omp_tile_lookup(graph, grid, row, col);
+    hclib_future_t *self = hclib_get_future_for_promise(&deps->done);
+    if (tile->writer != NULL && tile->writer != self) {
+        ____omp_future_append(&deps->preds, &deps->npreds, &deps->max_preds, tile->writer);
+    }
+    ____omp_future_append(&tile->readers, &tile->nreaders, &tile->max_readers, self);
+}
+static inline void ____omp_tile_out(____omp_tile_graph_t *graph, int grid, int row, int col, ____omp_task_deps_t *deps) {
+    ____omp_tile_t *tile = ____omp_tile_lookup(graph, grid, row, col);
+    hclib_future_t *self = hclib_get_future_for_promise(&deps->done);
+    int r;
+    if (tile->writer != NULL && tile->writer != self) {
+        ____omp_future_append(&deps->preds, &deps->npreds, &deps->max_preds, tile->writer);
+    }
+    for (r = 0; r < tile->nreaders; r++) {
+        if (tile->readers[r] != self) {
+            ____omp_future_append(&deps->preds, &deps->npreds, &deps->max_preds, tile->readers[r]);
+        }
+    }
+    tile->nreaders = 0;
+    tile->writer = self;
+}
+static inline hclib_future_t *____omp_tile_task_first(____omp_task_deps_t *deps) {
+    return (deps->npreds > 0 ? deps->preds[0] : NULL);
+}
+static inline void ____omp_tile_task_wait(____omp_task_deps_t *deps) {
+    int p;
+    for (p = 1; p < deps->npreds; p++) {
+        hclib_future_wait(deps->preds[p]);
+    }
+}
+static inline void ____omp_tile_task_done(____omp_task_deps_t *deps) {
+    hclib_promise_put(&deps->done, NULL);
+}
+static inline void ____omp_tile_graph_free(____omp_tile_graph_t *graph) {
+    int g;
+    for (g = 0; g < graph->ngrids; g++) {
+        size_t t;
+        for (t = 0; t < (size_t)graph->grids[g].rows * graph->grids[g].cols; t++) {
+            free(graph->grids[g].tiles[t].readers);
+        }
+        free(graph->grids[g].tiles);
+    }
+    free(graph->grids);
+    while (graph->tasks != NULL) {
+        ____omp_task_deps_t *next = graph->tasks->next;
+        free(graph->tasks->preds);
+        free(graph->tasks);
+        graph->tasks = next;
+    }
+}
+#endif
+typedef struct _pragma6_omp_task {
+    double (*(*akk_ptr));
+    double (*(*akn_ptr));
+    double (*(*(*tiles_ptr)));
+    int (*nt_ptr);
+    int (*k_ptr);
+    int (*n_ptr);
+    ____omp_task_deps_t *____deps;
+ } pragma6_omp_task;
+
+typedef struct _pragma8_omp_task {
+    double (*(*akk_ptr));
+    double (*(*akn_ptr));
+    double (*(*(*tiles_ptr)));
+    int (*nt_ptr);
+    int (*k_ptr);
+    int (*n_ptr);
+    ____omp_task_deps_t *____deps;
+ } pragma8_omp_task;
+
+static void pragma6_omp_task_hclib_async(void *____arg);
+static void pragma8_omp_task_hclib_async(void *____arg);
+void sweep(double **tiles, int nt, int k, int n) { ____omp_tile_graph_t ____tile_graph; ____omp_tile_graph_init(&____tile_graph, 1); hclib_start_finish(); 
+    double *akk = A(k, k);
+    double *akn = A(k, n);
+ { 
+pragma6_omp_task *new_ctx = (pragma6_omp_task *)malloc(sizeof(pragma6_omp_task));
+new_ctx->akk_ptr = &(akk);
+new_ctx->akn_ptr = &(akn);
+new_ctx->tiles_ptr = &(tiles);
+new_ctx->nt_ptr = &(nt);
+new_ctx->k_ptr = &(k);
+new_ctx->n_ptr = &(n);
+____omp_task_deps_t *____deps = ____omp_tile_task_create(&____tile_graph);
+____omp_tile_in(&____tile_graph, 0, k, k, ____deps);
+____omp_tile_out(&____tile_graph, 0, k, k, ____deps);
+new_ctx->____deps = ____deps;
+hclib_async(pragma6_omp_task_hclib_async, new_ctx, ____omp_tile_task_first(____deps), ANY_PLACE);
+ } ;
+ { 
+pragma8_omp_task *new_ctx = (pragma8_omp_task *)malloc(sizeof(pragma8_omp_task));
+new_ctx->akk_ptr = &(akk);
+new_ctx->akn_ptr = &(akn);
+new_ctx->tiles_ptr = &(tiles);
+new_ctx->nt_ptr = &(nt);
+new_ctx->k_ptr = &(k);
+new_ctx->n_ptr = &(n);
+____omp_task_deps_t *____deps = ____omp_tile_task_create(&____tile_graph);
+____omp_tile_in(&____tile_graph, 0, k, k, ____deps);
+____omp_tile_in(&____tile_graph, 0, k, n, ____deps);
+____omp_tile_out(&____tile_graph, 0, k, n, ____deps);
+new_ctx->____deps = ____deps;
+hclib_async(pragma8_omp_task_hclib_async, new_ctx, ____omp_tile_task_first(____deps), ANY_PLACE);
+ } ;
+ hclib_end_finish(); ____omp_tile_graph_free(&____tile_graph); } 
+static void pragma6_omp_task_hclib_async(void *____arg) {
+    pragma6_omp_task *ctx = (pragma6_omp_task *)____arg;
+{ ____omp_tile_task_wait(ctx->____deps); (*(ctx->akk_ptr))[0] = (*(ctx->akk_ptr))[0] * 2.0 ; ____omp_tile_task_done(ctx->____deps); } ;     free(____arg);
+}
+
+
+static void pragma8_omp_task_hclib_async(void *____arg) {
+    pragma8_omp_task *ctx = (pragma8_omp_task *)____arg;
+{ ____omp_tile_task_wait(ctx->____deps); (*(ctx->akn_ptr))[0] = (*(ctx->akn_ptr))[0] + (*(ctx->akk_ptr))[0] ; ____omp_tile_task_done(ctx->____deps); } ;     free(____arg);
+}
+
+
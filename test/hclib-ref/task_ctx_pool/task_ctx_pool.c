@@ -0,0 +1,86 @@
+#include "hclib.h"
+#ifdef __cplusplus
+#include "hclib_cpp.h"
+#include "hclib_system.h"
+#ifdef __CUDACC__
+#include "hclib_cuda.h"
+#endif
+#endif
+typedef struct _pragma2_omp_task {
+    int (*x);
+ } pragma2_omp_task;
+
+typedef struct _pragma2_omp_task_slot {
+    pragma2_omp_task ctx;
+    struct _pragma2_omp_task_slot *next;
+    int owner;
+ } pragma2_omp_task_slot;
+
+typedef struct _pragma2_omp_task_pool {
+    pragma2_omp_task_slot *local;
+    pragma2_omp_task_slot *remote;
+    char ____pad[64];
+ } pragma2_omp_task_pool;
+
+static pragma2_omp_task_pool *pragma2_omp_task_pools = NULL;
+
+static pragma2_omp_task_pool *pragma2_omp_task_get_pools() {
+    pragma2_omp_task_pool *pools = __atomic_load_n(&pragma2_omp_task_pools, __ATOMIC_ACQUIRE);
+    if (pools == NULL) {
+        pragma2_omp_task_pool *fresh = (pragma2_omp_task_pool *)calloc(hclib_get_num_workers(), sizeof(pragma2_omp_task_pool));
+        if (__atomic_compare_exchange_n(&pragma2_omp_task_pools, &pools, fresh, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            pools = fresh;
+        } else {
+            free(fresh);
+        }
+    }
+    return pools;
+}
+
+static pragma2_omp_task *pragma2_omp_task_alloc() {
+    const int worker = hclib_get_current_worker();
+    pragma2_omp_task_pool *pool = pragma2_omp_task_get_pools() + worker;
+    pragma2_omp_task_slot *slot = pool->local;
+    if (slot == NULL) {
+        slot = __atomic_exchange_n(&pool->remote, NULL, __ATOMIC_ACQUIRE);
+    }
+    if (slot == NULL) {
+        slot = (pragma2_omp_task_slot *)malloc(sizeof(pragma2_omp_task_slot));
+        slot->owner = worker;
+    } else {
+        pool->local = slot->next;
+    }
+    return &slot->ctx;
+}
+
+static void pragma2_omp_task_free(pragma2_omp_task *ctx) {
+    pragma2_omp_task_slot *slot = (pragma2_omp_task_slot *)ctx;
+    pragma2_omp_task_pool *pool = pragma2_omp_task_get_pools() + slot->owner;
+    if (slot->owner == hclib_get_current_worker()) {
+        slot->next = pool->local;
+        pool->local = slot;
+    } else {
+        pragma2_omp_task_slot *head = __atomic_load_n(&pool->remote, __ATOMIC_RELAXED);
+        do {
+            slot->next = head;
+        } while (!__atomic_compare_exchange_n(&pool->remote, &head, slot, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    }
+}
+
+static void pragma2_omp_task_hclib_async(void *____arg);
+void inc(int *x) {
+ { 
+pragma2_omp_task *new_ctx = pragma2_omp_task_alloc();
+new_ctx->x = x;
+hclib_async(pragma2_omp_task_hclib_async, new_ctx, NO_FUTURE, ANY_PLACE);
+ } 
+} 
+static void pragma2_omp_task_hclib_async(void *____arg) {
+    pragma2_omp_task *ctx = (pragma2_omp_task *)____arg;
+    int (*x); x = ctx->x;
+{
+        *x = *x + 1;
+    } ;     pragma2_omp_task_free(ctx);
+}
+
+
@@ -0,0 +1,104 @@
+#include "hclib.h"
+#ifdef __cplusplus
+#include "hclib_cpp.h"
+#include "hclib_system.h"
+#ifdef __CUDACC__
+#include "hclib_cuda.h"
+#endif
+#endif
+int fib____seq(int n);
+#ifndef ____task_depth_DEFINED
+#define ____task_depth_DEFINED
+__attribute__((weak)) __thread int ____task_depth = 0;
+#endif
+#ifndef ____task_depth_set_DEFINED
+#define ____task_depth_set_DEFINED
+static inline void ____task_depth_set(int depth) { ____task_depth = depth; }
+#endif
+#ifndef OMP_TO_HCLIB_TASK_CUTOFF_DEPTH
+#define OMP_TO_HCLIB_TASK_CUTOFF_DEPTH 10
+#endif
+#ifndef pragma4_omp_task_CUTOFF
+#define pragma4_omp_task_CUTOFF (____task_depth >= OMP_TO_HCLIB_TASK_CUTOFF_DEPTH)
+#endif
+typedef struct _pragma4_omp_task {
+    int (*x_ptr);
+    int (*y_ptr);
+    int (*n_ptr);
+    int ____depth;
+ } pragma4_omp_task;
+
+#ifndef OMP_TO_HCLIB_TASK_CUTOFF_DEPTH
+#define OMP_TO_HCLIB_TASK_CUTOFF_DEPTH 10
+#endif
+#ifndef pragma6_omp_task_CUTOFF
+#define pragma6_omp_task_CUTOFF (____task_depth >= OMP_TO_HCLIB_TASK_CUTOFF_DEPTH)
+#endif
+typedef struct _pragma6_omp_task {
+    int (*x_ptr);
+    int (*y_ptr);
+    int (*n_ptr);
+    int ____depth;
+ } pragma6_omp_task;
+
+static void pragma4_omp_task_hclib_async(void *____arg);
+static void pragma6_omp_task_hclib_async(void *____arg);
+int fib(int n) {
+    int x, y;
+    if (n < 2) return n;
+ { 
+if (pragma4_omp_task_CUTOFF) {
+x = fib____seq(n - 1);
+} else {
+pragma4_omp_task *new_ctx = (pragma4_omp_task *)malloc(sizeof(pragma4_omp_task));
+new_ctx->x_ptr = &(x);
+new_ctx->y_ptr = &(y);
+new_ctx->n_ptr = &(n);
+new_ctx->____depth = ____task_depth + 1;
+hclib_async(pragma4_omp_task_hclib_async, new_ctx, NO_FUTURE, ANY_PLACE);
+}
+ } ;
+ { 
+if (pragma6_omp_task_CUTOFF) {
+y = fib____seq(n - 2);
+} else {
+pragma6_omp_task *new_ctx = (pragma6_omp_task *)malloc(sizeof(pragma6_omp_task));
+new_ctx->x_ptr = &(x);
+new_ctx->y_ptr = &(y);
+new_ctx->n_ptr = &(n);
+new_ctx->____depth = ____task_depth + 1;
+hclib_async(pragma6_omp_task_hclib_async, new_ctx, NO_FUTURE, ANY_PLACE);
+}
+ } ;
+ { const int ____resume_depth = ____task_depth;  hclib_end_finish(); hclib_start_finish(); ____task_depth_set(____resume_depth); } ;
+    return x + y;
+} 
+static void pragma4_omp_task_hclib_async(void *____arg) {
+    pragma4_omp_task *ctx = (pragma4_omp_task *)____arg;
+    hclib_start_finish();
+{ const int ____entry_depth = ____task_depth; ____task_depth = ctx->____depth; { const int ____task_depth = ctx->____depth; (*(ctx->x_ptr)) = fib((*(ctx->n_ptr)) - 1) ; } ____task_depth = ____entry_depth; } ;     ; hclib_end_finish_nonblocking();
+
+    free(____arg);
+}
+
+
+static void pragma6_omp_task_hclib_async(void *____arg) {
+    pragma6_omp_task *ctx = (pragma6_omp_task *)____arg;
+    hclib_start_finish();
+{ const int ____entry_depth = ____task_depth; ____task_depth = ctx->____depth; { const int ____task_depth = ctx->____depth; (*(ctx->y_ptr)) = fib((*(ctx->n_ptr)) - 2) ; } ____task_depth = ____entry_depth; } ;     ; hclib_end_finish_nonblocking();
+
+    free(____arg);
+}
+
+
+
+int fib____seq(int n) {
+    int x, y;
+    if (n < 2) return n;
+ { x = fib____seq(n - 1);
+ } ;
+ { y = fib____seq(n - 2);
+ } ;
+;
+    return x + y;
+}
@@ -0,0 +1,122 @@
+#include "hclib.h"
+#ifdef __cplusplus
+#include "hclib_cpp.h"
+#include "hclib_system.h"
+#ifdef __CUDACC__
+#include "hclib_cuda.h"
+#endif
+#endif
+typedef struct _pragma3_omp_taskloop {
+    int i;
+    int (*n_ptr);
+    int (*(*a_ptr));
+    int (*(*b_ptr));
+    int (*(*c_ptr));
+ } pragma3_omp_taskloop;
+
+typedef struct _pragma7_omp_taskloop {
+    int i;
+    int (*n_ptr);
+    int (*(*a_ptr));
+    int (*(*b_ptr));
+    int (*(*c_ptr));
+ } pragma7_omp_taskloop;
+
+typedef struct _pragma11_omp_taskloop {
+    int i;
+    int n;
+    int (*a);
+    int (*b);
+    int (*c);
+ } pragma11_omp_taskloop;
+
+static void pragma3_omp_taskloop_hclib_async(void *____arg, const int ___iter0);
+static void pragma7_omp_taskloop_hclib_async(void *____arg, const int ___iter0);
+static void pragma11_omp_taskloop_hclib_async(void *____arg, const int ___iter0);
+void fill(int n, int *a, int *b, int *c) {
+    int i;
+ { 
+pragma3_omp_taskloop *new_ctx = (pragma3_omp_taskloop *)malloc(sizeof(pragma3_omp_taskloop));
+new_ctx->i = i;
+new_ctx->n_ptr = &(n);
+new_ctx->a_ptr = &(a);
+new_ctx->b_ptr = &(b);
+new_ctx->c_ptr = &(c);
+hclib_loop_domain_t domain[1];
+domain[0].low = 0;
+domain[0].high = n;
+domain[0].stride = 1;
+domain[0].tile = (64);
+hclib_future_t *fut = hclib_forasync_future((void *)pragma3_omp_taskloop_hclib_async, new_ctx, 1, domain, FORASYNC_MODE_FLAT);
+hclib_future_wait(fut);
+free(new_ctx);
+ } 
+ { 
+pragma7_omp_taskloop *new_ctx = (pragma7_omp_taskloop *)malloc(sizeof(pragma7_omp_taskloop));
+new_ctx->i = i;
+new_ctx->n_ptr = &(n);
+new_ctx->a_ptr = &(a);
+new_ctx->b_ptr = &(b);
+new_ctx->c_ptr = &(c);
+hclib_loop_domain_t domain[1];
+domain[0].low = 0;
+domain[0].high = n;
+domain[0].stride = 1;
+domain[0].tile = (((n) - (0)) > 0 ? 1 + (((n) - (0)) - 1) / (8) : 1);
+hclib_future_t *fut = hclib_forasync_future((void *)pragma7_omp_taskloop_hclib_async, new_ctx, 1, domain, FORASYNC_MODE_FLAT);
+hclib_future_wait(fut);
+free(new_ctx);
+ } 
+ { 
+pragma11_omp_taskloop *new_ctx = (pragma11_omp_taskloop *)malloc(sizeof(pragma11_omp_taskloop));
+new_ctx->i = i;
+new_ctx->n = n;
+new_ctx->a = a;
+new_ctx->b = b;
+new_ctx->c = c;
+hclib_loop_domain_t domain[1];
+domain[0].low = 0;
+domain[0].high = n;
+domain[0].stride = 1;
+domain[0].tile = -1;
+hclib_future_t *fut = hclib_forasync_future((void *)pragma11_omp_taskloop_hclib_async, new_ctx, 1, domain, HCLIB_FORASYNC_MODE);
+hclib_async(free, new_ctx, fut, ANY_PLACE);
+ } 
+} 
+static void pragma3_omp_taskloop_hclib_async(void *____arg, const int ___iter0) {
+    pragma3_omp_taskloop *ctx = (pragma3_omp_taskloop *)____arg;
+    int i; i = ctx->i;
+    do {
+    i = ___iter0;
+{
+        (*(ctx->a_ptr))[i] = i;
+    } ;     } while (0);
+}
+
+
+static void pragma7_omp_taskloop_hclib_async(void *____arg, const int ___iter0) {
+    pragma7_omp_taskloop *ctx = (pragma7_omp_taskloop *)____arg;
+    int i; i = ctx->i;
+    do {
+    i = ___iter0;
+{
+        (*(ctx->b_ptr))[i] = (*(ctx->a_ptr))[i];
+    } ;     } while (0);
+}
+
+
+static void pragma11_omp_taskloop_hclib_async(void *____arg, const int ___iter0) {
+    pragma11_omp_taskloop *ctx = (pragma11_omp_taskloop *)____arg;
+    int i; i = ctx->i;
+    int n; n = ctx->n;
+    int (*a); a = ctx->a;
+    int (*b); b = ctx->b;
+    int (*c); c = ctx->c;
+    do {
+    i = ___iter0;
+{
+        c[i] = b[i];
+    } ;     } while (0);
+}
+
+
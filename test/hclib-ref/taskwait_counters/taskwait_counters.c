@@ -0,0 +1,100 @@
+#include "hclib.h"
+#ifdef __cplusplus
+#include "hclib_cpp.h"
+#include "hclib_system.h"
+#ifdef __CUDACC__
+#include "hclib_cuda.h"
+#endif
+#endif
+typedef struct _pragma4_omp_task {
+    int (*____pending_children_root_ptr);
+    int (*x_ptr);
+    int (*y_ptr);
+    int (*n_ptr);
+ } pragma4_omp_task;
+
+typedef struct _pragma6_omp_task {
+    int (*____pending_children_root_ptr);
+    int (*x_ptr);
+    int (*y_ptr);
+    int (*n_ptr);
+ } pragma6_omp_task;
+
+static void pragma4_omp_task_hclib_async(void *____arg);
+static void pragma6_omp_task_hclib_async(void *____arg);
+int fib(int n) { int ____pending_children_root = 0; 
+    int x, y;
+    if (n < 2) return n;
+ { 
+pragma4_omp_task *new_ctx = (pragma4_omp_task *)malloc(sizeof(pragma4_omp_task));
+new_ctx->____pending_children_root_ptr = &(____pending_children_root);
+new_ctx->x_ptr = &(x);
+new_ctx->y_ptr = &(y);
+new_ctx->n_ptr = &(n);
+__atomic_fetch_add(&____pending_children_root, 1, __ATOMIC_RELAXED);
+hclib_async(pragma4_omp_task_hclib_async, new_ctx, NO_FUTURE, ANY_PLACE);
+ } ;
+ { 
+pragma6_omp_task *new_ctx = (pragma6_omp_task *)malloc(sizeof(pragma6_omp_task));
+new_ctx->____pending_children_root_ptr = &(____pending_children_root);
+new_ctx->x_ptr = &(x);
+new_ctx->y_ptr = &(y);
+new_ctx->n_ptr = &(n);
+__atomic_fetch_add(&____pending_children_root, 1, __ATOMIC_RELAXED);
+hclib_async(pragma6_omp_task_hclib_async, new_ctx, NO_FUTURE, ANY_PLACE);
+ } ;
+ while (__atomic_load_n(&____pending_children_root, __ATOMIC_ACQUIRE) > 0) { hclib_yield(NULL); } ;
+    return x + y;
+} 
+static void pragma4_omp_task_hclib_async(void *____arg) {
+    pragma4_omp_task *ctx = (pragma4_omp_task *)____arg;
+(*(ctx->x_ptr)) = fib((*(ctx->n_ptr)) - 1) ;     __atomic_fetch_sub(ctx->____pending_children_root_ptr, 1, __ATOMIC_RELEASE);
+    free(____arg);
+}
+
+
+static void pragma6_omp_task_hclib_async(void *____arg) {
+    pragma6_omp_task *ctx = (pragma6_omp_task *)____arg;
+(*(ctx->y_ptr)) = fib((*(ctx->n_ptr)) - 2) ;     __atomic_fetch_sub(ctx->____pending_children_root_ptr, 1, __ATOMIC_RELEASE);
+    free(____arg);
+}
+
+
+
+typedef struct _pragma13_omp_task {
+    int (*a);
+ } pragma13_omp_task;
+
+typedef struct _pragma16_omp_task {
+    int (*a);
+ } pragma16_omp_task;
+
+static void pragma13_omp_task_hclib_async(void *____arg);
+static void pragma16_omp_task_hclib_async(void *____arg);
+void set_twice(int *a) {
+ { 
+pragma13_omp_task *new_ctx = (pragma13_omp_task *)malloc(sizeof(pragma13_omp_task));
+new_ctx->a = a;
+hclib_async(pragma13_omp_task_hclib_async, new_ctx, NO_FUTURE, ANY_PLACE);
+ } ;
+ hclib_end_finish(); hclib_start_finish(); ;
+ { 
+pragma16_omp_task *new_ctx = (pragma16_omp_task *)malloc(sizeof(pragma16_omp_task));
+new_ctx->a = a;
+hclib_async(pragma16_omp_task_hclib_async, new_ctx, NO_FUTURE, ANY_PLACE);
+ } ;
+} 
+static void pragma13_omp_task_hclib_async(void *____arg) {
+    pragma13_omp_task *ctx = (pragma13_omp_task *)____arg;
+    int (*a); a = ctx->a;
+*a = 1 ;     free(____arg);
+}
+
+
+static void pragma16_omp_task_hclib_async(void *____arg) {
+    pragma16_omp_task *ctx = (pragma16_omp_task *)____arg;
+    int (*a); a = ctx->a;
+*a = 2 ;     free(____arg);
+}
+
+
@@ -0,0 +1,94 @@
+#include "hclib.h"
+#ifdef __cplusplus
+#include "hclib_cpp.h"
+#include "hclib_system.h"
+#ifdef __CUDACC__
+#include "hclib_cuda.h"
+#endif
+#endif
+int omp_get_thread_num(void);
+int omp_get_num_threads(void);
+
+#ifndef ____omp_team_DEFINED
+#define ____omp_team_DEFINED
+typedef struct ____omp_team_t {
+    int nthreads;
+    int next_thread_num;
+    int arrived;
+    int episode;
+    int lock;
+    hclib_promise_t release[2];
+} ____omp_team_t;
+static inline void ____omp_team_init(____omp_team_t *team, int nthreads) {
+    team->nthreads = (nthreads > 0 ? nthreads : 1);
+    team->next_thread_num = 0;
+    team->arrived = 0;
+    team->episode = 0;
+    team->lock = 0;
+    hclib_promise_init(&team->release[0]);
+}
+static inline int ____omp_team_join(____omp_team_t *team) {
+    return __atomic_fetch_add(&team->next_thread_num, 1, __ATOMIC_RELAXED);
+}
+static inline int ____omp_team_size(____omp_team_t *team) {
+    return (team == NULL ? 1 : team->nthreads);
+}
+static inline void ____omp_team_lock(____omp_team_t *team) {
+    if (team == NULL) return;
+    while (__atomic_exchange_n(&team->lock, 1, __ATOMIC_ACQUIRE)) { }
+}
+static inline void ____omp_team_unlock(____omp_team_t *team) {
+    if (team == NULL) return;
+    __atomic_store_n(&team->lock, 0, __ATOMIC_RELEASE);
+}
+static inline void ____omp_team_barrier(____omp_team_t *team) {
+    if (____omp_team_size(team) == 1) return;
+    const int episode = __atomic_load_n(&team->episode, __ATOMIC_ACQUIRE);
+    hclib_promise_t *release = &team->release[episode & 1];
+    if (__atomic_add_fetch(&team->arrived, 1, __ATOMIC_ACQ_REL) == team->nthreads) {
+        __atomic_store_n(&team->arrived, 0, __ATOMIC_RELAXED);
+        hclib_promise_init(&team->release[(episode + 1) & 1]);
+        __atomic_store_n(&team->episode, episode + 1, __ATOMIC_RELEASE);
+        hclib_promise_put(release, NULL);
+    } else {
+        hclib_future_wait(hclib_get_future_for_promise(release));
+    }
+}
+static inline int ____omp_team_static_chunk(____omp_team_t *team, long chunk, long niters, long chunk_size, long *begin, long *end) {
+    if (chunk_size <= 0) {
+        const long nthreads = ____omp_team_size(team);
+        chunk_size = (niters + nthreads - 1) / nthreads;
+    }
+    if (chunk_size <= 0 || chunk >= (niters + chunk_size - 1) / chunk_size) return 0;
+    *begin = chunk * chunk_size;
+    *end = (*begin + chunk_size < niters ? *begin + chunk_size : niters);
+    return 1;
+}
+#endif
+typedef struct _pragma5_omp_parallel {
+    int (*(*sizes_ptr));
+    ____omp_team_t ____team;
+ } pragma5_omp_parallel;
+
+static void pragma5_omp_parallel_hclib_async(void *____arg);
+void count(int *sizes) {
+ { 
+pragma5_omp_parallel *new_ctx = (pragma5_omp_parallel *)malloc(sizeof(pragma5_omp_parallel));
+new_ctx->sizes_ptr = &(sizes);
+____omp_team_init(&new_ctx->____team, hclib_get_num_workers());
+hclib_start_finish();
+int ____thread;
+for (____thread = 0; ____thread < new_ctx->____team.nthreads; ____thread++) {
+    hclib_async(pragma5_omp_parallel_hclib_async, new_ctx, NO_FUTURE, ANY_PLACE);
+}
+hclib_end_finish();
+free(new_ctx);
+ } 
+} 
+static void pragma5_omp_parallel_hclib_async(void *____arg) {
+    pragma5_omp_parallel *ctx = (pragma5_omp_parallel *)____arg;
+{ ____omp_team_t *____team = &(ctx->____team); const int ____thread_num = ____omp_team_join(____team); {
+        (*(ctx->sizes_ptr))[____thread_num] = ____omp_team_size(____team);
+    } ; } ; }
+
+
@@ -0,0 +1,184 @@
+#include "hclib.h"
+#ifdef __cplusplus
+#include "hclib_cpp.h"
+#include "hclib_system.h"
+#ifdef __CUDACC__
+#include "hclib_cuda.h"
+#endif
+#endif
+typedef struct _pragma6_omp_parallel_tb_shrink {
+    const int (*____tb_nsteps_ptr);
+    const int (*____tb_steps_ptr);
+    const int (*____tb_low_ptr);
+    const int (*____tb_n_ptr);
+    double (*(*____tb_in_ptr));
+    double (*(*____tb_out_ptr));
+    int (*____tb_width_ptr);
+    const int (*____tb_ntiles_ptr);
+    int (*____tb_block_ptr);
+    int (*____tb_t_ptr);
+    int (*t_ptr);
+    int i;
+    double (*(*tmp_ptr));
+    int (*n_ptr);
+    int (*steps_ptr);
+    double (*(*a_ptr));
+    double (*(*b_ptr));
+ } pragma6_omp_parallel_tb_shrink;
+
+typedef struct _pragma6_omp_parallel_tb_grow {
+    const int (*____tb_nsteps_ptr);
+    const int (*____tb_steps_ptr);
+    const int (*____tb_low_ptr);
+    const int (*____tb_n_ptr);
+    double (*(*____tb_in_ptr));
+    double (*(*____tb_out_ptr));
+    int (*____tb_width_ptr);
+    const int (*____tb_ntiles_ptr);
+    int (*____tb_block_ptr);
+    int (*____tb_t_ptr);
+    int (*t_ptr);
+    int i;
+    double (*(*tmp_ptr));
+    int (*n_ptr);
+    int (*steps_ptr);
+    double (*(*a_ptr));
+    double (*(*b_ptr));
+ } pragma6_omp_parallel_tb_grow;
+
+static void pragma6_omp_parallel_tb_shrink_hclib_async(void *____arg, const int ___iter0);
+static void pragma6_omp_parallel_tb_grow_hclib_async(void *____arg, const int ___iter0);
+void jacobi(int n, int steps, double *a, double *b) {
+    int t;
+    int i;
+    double *tmp;
+    {
+t = 0 ;
+const int ____tb_steps = ((t < steps) ? (steps) - t : 0);
+const int ____tb_low = 1;
+const int ____tb_n = (n - 1) - ____tb_low;
+double (*____tb_in) = a;
+double (*____tb_out) = b;
+int ____tb_width = (256 * 1024) / (2 * (int)sizeof(____tb_out[0]));
+if (____tb_width > ____tb_n / hclib_get_num_workers()) ____tb_width = ____tb_n / hclib_get_num_workers();
+if (____tb_width < 1) ____tb_width = 1;
+const int ____tb_ntiles = (____tb_n > ____tb_width ? ____tb_n / ____tb_width : 1);
+int ____tb_block = 8;
+if (____tb_block > ____tb_width / (2 * 1)) ____tb_block = ____tb_width / (2 * 1);
+if (____tb_block < 1) ____tb_block = 1;
+int ____tb_t;
+for (____tb_t = 0; ____tb_t < ____tb_steps; ____tb_t += ____tb_block) {
+const int ____tb_nsteps = (____tb_steps - ____tb_t < ____tb_block ? ____tb_steps - ____tb_t : ____tb_block);
+ { 
+pragma6_omp_parallel_tb_shrink *new_ctx = (pragma6_omp_parallel_tb_shrink *)malloc(sizeof(pragma6_omp_parallel_tb_shrink));
+new_ctx->____tb_nsteps_ptr = &(____tb_nsteps);
+new_ctx->____tb_steps_ptr = &(____tb_steps);
+new_ctx->____tb_low_ptr = &(____tb_low);
+new_ctx->____tb_n_ptr = &(____tb_n);
+new_ctx->____tb_in_ptr = &(____tb_in);
+new_ctx->____tb_out_ptr = &(____tb_out);
+new_ctx->____tb_width_ptr = &(____tb_width);
+new_ctx->____tb_ntiles_ptr = &(____tb_ntiles);
+new_ctx->____tb_block_ptr = &(____tb_block);
+new_ctx->____tb_t_ptr = &(____tb_t);
+new_ctx->t_ptr = &(t);
+new_ctx->i = i;
+new_ctx->tmp_ptr = &(tmp);
+new_ctx->n_ptr = &(n);
+new_ctx->steps_ptr = &(steps);
+new_ctx->a_ptr = &(a);
+new_ctx->b_ptr = &(b);
+hclib_loop_domain_t domain[1];
+domain[0].low = 0;
+domain[0].high = ____tb_ntiles;
+domain[0].stride = 1;
+domain[0].tile = -1;
+hclib_future_t *fut = hclib_forasync_future((void *)pragma6_omp_parallel_tb_shrink_hclib_async, new_ctx, 1, domain, HCLIB_FORASYNC_MODE);
+hclib_future_wait(fut);
+free(new_ctx);
+ } 
+ { 
+pragma6_omp_parallel_tb_grow *new_ctx = (pragma6_omp_parallel_tb_grow *)malloc(sizeof(pragma6_omp_parallel_tb_grow));
+new_ctx->____tb_nsteps_ptr = &(____tb_nsteps);
+new_ctx->____tb_steps_ptr = &(____tb_steps);
+new_ctx->____tb_low_ptr = &(____tb_low);
+new_ctx->____tb_n_ptr = &(____tb_n);
+new_ctx->____tb_in_ptr = &(____tb_in);
+new_ctx->____tb_out_ptr = &(____tb_out);
+new_ctx->____tb_width_ptr = &(____tb_width);
+new_ctx->____tb_ntiles_ptr = &(____tb_ntiles);
+new_ctx->____tb_block_ptr = &(____tb_block);
+new_ctx->____tb_t_ptr = &(____tb_t);
+new_ctx->t_ptr = &(t);
+new_ctx->i = i;
+new_ctx->tmp_ptr = &(tmp);
+new_ctx->n_ptr = &(n);
+new_ctx->steps_ptr = &(steps);
+new_ctx->a_ptr = &(a);
+new_ctx->b_ptr = &(b);
+hclib_loop_domain_t domain[1];
+domain[0].low = 1;
+domain[0].high = ____tb_ntiles;
+domain[0].stride = 1;
+domain[0].tile = -1;
+hclib_future_t *fut = hclib_forasync_future((void *)pragma6_omp_parallel_tb_grow_hclib_async, new_ctx, 1, domain, HCLIB_FORASYNC_MODE);
+hclib_future_wait(fut);
+free(new_ctx);
+ } 
+}
+if (____tb_steps > 0) {
+if (____tb_steps % 2 == 0) {
+tmp = a ;
+a = b ;
+b = tmp ;
+}
+{
+tmp = a ;
+a = b ;
+b = tmp ;
+}
+}
+t += ____tb_steps;
+}
+
+} 
+static void pragma6_omp_parallel_tb_shrink_hclib_async(void *____arg, const int ___iter0) {
+    pragma6_omp_parallel_tb_shrink *ctx = (pragma6_omp_parallel_tb_shrink *)____arg;
+    int i; i = ctx->i;
+    do {
+    int ____tb_tile;     ____tb_tile = ___iter0;
+{
+int ____tb_s;
+for (____tb_s = 0; ____tb_s < (*(ctx->____tb_nsteps_ptr)); ____tb_s++) {
+const int ____tb_from = (*(ctx->____tb_low_ptr)) + ____tb_tile * (*(ctx->____tb_width_ptr)) + (____tb_tile == 0 ? 0 : ____tb_s * 1);
+const int ____tb_to = (____tb_tile == (*(ctx->____tb_ntiles_ptr)) - 1 ? (*(ctx->____tb_low_ptr)) + (*(ctx->____tb_n_ptr)) : (*(ctx->____tb_low_ptr)) + (____tb_tile + 1) * (*(ctx->____tb_width_ptr)) - ____tb_s * 1);
+double (*a) = ((((*(ctx->____tb_t_ptr)) + ____tb_s) % 2 == 0) ? (*(ctx->____tb_in_ptr)) : (*(ctx->____tb_out_ptr)));
+double (*b) = ((((*(ctx->____tb_t_ptr)) + ____tb_s) % 2 == 0) ? (*(ctx->____tb_out_ptr)) : (*(ctx->____tb_in_ptr)));
+for (i = ____tb_from; i < ____tb_to; i++) {
+            b[i] = (a[i - 1] + a[i] + a[i + 1]) / 3.0;
+        }
+}
+} ;     } while (0);
+}
+
+
+static void pragma6_omp_parallel_tb_grow_hclib_async(void *____arg, const int ___iter0) {
+    pragma6_omp_parallel_tb_grow *ctx = (pragma6_omp_parallel_tb_grow *)____arg;
+    int i; i = ctx->i;
+    do {
+    int ____tb_tile;     ____tb_tile = ___iter0;
+{
+int ____tb_s;
+for (____tb_s = 1; ____tb_s < (*(ctx->____tb_nsteps_ptr)); ____tb_s++) {
+const int ____tb_from = (*(ctx->____tb_low_ptr)) + ____tb_tile * (*(ctx->____tb_width_ptr)) - ____tb_s * 1;
+const int ____tb_to = (*(ctx->____tb_low_ptr)) + ____tb_tile * (*(ctx->____tb_width_ptr)) + ____tb_s * 1;
+double (*a) = ((((*(ctx->____tb_t_ptr)) + ____tb_s) % 2 == 0) ? (*(ctx->____tb_in_ptr)) : (*(ctx->____tb_out_ptr)));
+double (*b) = ((((*(ctx->____tb_t_ptr)) + ____tb_s) % 2 == 0) ? (*(ctx->____tb_out_ptr)) : (*(ctx->____tb_in_ptr)));
+for (i = ____tb_from; i < ____tb_to; i++) {
+            b[i] = (a[i - 1] + a[i] + a[i + 1]) / 3.0;
+        }
+}
+} ;     } while (0);
+}
+
+
@@ -0,0 +1,115 @@
+#include "hclib.h"
+#ifdef __cplusplus
+#include "hclib_cpp.h"
+#include "hclib_system.h"
+#ifdef __CUDACC__
+#include "hclib_cuda.h"
+#endif
+#endif
+typedef struct _pragma5_omp_parallel_wavefront {
+    hclib_future_t (*(*____wf_first_ptr));
+    hclib_future_t (*____wf_second);
+    int (*____wf_nsteps_ptr);
+    int (*____wf_lo);
+    int (*____wf_hi);
+    int ____wf_step;
+    int ____wf_xmin;
+    int (*____wf_xmax_ptr);
+    int (*____wf_any_ptr);
+    int ____wf_width;
+    hclib_promise_t (*____wf_done);
+    unsigned long (*____wf_b_ptr);
+    int d;
+    int x;
+    int (*nb_ptr);
+    double (*(*m_ptr));
+ } pragma5_omp_parallel_wavefront;
+
+static void pragma5_omp_parallel_wavefront_hclib_async(void *____arg);
+void sweep(int nb, double *m) {
+    int d;
+    int x;
+    {
+int ____wf_nsteps = 0;
+{ for (d = 0; d < nb; d++) { ____wf_nsteps++; } }
+int *____wf_lo = (int *)malloc((____wf_nsteps + 1) * sizeof(int));
+int *____wf_hi = (int *)malloc((____wf_nsteps + 1) * sizeof(int));
+int ____wf_step = 0;
+int ____wf_xmin = 0;
+int ____wf_xmax = 0;
+int ____wf_any = 0;
+{ for (d = 0; d < nb; d++) {
+____wf_lo[____wf_step] = 0;
+____wf_hi[____wf_step] = (d) + 1;
+if (____wf_lo[____wf_step] < ____wf_hi[____wf_step]) {
+if (!____wf_any || ____wf_lo[____wf_step] < ____wf_xmin) ____wf_xmin = ____wf_lo[____wf_step];
+if (!____wf_any || ____wf_hi[____wf_step] > ____wf_xmax) ____wf_xmax = ____wf_hi[____wf_step];
+____wf_any = 1;
+}
+____wf_step++;
+} }
+int ____wf_width = ____wf_xmax - ____wf_xmin;
+hclib_promise_t *____wf_done = (hclib_promise_t *)malloc(((size_t)____wf_nsteps * ____wf_width + 1) * sizeof(hclib_promise_t));
+size_t ____wf_b;
+for (____wf_b = 0; ____wf_b < (size_t)____wf_nsteps * ____wf_width; ____wf_b++) hclib_promise_init(&____wf_done[____wf_b]);
+hclib_start_finish();
+____wf_step = 0;
+for (d = 0; d < nb; d++) {
+for (x = ____wf_lo[____wf_step]; x < ____wf_hi[____wf_step]; x++) {
+hclib_future_t *____wf_first = NULL;
+hclib_future_t *____wf_second = NULL;
+if (____wf_step > 0 && x >= ____wf_lo[____wf_step - 1] && x < ____wf_hi[____wf_step - 1]) ____wf_first = hclib_get_future_for_promise(&____wf_done[(size_t)(____wf_step - 1) * ____wf_width + x - ____wf_xmin]);
+if (____wf_step > 0 && x - 1 >= ____wf_lo[____wf_step - 1] && x - 1 < ____wf_hi[____wf_step - 1]) { if (____wf_first == NULL) ____wf_first = hclib_get_future_for_promise(&____wf_done[(size_t)(____wf_step - 1) * ____wf_width + x - 1 - ____wf_xmin]); else ____wf_second = hclib_get_future_for_promise(&____wf_done[(size_t)(____wf_step - 1) * ____wf_width + x - 1 - ____wf_xmin]); }
+if (____wf_first == NULL && ____wf_step > 1 && x - 1 >= ____wf_lo[____wf_step - 2] && x - 1 < ____wf_hi[____wf_step - 2]) ____wf_first = hclib_get_future_for_promise(&____wf_done[(size_t)(____wf_step - 2) * ____wf_width + x - 1 - ____wf_xmin]);
+ { 
+pragma5_omp_parallel_wavefront *new_ctx = (pragma5_omp_parallel_wavefront *)malloc(sizeof(pragma5_omp_parallel_wavefront));
+new_ctx->____wf_first_ptr = &(____wf_first);
+new_ctx->____wf_second = ____wf_second;
+new_ctx->____wf_nsteps_ptr = &(____wf_nsteps);
+new_ctx->____wf_lo = ____wf_lo;
+new_ctx->____wf_hi = ____wf_hi;
+new_ctx->____wf_step = ____wf_step;
+new_ctx->____wf_xmin = ____wf_xmin;
+new_ctx->____wf_xmax_ptr = &(____wf_xmax);
+new_ctx->____wf_any_ptr = &(____wf_any);
+new_ctx->____wf_width = ____wf_width;
+new_ctx->____wf_done = ____wf_done;
+new_ctx->____wf_b_ptr = &(____wf_b);
+new_ctx->d = d;
+new_ctx->x = x;
+new_ctx->nb_ptr = &(nb);
+new_ctx->m_ptr = &(m);
+hclib_async(pragma5_omp_parallel_wavefront_hclib_async, new_ctx, ____wf_first, ANY_PLACE);
+ } 
+}
+____wf_step++;
+}
+hclib_end_finish();
+free(____wf_done);
+free(____wf_lo);
+free(____wf_hi);
+}
+
+} 
+static void pragma5_omp_parallel_wavefront_hclib_async(void *____arg) {
+    pragma5_omp_parallel_wavefront *ctx = (pragma5_omp_parallel_wavefront *)____arg;
+    hclib_future_t (*____wf_second); ____wf_second = ctx->____wf_second;
+    int (*____wf_lo); ____wf_lo = ctx->____wf_lo;
+    int (*____wf_hi); ____wf_hi = ctx->____wf_hi;
+    int ____wf_step; ____wf_step = ctx->____wf_step;
+    int ____wf_xmin; ____wf_xmin = ctx->____wf_xmin;
+    int ____wf_width; ____wf_width = ctx->____wf_width;
+    hclib_promise_t (*____wf_done); ____wf_done = ctx->____wf_done;
+    int d; d = ctx->d;
+    int x; x = ctx->x;
+{
+if (____wf_second != NULL) hclib_future_wait(____wf_second);
+{
+            int y = d - x;
+            (*(ctx->m_ptr))[y * (*(ctx->nb_ptr)) + x] = (*(ctx->m_ptr))[y * (*(ctx->nb_ptr)) + x] + 1.0;
+        } ;
+hclib_promise_put(&____wf_done[(size_t)____wf_step * ____wf_width + x - ____wf_xmin], NULL);
+} ;     free(____arg);
+}
+
+
@@ -0,0 +1,57 @@
+#include "hclib.h"
+#ifdef __cplusplus
+#include "hclib_cpp.h"
+#include "hclib_system.h"
+#ifdef __CUDACC__
+#include "hclib_cuda.h"
+#endif
+#endif
+typedef struct _pragma3_omp_parallel {
+    long i;
+    long (*n_ptr);
+    double (*(*a_ptr));
+    double (*s_ptr);
+    long ____base0;
+    long ____step0;
+    long ____left0;
+ } pragma3_omp_parallel;
+
+static void pragma3_omp_parallel_hclib_async(void *____arg, const int ___iter0);
+void scale(long n, double *a, double s) {
+    long i;
+ { 
+pragma3_omp_parallel *new_ctx = (pragma3_omp_parallel *)malloc(sizeof(pragma3_omp_parallel));
+new_ctx->i = i;
+new_ctx->n_ptr = &(n);
+new_ctx->a_ptr = &(a);
+new_ctx->s_ptr = &(s);
+hclib_loop_domain_t domain[1];
+const long ____low0 = 0;
+const long ____high0 = n;
+const long ____step0 = 1;
+const long ____niters0 = (____high0 > ____low0 ? (____high0 - ____low0 + ____step0 - 1) / ____step0 : 0);
+long ____chunk0;
+new_ctx->____step0 = ____step0;
+for (____chunk0 = 0; ____chunk0 < ____niters0; ____chunk0 += (1 << 30)) {
+new_ctx->____base0 = ____low0 + ____chunk0 * ____step0;
+new_ctx->____left0 = ____niters0 - ____chunk0;
+domain[0].low = 0;
+domain[0].high = (new_ctx->____left0 < (1 << 30) ? new_ctx->____left0 : (1 << 30));
+domain[0].stride = 1;
+domain[0].tile = -1;
+hclib_future_wait(hclib_forasync_future((void *)pragma3_omp_parallel_hclib_async, new_ctx, 1, domain, HCLIB_FORASYNC_MODE));
+}
+free(new_ctx);
+ } 
+} 
+static void pragma3_omp_parallel_hclib_async(void *____arg, const int ___iter0) {
+    pragma3_omp_parallel *ctx = (pragma3_omp_parallel *)____arg;
+    long i; i = ctx->i;
+    do {
+    i = ctx->____base0 + ___iter0 * ctx->____step0;
+{
+        (*(ctx->a_ptr))[i] = (*(ctx->a_ptr))[i] * (*(ctx->s_ptr));
+    } ;     } while (0);
+}
+
+
@@ -0,0 +1,10 @@
+void transpose(int n, int m, double *out, const double *in) {
+    int i;
+    int j;
+#pragma omp parallel for
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < m; j++) {
+            out[j * n + i] = in[i * m + j];
+        }
+    }
+}
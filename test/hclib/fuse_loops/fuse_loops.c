@@ -0,0 +1,14 @@
+double a[1024];
+double b[1024];
+
+void scale_add(int n, double s) {
+    int i;
+#pragma omp parallel for
+    for (i = 0; i < n; i++) {
+        a[i] = a[i] * s;
+    }
+#pragma omp parallel for
+    for (i = 0; i < n; i++) {
+        b[i] = b[i] + a[i];
+    }
+}
@@ -0,0 +1,20 @@
+int scale_all(int n, double *a) {
+    int i;
+#pragma omp parallel for lastprivate(i)
+    for (i = 0; i < n; i++) {
+        a[i] = 2.0 * a[i];
+    }
+    return i;
+}
+
+int scale_team(int n, double *a) {
+    int i;
+#pragma omp parallel
+    {
+#pragma omp for lastprivate(i)
+        for (i = 0; i < n; i++) {
+            a[i] = 2.0 * a[i];
+        }
+    }
+    return i;
+}
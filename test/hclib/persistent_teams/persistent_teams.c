@@ -0,0 +1,14 @@
+void relax(int n, int steps, double *a, double *b) {
+    int t = 0;
+    int i;
+    for (; t < steps; t++) {
+#pragma omp parallel for
+        for (i = 0; i < n; i++) {
+            b[i] = 2.0 * a[i];
+        }
+#pragma omp parallel for
+        for (i = 0; i < n; i++) {
+            a[i] = b[i] + 1.0;
+        }
+    }
+}
@@ -0,0 +1,7 @@
+void scale(int n, float *out, const double *in, double s) {
+    int i;
+#pragma omp parallel for
+    for (i = 0; i < n; i++) {
+        out[i] = in[i] * s;
+    }
+}
@@ -0,0 +1,12 @@
+void accumulate(int n, double *a, double *total) {
+    double s = 0.0;
+#pragma omp task shared(s)
+    {
+#pragma omp simd reduction(+:s) aligned(a:64)
+        for (int j = 0; j < n; j++) {
+            s += a[j];
+        }
+    }
+#pragma omp taskwait
+    *total = s;
+}
@@ -0,0 +1,10 @@
+#define A(m, n) (tiles[(m) * nt + (n)])
+
+void sweep(double **tiles, int nt, int k, int n) {
+    double *akk = A(k, k);
+    double *akn = A(k, n);
+#pragma omp task depend(inout:akk[0:1])
+    akk[0] = akk[0] * 2.0;
+#pragma omp task depend(in:akk[0:1]) depend(inout:akn[0:1])
+    akn[0] = akn[0] + akk[0];
+}
@@ -0,0 +1,6 @@
+void inc(int *x) {
+#pragma omp task firstprivate(x)
+    {
+        *x = *x + 1;
+    }
+}
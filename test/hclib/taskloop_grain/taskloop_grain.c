@@ -0,0 +1,15 @@
+void fill(int n, int *a, int *b, int *c) {
+    int i;
+#pragma omp taskloop grainsize(64)
+    for (i = 0; i < n; i++) {
+        a[i] = i;
+    }
+#pragma omp taskloop num_tasks(8)
+    for (i = 0; i < n; i++) {
+        b[i] = a[i];
+    }
+#pragma omp taskloop nogroup
+    for (i = 0; i < n; i++) {
+        c[i] = b[i];
+    }
+}
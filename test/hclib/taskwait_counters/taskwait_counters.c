@@ -0,0 +1,18 @@
+int fib(int n) {
+    int x, y;
+    if (n < 2) return n;
+#pragma omp task shared(x)
+    x = fib(n - 1);
+#pragma omp task shared(y)
+    y = fib(n - 2);
+#pragma omp taskwait
+    return x + y;
+}
+
+void set_twice(int *a) {
+#pragma omp task firstprivate(a)
+    *a = 1;
+#pragma omp taskwait
+#pragma omp task firstprivate(a)
+    *a = 2;
+}
@@ -0,0 +1,9 @@
+int omp_get_thread_num(void);
+int omp_get_num_threads(void);
+
+void count(int *sizes) {
+#pragma omp parallel
+    {
+        sizes[omp_get_thread_num()] = omp_get_num_threads();
+    }
+}
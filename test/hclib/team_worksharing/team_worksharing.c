@@ -0,0 +1,20 @@
+int sum(int n, int *a) {
+    int i;
+    int s = 0;
+#pragma omp parallel
+    {
+#pragma omp for reduction(+:s)
+        for (i = 0; i < n; i++) {
+            s += a[i];
+        }
+#pragma omp single
+        {
+            a[0] = s;
+        }
+#pragma omp master
+        {
+            a[1] = s;
+        }
+    }
+    return s;
+}
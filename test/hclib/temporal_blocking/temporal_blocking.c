@@ -0,0 +1,14 @@
+void jacobi(int n, int steps, double *a, double *b) {
+    int t;
+    int i;
+    double *tmp;
+    for (t = 0; t < steps; t++) {
+#pragma omp parallel for
+        for (i = 1; i < n - 1; i++) {
+            b[i] = (a[i - 1] + a[i] + a[i + 1]) / 3.0;
+        }
+        tmp = a;
+        a = b;
+        b = tmp;
+    }
+}
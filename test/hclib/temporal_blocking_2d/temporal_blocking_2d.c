@@ -0,0 +1,17 @@
+void jacobi(int rows, int cols, int steps, double *a, double *b) {
+    int t;
+    int i;
+    double *tmp;
+    for (t = 0; t < steps; t++) {
+#pragma omp parallel for
+        for (i = 1; i < rows - 1; i++) {
+            for (int j = 1; j < cols - 1; j++) {
+                b[i * cols + j] = (a[(i - 1) * cols + j] + a[(i + 1) * cols + j] +
+                        a[i * cols + j - 1] + a[i * cols + j + 1]) / 4.0;
+            }
+        }
+        tmp = a;
+        a = b;
+        b = tmp;
+    }
+}
@@ -0,0 +1,11 @@
+void sweep(int nb, double *m) {
+    int d;
+    int x;
+    for (d = 0; d < nb; d++) {
+#pragma omp parallel for
+        for (x = 0; x <= d; x++) {
+            int y = d - x;
+            m[y * nb + x] = m[y * nb + x] + 1.0;
+        }
+    }
+}
@@ -0,0 +1,7 @@
+void scale(long n, double *a, double s) {
+    long i;
+#pragma omp parallel for
+    for (i = 0; i < n; i++) {
+        a[i] = a[i] * s;
+    }
+}
@@ -42,17 +42,78 @@ function compare_outputs() {
     fi
 }
 
+function check_simd_loops() {
+    FILE=$1
+    TEST_OUTPUT=$2
+    COMPILE_FLAGS=$3
+
+    EXPECTED=$(grep -c '^\s*#pragma omp simd' $FILE || true)
+    if [[ $EXPECTED -eq 0 ]]; then
+        return
+    fi
+
+    # The line of the loop following each translated simd directive
+    LOOP_LINES=$(awk '/^#pragma omp simd/ { want = 1; next }
+                      want && !/^#/ { print NR; want = 0 }' $TEST_OUTPUT)
+    FOUND=$(echo $LOOP_LINES | wc -w)
+    if [[ $FOUND -ne $EXPECTED ]]; then
+        echo
+        echo Expected $EXPECTED simd loops in $TEST_OUTPUT but found $FOUND
+        exit 1
+    fi
+
+    if [[ $TEST_OUTPUT == *.cpp ]]; then
+        COMPILER=${CXX:-g++}
+    else
+        COMPILER=${CC:-gcc}
+    fi
+
+    set +e
+    $COMPILER -O3 -fopenmp-simd -DOMP_TO_HCLIB_OPENMP_SIMD \
+        -fopt-info-vec-optimized $COMPILE_FLAGS -I$HCLIB_ROOT/include \
+        -I$HCLIB_ROOT/../modules/system/inc -c $TEST_OUTPUT -o /dev/null \
+        &> $SCRIPT_DIR/vectorize.log
+    STATUS=$?
+    set -e
+    if [[ $STATUS -ne 0 ]]; then
+        echo
+        echo Failed compiling $TEST_OUTPUT to check vectorization
+        echo Compiler output is in $SCRIPT_DIR/vectorize.log
+        exit 1
+    fi
+
+    for LINE in $LOOP_LINES; do
+        if ! grep -q ":$LINE:[0-9]*: .*loop vectorized" $SCRIPT_DIR/vectorize.log; then
+            echo
+            echo simd loop at $TEST_OUTPUT:$LINE was not vectorized
+            echo Compiler output is in $SCRIPT_DIR/vectorize.log
+            exit 1
+        fi
+    done
+}
+
 mkdir -p $SCRIPT_DIR/test-output
 
 FILES=$(find $SCRIPT_DIR/cpp/ -name "*.cpp")
 FILES="$(find $SCRIPT_DIR/c/ -name "*.c") $FILES"
 
+# Inputs under hclib/ are only translated to HClib, with the optional code
+# generation features listed in the features file next to each of them.
+HCLIB_FILES=$(find $SCRIPT_DIR/hclib/ -name "*.c" -o -name "*.cpp" | sort)
+
 if [[ $# == 1 ]]; then
-    if [[ ! -f $1 ]]; then
+    if [[ $1 == --hclib ]]; then
+        FILES=
+    elif [[ ! -f $1 ]]; then
         echo Missing test file $1
         exit 1
+    elif [[ $(basename $(dirname $(dirname $1))) == hclib ]]; then
+        FILES=
+        HCLIB_FILES=$1
+    else
+        FILES=$1
+        HCLIB_FILES=
     fi
-    FILES=$1
 fi
 
 declare -A defines
@@ -82,6 +143,7 @@ for FILE in $FILES; do
     CUDA_CMD="$SCRIPT_DIR/../src/omp_to_hclib.sh -i $FILE -o $CUDA_OUTPUT -I $DIRNAME -v -l CUDA"
     TIME_BODY_CMD="$SCRIPT_DIR/../src/time_body.sh -i $FILE -o $TIME_BODY_OUTPUT -I $DIRNAME -v -f -p"
     BALANCE_CMD="$SCRIPT_DIR/../src/measure_load_balance.sh -i $FILE -o $BALANCE_OUTPUT -I $DIRNAME -v"
+    COMPILE_FLAGS="-I $DIRNAME"
     for P in "${!defines[@]}"; do
         if [[ "$(stat_file $P)" == "$(stat_file $FILE)" ]]; then
             for DEF in ${defines[$P]}; do
@@ -89,12 +151,14 @@ for FILE in $FILES; do
                 CUDA_CMD="$CUDA_CMD -D $DEF"
                 TIME_BODY_CMD="$TIME_BODY_CMD -D $DEF"
                 BALANCE_CMD="$BALANCE_CMD -D $DEF"
+                COMPILE_FLAGS="$COMPILE_FLAGS -D $DEF"
             done
         fi
     done
 
     $CMD &> transform.log
     compare_outputs $REFERENCE $FILE $TEST_OUTPUT
+    check_simd_loops $FILE $TEST_OUTPUT "$COMPILE_FLAGS"
 
     $CUDA_CMD &> transform.cuda.log
     compare_outputs $CUDA_REFERENCE $FILE $CUDA_OUTPUT
@@ -108,4 +172,28 @@ for FILE in $FILES; do
 #     rm $SCRIPT_DIR/delta transform.log
 done
 
+for FILE in $HCLIB_FILES; do
+    DIRNAME=$(dirname $FILE)
+    FILENAME=$(basename $FILE)
+    TESTNAME=$(basename $(dirname $FILE))
+
+    FEATURE_FLAGS=
+    if [[ -f $DIRNAME/features ]]; then
+        for FEATURE in $(cat $DIRNAME/features); do
+            FEATURE_FLAGS="$FEATURE_FLAGS -f $FEATURE"
+        done
+    fi
+
+    echo Running $TESTNAME \($FILE\)$FEATURE_FLAGS
+
+    TEST_OUTPUT=$SCRIPT_DIR/test-output/$TESTNAME.$FILENAME
+    REFERENCE=$(dirname $DIRNAME)-ref/$TESTNAME/$FILENAME
+
+    CMD="$SCRIPT_DIR/../src/omp_to_hclib.sh -i $FILE -o $TEST_OUTPUT -I $DIRNAME -v -l HCLIB $FEATURE_FLAGS"
+
+    $CMD &> transform.log
+    compare_outputs $REFERENCE $FILE $TEST_OUTPUT
+    check_simd_loops $FILE $TEST_OUTPUT "-I $DIRNAME"
+done
+
 echo 'Passed all tests!'